@@ -0,0 +1,319 @@
+// columnar capture benchmark
+// records a long fake session to csv and to the columnar format through the session logger, then compares
+// file size and the time to read it all, one metric, a ten minute window and the min/max of an hour
+#include "../include/columnfile.h"
+#include "../include/sessionlog.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// a fake session held in memory, nan where a metric had no value
+struct Session {
+    std::vector<std::string> columns;
+    std::vector<double> times;
+    std::vector<std::vector<float>> values; // [column][row]
+};
+
+// deterministic sensor-like values: integer percentages and clocks that hold steady for a while,
+// temperatures and power that wander, one metric the hardware never reports and one that drops out
+static Session fakeSession(std::size_t columns, int rateHz, double hours) {
+    Session session;
+    std::size_t rows = static_cast<std::size_t>(hours * 3600.0 * rateHz);
+    for (std::size_t c = 0; c < columns; c++)
+        session.columns.push_back("metric" + std::to_string(c));
+    session.values.assign(columns, std::vector<float>(rows));
+    session.times.resize(rows);
+
+    uint64_t seed = 12345;
+    auto next = [&seed]() {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<double>(seed >> 11) / 9007199254740992.0;
+    };
+
+    std::vector<double> state(columns, 50.0);
+    for (std::size_t r = 0; r < rows; r++) {
+        // sampling ticks land a little after the schedule
+        session.times[r] = static_cast<double>(r) / rateHz + next() * 0.0005;
+        for (std::size_t c = 0; c < columns; c++) {
+            double value;
+            switch (c % 8) {
+            case 0: // usage %, changes now and then
+                if (next() < 0.2)
+                    state[c] = std::clamp(state[c] + std::round((next() - 0.5) * 20.0), 0.0, 100.0);
+                value = state[c];
+                break;
+            case 1: // temperature, 0.1 degree steps
+                state[c] = std::clamp(state[c] + (next() - 0.5) * 0.4, 30.0, 95.0);
+                value = std::round(state[c] * 10.0) / 10.0;
+                break;
+            case 2: // power in watts with two decimals
+                state[c] = std::clamp(state[c] + (next() - 0.5) * 8.0, 10.0, 350.0);
+                value = std::round(state[c] * 100.0) / 100.0;
+                break;
+            case 3: // clock in mhz, steps between a few states
+                if (next() < 0.05)
+                    state[c] = 500.0 + 100.0 * std::floor(next() * 22.0);
+                value = state[c];
+                break;
+            case 4: // never reported
+                value = NAN;
+                break;
+            case 5: // fps, missing while no game is running
+                value = (r / (rateHz * 600)) % 3 == 0 ? NAN : std::round((120.0 + 20.0 * std::sin(r * 0.01) + next() * 5.0) * 100.0) / 100.0;
+                break;
+            case 6: // memory in mb, slowly growing
+                if (next() < 0.01)
+                    state[c] += 4.0;
+                value = 2000.0 + state[c];
+                break;
+            default: // fan rpm
+                state[c] = std::clamp(state[c] + (next() - 0.5) * 30.0, 0.0, 3000.0);
+                value = std::round(state[c]);
+                break;
+            }
+            session.values[c][r] = static_cast<float>(value);
+        }
+    }
+    return session;
+}
+
+static bool writeSession(const Session& session, const std::string& path, LogFormat format, std::size_t chunkRows, double& seconds) {
+    LogOptions options;
+    options.format = format;
+    options.sync = SyncPolicy::Never;
+    options.flushIntervalMs = 0;
+    options.blockBytes = 64 * 1024 * 1024; // appended unpaced, big blocks so no rows are dropped
+    options.chunkRows = chunkRows;
+
+    SessionLogger logger;
+    if (!logger.open(path, session.columns, options))
+        return false;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::optional<double>> row(session.columns.size());
+    for (std::size_t r = 0; r < session.times.size(); r++) {
+        for (std::size_t c = 0; c < row.size(); c++) {
+            float value = session.values[c][r];
+            row[c] = std::isnan(value) ? std::nullopt : std::optional<double>(value);
+        }
+        logger.append(session.times[r], row);
+    }
+    logger.close();
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return logger.getDroppedRows() == 0;
+}
+
+static uint64_t fileBytes(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        return 0;
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fclose(file);
+    return size > 0 ? static_cast<uint64_t>(size) : 0;
+}
+
+// what a csv reader does for the same query: read the whole file, parse the time of every row and
+// the wanted columns of the rows in range
+static bool readCsv(const std::string& path, double begin, double end, const std::vector<int>& columnIds, ColumnSlice& slice) {
+    slice.times.clear();
+    slice.values.assign(columnIds.size(), std::vector<float>());
+
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+    std::fseek(file, 0, SEEK_END);
+    std::vector<char> text(static_cast<std::size_t>(std::ftell(file)));
+    std::fseek(file, 0, SEEK_SET);
+    bool ok = std::fread(text.data(), 1, text.size(), file) == text.size();
+    std::fclose(file);
+    if (!ok)
+        return false;
+
+    int lastColumn = columnIds.empty() ? -1 : *std::max_element(columnIds.begin(), columnIds.end());
+    std::vector<float> fields(lastColumn + 1);
+    const char* p = static_cast<const char*>(std::memchr(text.data(), '\n', text.size())) + 1;
+    const char* textEnd = text.data() + text.size();
+    while (p < textEnd) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', textEnd - p));
+        if (!lineEnd)
+            lineEnd = textEnd;
+
+        double time = 0.0;
+        const char* field = std::from_chars(p, lineEnd, time).ptr;
+        if (time >= begin && time <= end) {
+            for (int c = 0; c <= lastColumn && field < lineEnd; c++) {
+                field++; // comma
+                double value = NAN;
+                const char* next = std::from_chars(field, lineEnd, value).ptr;
+                fields[c] = next == field ? NAN : static_cast<float>(value);
+                field = next;
+            }
+            slice.times.push_back(time);
+            for (std::size_t i = 0; i < columnIds.size(); i++)
+                slice.values[i].push_back(fields[columnIds[i]]);
+        }
+        p = lineEnd + 1;
+    }
+    return true;
+}
+
+static bool summarizeCsv(const std::string& path, int columnId, double begin, double end, float& min, float& max) {
+    ColumnSlice slice;
+    if (!readCsv(path, begin, end, { columnId }, slice))
+        return false;
+    bool found = false;
+    for (float value : slice.values[0]) {
+        if (std::isnan(value))
+            continue;
+        min = found ? std::min(min, value) : value;
+        max = found ? std::max(max, value) : value;
+        found = true;
+    }
+    return found;
+}
+
+// best of a few runs, the files are in the page cache after the first
+template <typename Fn>
+static double bestMs(int runs, Fn fn) {
+    double best = 1e30;
+    for (int i = 0; i < runs; i++) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+// columnar values must come back bit for bit, csv to its two decimals
+static uint64_t countMismatches(const Session& session, const ColumnSlice& slice, double tolerance) {
+    uint64_t mismatches = slice.times.size() == session.times.size() ? 0 : 1;
+    for (std::size_t c = 0; c < slice.values.size(); c++) {
+        for (std::size_t r = 0; r < slice.values[c].size() && r < session.times.size(); r++) {
+            float expected = session.values[c][r];
+            float actual = slice.values[c][r];
+            if (std::isnan(expected) != std::isnan(actual) || (!std::isnan(expected) && std::fabs(expected - actual) > tolerance))
+                mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+static void printUsage() {
+    std::cout << "usage: colbench [--hours H] [--rate HZ] [--columns N] [--chunk ROWS] [--dir PATH] [--quick]\n"
+        << "  --hours H      length of the fake session (default 8)\n"
+        << "  --rate HZ      sampling rate (default 1)\n"
+        << "  --columns N    metrics per row, up to 64 (default 16)\n"
+        << "  --chunk ROWS   rows per columnar chunk (default 1024)\n"
+        << "  --dir PATH     where the files are written (default .)\n"
+        << "  --quick        a 2 hour session\n";
+}
+
+int main(int argc, char** argv) {
+    double hours = 8.0;
+    int rateHz = 1;
+    std::size_t columns = 16;
+    std::size_t chunkRows = 1024;
+    std::string dir = ".";
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--hours") && i + 1 < argc)
+            hours = std::max(0.1, std::atof(argv[++i]));
+        else if (!std::strcmp(argv[i], "--rate") && i + 1 < argc)
+            rateHz = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--columns") && i + 1 < argc)
+            columns = std::clamp<std::size_t>(std::strtoull(argv[++i], nullptr, 10), 1, 64);
+        else if (!std::strcmp(argv[i], "--chunk") && i + 1 < argc)
+            chunkRows = std::max<std::size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        else if (!std::strcmp(argv[i], "--dir") && i + 1 < argc)
+            dir = argv[++i];
+        else if (!std::strcmp(argv[i], "--quick"))
+            hours = 2.0;
+        else {
+            printUsage();
+            return 2;
+        }
+    }
+
+    Session session = fakeSession(columns, rateHz, hours);
+    std::string csvPath = dir + "/colbench.csv";
+    std::string columnarPath = dir + "/colbench.emc";
+    double csvWriteSeconds = 0.0, columnarWriteSeconds = 0.0;
+    if (!writeSession(session, csvPath, LogFormat::CSV, chunkRows, csvWriteSeconds) ||
+        !writeSession(session, columnarPath, LogFormat::Columnar, chunkRows, columnarWriteSeconds)) {
+        std::cerr << "failed to write the session" << std::endl;
+        return 1;
+    }
+
+    uint64_t csvBytes = fileBytes(csvPath);
+    uint64_t columnarBytes = fileBytes(columnarPath);
+    std::printf("%zu rows x %zu metrics (%.1f h at %d hz), %zu rows per chunk\n", session.times.size(), columns, hours, rateHz, chunkRows);
+    std::printf("%-10s %12s %12s %10s\n", "", "csv", "columnar", "ratio");
+    std::printf("%-10s %12.2f %12.2f %9.1fx\n", "size_mb", csvBytes / 1048576.0, columnarBytes / 1048576.0, static_cast<double>(csvBytes) / columnarBytes);
+    std::printf("%-10s %12.1f %12.1f\n", "bytes_row", static_cast<double>(csvBytes) / session.times.size(), static_cast<double>(columnarBytes) / session.times.size());
+    std::printf("%-10s %12.1f %12.1f\n", "write_ms", csvWriteSeconds * 1000.0, columnarWriteSeconds * 1000.0);
+
+    ColumnFileReader reader;
+    if (!reader.open(columnarPath))
+        return 1;
+
+    std::vector<int> allColumns;
+    for (std::size_t c = 0; c < columns; c++)
+        allColumns.push_back(static_cast<int>(c));
+    double duration = session.times.back();
+    double middle = duration / 2.0;
+    int metric = 2 % static_cast<int>(columns);
+
+    // check both readers against the generated session before timing them
+    ColumnSlice csvSlice, columnarSlice;
+    readCsv(csvPath, 0.0, duration, allColumns, csvSlice);
+    reader.read(0.0, duration, allColumns, columnarSlice);
+    uint64_t csvMismatches = countMismatches(session, csvSlice, 0.006f);
+    uint64_t columnarMismatches = countMismatches(session, columnarSlice, 0.0f);
+
+    struct Query {
+        const char* name;
+        double begin;
+        double end;
+        std::vector<int> columnIds;
+    };
+    std::vector<Query> queries = {
+        { "all", 0.0, duration, allColumns },
+        { "1_metric", 0.0, duration, { metric } },
+        { "10_min", middle, middle + 600.0, { metric } },
+    };
+
+    std::printf("\n%-10s %12s %12s %10s %14s\n", "read", "csv_ms", "columnar_ms", "speedup", "columnar_mb_s");
+    for (const Query& query : queries) {
+        ColumnSlice slice;
+        double csvMs = bestMs(3, [&] { readCsv(csvPath, query.begin, query.end, query.columnIds, slice); });
+        double columnarMs = bestMs(3, [&] { reader.read(query.begin, query.end, query.columnIds, slice); });
+        // throughput in terms of the csv text the same rows and columns would take
+        double csvEquivalentMb = csvBytes / 1048576.0 * (slice.times.size() / static_cast<double>(session.times.size())) *
+            (query.columnIds.size() + 1) / (columns + 1);
+        std::printf("%-10s %12.3f %12.3f %9.1fx %14.0f\n", query.name, csvMs, columnarMs, csvMs / columnarMs, csvEquivalentMb / (columnarMs / 1000.0));
+    }
+
+    // the min and max of an hour, answered from chunk footers except at the edges
+    float csvMin = 0.f, csvMax = 0.f, columnarMin = 0.f, columnarMax = 0.f;
+    double hourEnd = std::min(duration, middle + 3600.0);
+    double csvMs = bestMs(3, [&] { summarizeCsv(csvPath, metric, middle, hourEnd, csvMin, csvMax); });
+    double columnarMs = bestMs(3, [&] { reader.summarize(metric, middle, hourEnd, columnarMin, columnarMax); });
+    std::printf("%-10s %12.3f %12.3f %9.1fx\n", "1h_minmax", csvMs, columnarMs, csvMs / columnarMs);
+    if (std::fabs(csvMin - columnarMin) > 0.006f || std::fabs(csvMax - columnarMax) > 0.006f)
+        columnarMismatches++;
+
+    std::printf("\nmismatches: csv %llu, columnar %llu, %zu chunks\n",
+        static_cast<unsigned long long>(csvMismatches), static_cast<unsigned long long>(columnarMismatches), reader.getChunks().size());
+    reader.close();
+
+    std::remove(csvPath.c_str());
+    std::remove(columnarPath.c_str());
+    return csvMismatches == 0 && columnarMismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,193 @@
+// prometheus exporter benchmark
+// serves fake samples published at the sampling rate and scrapes /metrics over loopback from several
+// kept alive client connections at once, reporting scrapes per second, scrape latency and render time
+#include "../include/metricsource.h"
+#include "../include/prometheusexporter.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+typedef SOCKET SocketHandle;
+#define closeSocket closesocket
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int SocketHandle;
+#define closeSocket ::close
+#endif
+
+// the core fake source without hotspot temperature and voltage, which many machines do not report
+const uint32_t unsupportedMetrics = (1u << 2) | (1u << 4);
+
+// one keep-alive client scraping as fast as it can, false on a protocol error
+static bool runClient(uint16_t port, std::chrono::steady_clock::time_point end, std::vector<double>& latencyUs) {
+    SocketHandle client = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    int noDelay = 1;
+    setsockopt(client, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        closeSocket(client);
+        return false;
+    }
+
+    const char request[] = "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    std::string response;
+    char buffer[16384];
+    bool ok = true;
+    while (ok && std::chrono::steady_clock::now() < end) {
+        auto start = std::chrono::steady_clock::now();
+        if (send(client, request, static_cast<int>(sizeof(request) - 1), 0) != static_cast<int>(sizeof(request) - 1)) {
+            ok = false;
+            break;
+        }
+
+        // headers, then exactly content-length bytes of body
+        response.clear();
+        std::size_t headerEnd = std::string::npos;
+        std::size_t total = 0;
+        while (total == 0 || response.size() < total) {
+            int received = static_cast<int>(recv(client, buffer, sizeof(buffer), 0));
+            if (received <= 0) {
+                ok = false;
+                break;
+            }
+            response.append(buffer, received);
+            if (headerEnd == std::string::npos && (headerEnd = response.find("\r\n\r\n")) != std::string::npos) {
+                std::size_t length = response.find("Content-Length: ");
+                if (response.compare(0, 15, "HTTP/1.1 200 OK") != 0 || length == std::string::npos) {
+                    ok = false;
+                    break;
+                }
+                total = headerEnd + 4 + std::strtoull(response.c_str() + length + 16, nullptr, 10);
+            }
+        }
+        if (ok && response.find("easymetrics_samples_total") == std::string::npos)
+            ok = false;
+        latencyUs.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    closeSocket(client);
+    return ok;
+}
+
+static void printUsage() {
+    std::cout << "usage: exporterbench [--clients N...] [--seconds S] [--rate HZ] [--port P]\n"
+        << "  --clients N...  concurrent scrapers, one run per count (default 1 8 32)\n"
+        << "  --seconds S     length of each run (default 3)\n"
+        << "  --rate HZ       how often a new sample is published (default 10)\n"
+        << "  --port P        loopback port (default 19464)\n";
+}
+
+int main(int argc, char** argv) {
+    std::vector<int> clientCounts;
+    double seconds = 3.0;
+    int rateHz = 10;
+    uint16_t port = 19464;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--clients")) {
+            while (i + 1 < argc && argv[i + 1][0] != '-')
+                clientCounts.push_back(std::max(1, std::atoi(argv[++i])));
+        }
+        else if (!std::strcmp(argv[i], "--seconds") && i + 1 < argc)
+            seconds = std::max(0.1, std::atof(argv[++i]));
+        else if (!std::strcmp(argv[i], "--rate") && i + 1 < argc)
+            rateHz = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--port") && i + 1 < argc)
+            port = static_cast<uint16_t>(std::atoi(argv[++i]));
+        else {
+            printUsage();
+            return 2;
+        }
+    }
+    if (clientCounts.empty())
+        clientCounts = { 1, 8, 32 };
+
+#if defined(_WIN32)
+    WSADATA data;
+    WSAStartup(MAKEWORD(2, 2), &data);
+#endif
+
+    // render cost of one body, what the sampler pays per sample
+    std::vector<std::optional<double>> values;
+    MetricSource renderSource = fakeMetricSource(1, unsupportedMetrics);
+    readMetricSample(renderSource, values);
+    const int renders = 10000;
+    std::size_t bodyBytes = 0;
+    auto renderStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < renders; i++)
+        bodyBytes += renderPrometheusBody(values, i).size();
+    double renderUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - renderStart).count() / renders;
+    std::printf("body %zu bytes, rendered in %.2f us\n\n", bodyBytes / renders, renderUs);
+
+    std::printf("%7s %12s %9s %9s %9s %7s\n", "clients", "scrapes_s", "p50_us", "p99_us", "max_us", "errors");
+    bool failed = false;
+    for (int clients : clientCounts) {
+        PrometheusExporter exporter;
+        if (!exporter.start(port))
+            return 1;
+
+        auto start = std::chrono::steady_clock::now();
+        auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+
+        // the sampler side, a new body every tick
+        std::thread publisher([&] {
+            std::vector<std::optional<double>> sample;
+            MetricSource source = fakeMetricSource(1, unsupportedMetrics);
+            auto next = start;
+            for (uint64_t tick = 1; std::chrono::steady_clock::now() < end; tick++) {
+                readMetricSample(source, sample);
+                exporter.publish(sample, tick);
+                next += std::chrono::microseconds(1000000 / rateHz);
+                std::this_thread::sleep_until(next);
+            }
+        });
+
+        std::mutex resultMutex;
+        std::vector<double> latencyUs;
+        std::atomic<int> errors = 0;
+        std::vector<std::thread> threads;
+        for (int c = 0; c < clients; c++) {
+            threads.emplace_back([&] {
+                std::vector<double> own;
+                if (!runClient(port, end, own))
+                    errors++;
+                std::lock_guard<std::mutex> lock(resultMutex);
+                latencyUs.insert(latencyUs.end(), own.begin(), own.end());
+            });
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+        publisher.join();
+        exporter.stop();
+
+        std::sort(latencyUs.begin(), latencyUs.end());
+        if (latencyUs.empty())
+            latencyUs.push_back(0.0);
+        std::printf("%7d %12.0f %9.1f %9.1f %9.1f %7d\n", clients, exporter.getScrapeCount() / seconds,
+            latencyUs[latencyUs.size() / 2], latencyUs[std::min(latencyUs.size() - 1, latencyUs.size() * 99 / 100)], latencyUs.back(), errors.load());
+        if (errors > 0)
+            failed = true;
+    }
+
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,213 @@
+// level-of-detail query benchmark
+// fills a LodSeries with a synthetic sensor trace and times min/max queries at the full range and at random
+// zoom levels, so the O(pixels * log n) claim can be checked at 1M, 10M and 100M points.
+// --capacity bounds the series the way the sampler's history is, queries then cover what is kept
+#include "../include/lodseries.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+// results for one series length
+struct BenchResult {
+    double appendNsPerPoint;
+    double memoryMB;
+    double fullRangeUs; // whole series at the plot width
+    double zoomP50Us; // random windows at the plot width
+    double zoomP99Us;
+};
+
+// deterministic trace that wanders like a real sensor, with an occasional gap
+static float fakeSample(std::size_t i, std::mt19937& rng) {
+    if (i % 100000 == 99999)
+        return NAN;
+    std::uniform_real_distribution<float> noise(-2.f, 2.f);
+    return 50.f + 30.f * std::sin(i * 0.001f) + 10.f * std::sin(i * 0.0000123f) + noise(rng);
+}
+
+// what LodSeries::query promises, by scanning every sample, for --verify: ranges of up to two points per
+// bucket copied as is, longer ones the min and max of each bucket
+static void bruteForce(const LodSeries& series, std::size_t begin, std::size_t end, std::size_t buckets, std::vector<float>& points) {
+    points.clear();
+    std::size_t count = end - begin;
+    if (count <= buckets * 2) {
+        for (std::size_t i = begin; i < end; i++)
+            points.push_back(series.at(i));
+        buckets = 0;
+    }
+    for (std::size_t b = 0; b < buckets; b++) {
+        float min = NAN, max = NAN;
+        std::size_t minAt = 0, maxAt = 0;
+        for (std::size_t i = begin + b * count / buckets; i < begin + (b + 1) * count / buckets; i++) {
+            float v = series.at(i);
+            if (std::isnan(v))
+                continue;
+            if (std::isnan(min) || v < min) {
+                min = v;
+                minAt = i;
+            }
+            if (std::isnan(max) || v > max) {
+                max = v;
+                maxAt = i;
+            }
+        }
+        points.push_back(minAt <= maxAt ? min : max);
+        points.push_back(minAt <= maxAt ? max : min);
+    }
+
+    // gaps take the value before them, leading gaps the first value, no values at all gives no points
+    auto firstValue = std::find_if(points.begin(), points.end(), [](float v) { return !std::isnan(v); });
+    if (firstValue == points.end()) {
+        points.clear();
+        return;
+    }
+    float last = *firstValue;
+    for (float& point : points) {
+        if (std::isnan(point))
+            point = last;
+        last = point;
+    }
+}
+
+static bool samePoints(const std::vector<float>& a, const std::vector<float>& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](float x, float y) { return x == y || (std::isnan(x) && std::isnan(y)); });
+}
+
+static double elapsedUs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+static BenchResult runSize(std::size_t points, std::size_t pixels, std::size_t capacity, int queries, bool verify, bool& mismatch) {
+    std::mt19937 rng(12345);
+    LodSeries series(capacity);
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < points; i++)
+        series.push(fakeSample(i, rng));
+    double appendUs = elapsedUs(start);
+
+    BenchResult result;
+    result.appendNsPerPoint = appendUs * 1000.0 / points;
+    result.memoryMB = series.memoryUsage() / (1024.0 * 1024.0);
+
+    std::vector<float> plot;
+    plot.reserve(pixels * 2);
+
+    // whole series, best of a few runs
+    std::size_t oldest = series.oldest();
+    std::size_t kept = points - oldest;
+    result.fullRangeUs = 1e30;
+    for (int r = 0; r < 5; r++) {
+        start = std::chrono::steady_clock::now();
+        series.query(oldest, points, pixels, plot);
+        result.fullRangeUs = std::min(result.fullRangeUs, elapsedUs(start));
+    }
+
+    // random zoom windows from a few thousand samples up to the whole series
+    std::vector<double> zoomUs;
+    zoomUs.reserve(queries);
+    std::vector<float> expected;
+    double logMin = std::log(static_cast<double>(pixels * 4));
+    double logMax = std::log(static_cast<double>(kept));
+    std::uniform_real_distribution<double> logLength(std::min(logMin, logMax), logMax);
+    for (int q = 0; q < queries; q++) {
+        std::size_t length = std::min(kept, static_cast<std::size_t>(std::exp(logLength(rng))));
+        std::size_t begin = std::uniform_int_distribution<std::size_t>(oldest, points - length)(rng);
+
+        start = std::chrono::steady_clock::now();
+        series.query(begin, begin + length, pixels, plot);
+        zoomUs.push_back(elapsedUs(start));
+
+        if (verify && q < 20) {
+            bruteForce(series, begin, begin + length, pixels, expected);
+            if (!samePoints(plot, expected))
+                mismatch = true;
+        }
+    }
+
+    // the random windows are mostly longer than the plot, also check the ones short enough to be copied as is,
+    // either side of that boundary, and a window that starts and one that ends in a gap
+    if (verify) {
+        std::vector<std::pair<std::size_t, std::size_t>> windows;
+        for (std::size_t length : { std::size_t(1), pixels / 2, pixels * 2, pixels * 2 + 1, pixels * 8 })
+            windows.emplace_back(points - std::min(kept, std::max<std::size_t>(1, length)), points);
+
+        // fakeSample leaves a gap every 100000 samples
+        std::size_t lastGap = points / 100000 * 100000 - 1;
+        if (points >= 100000 && lastGap >= oldest) {
+            windows.emplace_back(lastGap, std::min<std::size_t>(points, lastGap + pixels));
+            windows.emplace_back(std::max(oldest, lastGap + 1 - std::min<std::size_t>(lastGap + 1 - oldest, pixels)), lastGap + 1);
+        }
+        for (const auto& [begin, end] : windows) {
+            series.query(begin, end, pixels, plot);
+            bruteForce(series, begin, end, pixels, expected);
+            if (!samePoints(plot, expected))
+                mismatch = true;
+        }
+    }
+    std::sort(zoomUs.begin(), zoomUs.end());
+    result.zoomP50Us = zoomUs[zoomUs.size() / 2];
+    result.zoomP99Us = zoomUs[std::min(zoomUs.size() - 1, zoomUs.size() * 99 / 100)];
+    return result;
+}
+
+static void printUsage() {
+    std::cout << "usage: lodbench [--points N]... [--pixels P] [--capacity N] [--queries Q] [--verify] [--quick]\n"
+        << "  --points N   series length, repeatable (default 1M, 10M and 100M)\n"
+        << "  --pixels P   plot width in buckets (default 1920)\n"
+        << "  --capacity N keep only the newest N points, 0 (default) keeps all\n"
+        << "  --queries Q  random zoom queries per length (default 2000)\n"
+        << "  --verify     compare the first queries of each length against a full scan\n"
+        << "  --quick      only 1M and 10M points\n";
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::size_t> sizes;
+    std::size_t pixels = 1920;
+    std::size_t capacity = 0;
+    int queries = 2000;
+    bool verify = false;
+    bool quick = false;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--points") && i + 1 < argc)
+            sizes.push_back(std::max<std::size_t>(1, std::strtoull(argv[++i], nullptr, 10)));
+        else if (!std::strcmp(argv[i], "--pixels") && i + 1 < argc)
+            pixels = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--capacity") && i + 1 < argc)
+            capacity = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--queries") && i + 1 < argc)
+            queries = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--verify"))
+            verify = true;
+        else if (!std::strcmp(argv[i], "--quick"))
+            quick = true;
+        else {
+            printUsage();
+            return 2;
+        }
+    }
+    if (sizes.empty())
+        sizes = quick ? std::vector<std::size_t>{ 1000000, 10000000 } : std::vector<std::size_t>{ 1000000, 10000000, 100000000 };
+
+    std::printf("%11s %7s %10s %9s %11s %10s %10s\n",
+        "points", "pixels", "append_ns", "mem_mb", "full_us", "zoom_p50", "zoom_p99");
+
+    bool mismatch = false;
+    for (std::size_t points : sizes) {
+        BenchResult r = runSize(points, pixels, capacity, queries, verify, mismatch);
+        std::printf("%11zu %7zu %10.2f %9.1f %11.1f %10.1f %10.1f\n",
+            points, pixels, r.appendNsPerPoint, r.memoryMB, r.fullRangeUs, r.zoomP50Us, r.zoomP99Us);
+    }
+
+    if (mismatch) {
+        std::cerr << "query results differ from a full scan" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,149 @@
+// session logger benchmark
+// runs a fake sampling loop at a fixed rate and measures tick latency with logging off, to csv, binary and columnar,
+// then appends unpaced to find the sustained throughput of each format
+#include "../include/metricsource.h"
+#include "../include/sessionlog.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class Mode { Off, CSV, Binary, Columnar };
+
+// results for one configuration
+struct BenchResult {
+    double p50Us;
+    double p99Us;
+    double maxUs;
+    double rowsPerSecond;
+    double megabytes;
+    uint64_t dropped;
+};
+
+static const char* modeName(Mode mode) {
+    const char* names[] = { "off", "csv", "binary", "columnar" };
+    return names[static_cast<int>(mode)];
+}
+
+// the core fake source without hotspot temperature and voltage, which many machines do not report
+const uint32_t unsupportedMetrics = (1u << 2) | (1u << 4);
+
+// one fake sample spread over every column, the 16 metrics repeated for wider rows
+static void readRow(MetricSource& source, std::vector<std::optional<double>>& sample, std::vector<std::optional<double>>& values) {
+    readMetricSample(source, sample);
+    for (std::size_t i = 0; i < values.size(); i++)
+        values[i] = sample[i % sample.size()];
+}
+
+static BenchResult runConfig(Mode mode, std::size_t columns, int rateHz, double seconds, uint64_t rows,
+    SyncPolicy sync, const std::string& dir) {
+    std::vector<std::string> names;
+    for (std::size_t i = 0; i < columns; i++)
+        names.push_back("metric" + std::to_string(i));
+
+    std::string path = dir + "/logbench." + modeName(mode);
+    SessionLogger logger;
+    if (mode != Mode::Off) {
+        LogOptions options;
+        options.format = static_cast<LogFormat>(static_cast<int>(mode) - 1);
+        options.sync = sync;
+        if (!logger.open(path, names, options))
+            std::exit(1);
+    }
+
+    MetricSource source = fakeMetricSource(1, unsupportedMetrics);
+    std::vector<std::optional<double>> sample;
+    std::vector<std::optional<double>> values(columns);
+    std::vector<double> tickUs;
+    bool paced = rateHz > 0;
+    uint64_t total = paced ? static_cast<uint64_t>(seconds * rateHz) : rows;
+    tickUs.reserve(total);
+
+    auto start = std::chrono::steady_clock::now();
+    auto next = start;
+    for (uint64_t tick = 0; tick < total; tick++) {
+        auto tickStart = std::chrono::steady_clock::now();
+        readRow(source, sample, values);
+        if (mode != Mode::Off)
+            logger.append(std::chrono::duration<double>(tickStart - start).count(), values);
+        tickUs.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - tickStart).count());
+
+        if (paced) {
+            next += std::chrono::microseconds(1000000 / rateHz);
+            std::this_thread::sleep_until(next);
+        }
+    }
+    logger.close();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::sort(tickUs.begin(), tickUs.end());
+    BenchResult result;
+    result.p50Us = tickUs[tickUs.size() / 2];
+    result.p99Us = tickUs[std::min(tickUs.size() - 1, tickUs.size() * 99 / 100)];
+    result.maxUs = tickUs.back();
+    result.rowsPerSecond = total / elapsed;
+    result.megabytes = logger.getBytesWritten() / (1024.0 * 1024.0);
+    result.dropped = logger.getDroppedRows();
+
+    if (mode != Mode::Off)
+        std::remove(path.c_str());
+    return result;
+}
+
+static void printUsage() {
+    std::cout << "usage: logbench [--rate HZ] [--seconds S] [--rows N] [--sync never|close|block] [--dir PATH] [--quick]\n"
+        << "  --rate HZ     sampling rate of the paced run (default 10)\n"
+        << "  --seconds S   length of each paced run (default 5)\n"
+        << "  --rows N      rows appended by each unpaced throughput run (default 1000000)\n"
+        << "  --sync        fsync policy (default close)\n"
+        << "  --dir PATH    where the files are written (default .)\n"
+        << "  --quick       1 second paced runs and 100000 unpaced rows\n";
+}
+
+int main(int argc, char** argv) {
+    int rateHz = 10;
+    double seconds = 5.0;
+    uint64_t rows = 1000000;
+    SyncPolicy sync = SyncPolicy::OnClose;
+    std::string dir = ".";
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--rate") && i + 1 < argc)
+            rateHz = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--seconds") && i + 1 < argc)
+            seconds = std::max(0.1, std::atof(argv[++i]));
+        else if (!std::strcmp(argv[i], "--rows") && i + 1 < argc)
+            rows = std::max<uint64_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        else if (!std::strcmp(argv[i], "--sync") && i + 1 < argc) {
+            std::string policy = argv[++i];
+            sync = policy == "never" ? SyncPolicy::Never : policy == "block" ? SyncPolicy::EveryBlock : SyncPolicy::OnClose;
+        }
+        else if (!std::strcmp(argv[i], "--dir") && i + 1 < argc)
+            dir = argv[++i];
+        else if (!std::strcmp(argv[i], "--quick")) {
+            seconds = 1.0;
+            rows = 100000;
+        }
+        else {
+            printUsage();
+            return 2;
+        }
+    }
+
+    std::printf("%-8s %8s %7s %9s %9s %9s %12s %9s %8s\n",
+        "run", "format", "metrics", "p50_us", "p99_us", "max_us", "rows_per_s", "mb", "dropped");
+
+    for (int paced : { 1, 0 })
+        for (std::size_t columns : { 16, 64 })
+            for (Mode mode : { Mode::Off, Mode::CSV, Mode::Binary, Mode::Columnar }) {
+                BenchResult r = runConfig(mode, columns, paced ? rateHz : 0, seconds, rows, sync, dir);
+                std::printf("%-8s %8s %7zu %9.2f %9.2f %9.2f %12.0f %9.2f %8llu\n",
+                    paced ? (std::to_string(rateHz) + "hz").c_str() : "unpaced", modeName(mode), columns,
+                    r.p50Us, r.p99Us, r.maxUs, r.rowsPerSecond, r.megabytes, static_cast<unsigned long long>(r.dropped));
+            }
+    return 0;
+}
@@ -0,0 +1,632 @@
+// microbenchmarks for the per-tick sampling and formatting hot paths
+// the adlx pattern (services re-acquired every tick, an IsSupported check before every value, getters
+// called through std::function) runs against a fake adlx stand-in so it needs no windows or amd gpu.
+// results go out as json and can be compared against a saved baseline to catch regressions between releases
+#include "../include/driverlatency.h"
+#include "../include/metricformat.h"
+#include "../include/metricsource.h"
+#include "../include/overlaylayout.h"
+#include "../include/selfcost.h"
+#include "../include/tracing.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#if defined(EASYMETRICS_BENCH_SFML)
+#include <SFML/Graphics.hpp>
+#include "../include/inter.h"
+#endif
+
+// keeps results alive so the optimizer cannot drop the work being timed
+static volatile double sink = 0.0;
+
+#pragma region Fake ADLX
+
+// stand-in for the adlx interfaces the sampler touches: every call is virtual, every interface handed out
+// is reference counted through a smart pointer like adlx::InterfacePtr_T, and GetCurrentAllMetrics builds
+// a fresh snapshot object each time like the driver does
+struct FakeInterface {
+    virtual ~FakeInterface() = default;
+    virtual long Acquire() { return ++references; }
+    virtual long Release() {
+        long left = --references;
+        if (left == 0)
+            delete this;
+        return left;
+    }
+    std::atomic<long> references = 1;
+};
+
+template <typename T>
+class FakePtr {
+public:
+    FakePtr() = default;
+    FakePtr(const FakePtr& other) : object(other.object) { if (object) object->Acquire(); }
+    FakePtr& operator=(const FakePtr& other) {
+        if (other.object)
+            other.object->Acquire();
+        reset();
+        object = other.object;
+        return *this;
+    }
+    ~FakePtr() { reset(); }
+
+    // take over a new reference, as the adlx out parameters do
+    void attach(T* newObject) {
+        reset();
+        object = newObject;
+    }
+    void reset() {
+        if (object)
+            object->Release();
+        object = nullptr;
+    }
+    T* operator->() const { return object; }
+    explicit operator bool() const { return object != nullptr; }
+
+private:
+    T* object = nullptr;
+};
+
+const int fakeMetricCount = 16;
+
+struct FakeMetricsSupport : FakeInterface {
+    virtual int IsSupported(int metric, bool* supported) {
+        *supported = metric != 2 && metric != 4;
+        return 0;
+    }
+};
+
+struct FakeMetrics : FakeInterface {
+    double values[fakeMetricCount];
+    explicit FakeMetrics(uint64_t tick) {
+        for (int i = 0; i < fakeMetricCount; i++)
+            values[i] = 50.0 + 40.0 * std::sin(tick * 0.05 + i);
+    }
+    virtual int Value(int metric, double* value) {
+        *value = values[metric];
+        return 0;
+    }
+};
+
+struct FakeAllMetrics : FakeInterface {
+    uint64_t tick;
+    explicit FakeAllMetrics(uint64_t t) : tick(t) {}
+    virtual int GetGPUMetrics(FakePtr<FakeMetrics>* metrics) {
+        metrics->attach(new FakeMetrics(tick));
+        return 0;
+    }
+    virtual int GetSystemMetrics(FakePtr<FakeMetrics>* metrics) {
+        metrics->attach(new FakeMetrics(tick + 1));
+        return 0;
+    }
+};
+
+struct FakeGPU : FakeInterface {};
+
+struct FakeGPUList : FakeInterface {
+    FakeGPU* gpu = new FakeGPU();
+    ~FakeGPUList() override { gpu->Release(); }
+    virtual int At(int, FakePtr<FakeGPU>* out) {
+        gpu->Acquire();
+        out->attach(gpu);
+        return 0;
+    }
+};
+
+struct FakePerformanceServices : FakeInterface {
+    uint64_t tick = 0;
+    virtual int GetSupportedGPUMetrics(const FakePtr<FakeGPU>&, FakePtr<FakeMetricsSupport>* out) {
+        out->attach(new FakeMetricsSupport());
+        return 0;
+    }
+    virtual int GetSupportedSystemMetrics(FakePtr<FakeMetricsSupport>* out) {
+        out->attach(new FakeMetricsSupport());
+        return 0;
+    }
+    virtual int GetCurrentAllMetrics(FakePtr<FakeAllMetrics>* out) {
+        out->attach(new FakeAllMetrics(tick++));
+        return 0;
+    }
+};
+
+struct FakeSystemServices : FakeInterface {
+    FakePerformanceServices* performance = new FakePerformanceServices();
+    ~FakeSystemServices() override { performance->Release(); }
+    virtual int GetPerformanceMonitoringServices(FakePtr<FakePerformanceServices>* out) {
+        performance->Acquire();
+        out->attach(performance);
+        return 0;
+    }
+    virtual int GetGPUs(FakePtr<FakeGPUList>* out) {
+        out->attach(new FakeGPUList());
+        return 0;
+    }
+};
+
+// the same globals performancemonitor.cpp keeps
+static FakeSystemServices* systemServices = new FakeSystemServices();
+static FakePtr<FakePerformanceServices> perfMonitoringService;
+static FakePtr<FakeGPU> oneGPU;
+static FakePtr<FakeMetricsSupport> gpuMetricsSupport;
+static FakePtr<FakeMetricsSupport> systemMetricsSupport;
+static FakePtr<FakeAllMetrics> allMetrics;
+static FakePtr<FakeMetrics> gpuMetrics;
+static FakePtr<FakeMetrics> systemMetrics;
+
+// what setupServices() does every tick: services, gpu list, first gpu, support, then a new snapshot
+static void fakeSetupServices() {
+    systemServices->GetPerformanceMonitoringServices(&perfMonitoringService);
+    FakePtr<FakeGPUList> gpus;
+    systemServices->GetGPUs(&gpus);
+    gpus->At(0, &oneGPU);
+    perfMonitoringService->GetSupportedSystemMetrics(&systemMetricsSupport);
+    perfMonitoringService->GetSupportedGPUMetrics(oneGPU, &gpuMetricsSupport);
+    perfMonitoringService->GetCurrentAllMetrics(&allMetrics);
+    allMetrics->GetGPUMetrics(&gpuMetrics);
+    allMetrics->GetSystemMetrics(&systemMetrics);
+}
+
+// what each getter does: ask whether the metric is supported, then fetch it
+static std::optional<double> fakeGetter(int metric) {
+    bool supported = false;
+    const FakePtr<FakeMetricsSupport>& support = metric < 9 ? gpuMetricsSupport : systemMetricsSupport;
+    if (support->IsSupported(metric, &supported) != 0 || !supported)
+        return std::nullopt;
+    double value = 0.0;
+    const FakePtr<FakeMetrics>& source = metric < 9 ? gpuMetrics : systemMetrics;
+    if (source->Value(metric, &value) != 0)
+        return std::nullopt;
+    return value;
+}
+
+template <int Metric>
+static std::optional<double> fakeGetterFor() {
+    return fakeGetter(Metric);
+}
+
+// the sampler's table of getters, one std::function per metric
+static const std::vector<std::function<std::optional<double>()>> fakeGetters = {
+    fakeGetterFor<0>, fakeGetterFor<1>, fakeGetterFor<2>, fakeGetterFor<3>,
+    fakeGetterFor<4>, fakeGetterFor<5>, fakeGetterFor<6>, fakeGetterFor<7>,
+    fakeGetterFor<8>, fakeGetterFor<9>, fakeGetterFor<10>, fakeGetterFor<11>,
+    fakeGetterFor<12>, fakeGetterFor<13>, fakeGetterFor<14>, fakeGetterFor<15>
+};
+
+typedef std::optional<double> (*GetterFunction)();
+static const GetterFunction fakeGetterPointers[fakeMetricCount] = {
+    fakeGetterFor<0>, fakeGetterFor<1>, fakeGetterFor<2>, fakeGetterFor<3>,
+    fakeGetterFor<4>, fakeGetterFor<5>, fakeGetterFor<6>, fakeGetterFor<7>,
+    fakeGetterFor<8>, fakeGetterFor<9>, fakeGetterFor<10>, fakeGetterFor<11>,
+    fakeGetterFor<12>, fakeGetterFor<13>, fakeGetterFor<14>, fakeGetterFor<15>
+};
+
+#pragma endregion
+
+#pragma region Harness
+
+struct CaseResult {
+    std::string name;
+    double nsPerOp = 0.0; // median of the repetitions
+    double nsMin = 0.0; // fastest and slowest repetition, the spread the baseline compare allows for
+    double nsMax = 0.0;
+    double allocationsPerOp = 0.0;
+    uint64_t iterations = 0; // per repetition
+};
+
+struct BenchCase {
+    const char* name;
+    const char* description;
+    std::function<void()> operation; // one op, timed in a loop
+};
+
+// run one case: calibrate to about targetMs per repetition, then take the median of several
+static CaseResult runCase(const BenchCase& benchCase, double targetMs, int repetitions) {
+    uint64_t iterations = 1;
+    while (true) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; i++)
+            benchCase.operation();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (ms >= targetMs / 4 || iterations >= (1ull << 32))
+            break;
+        iterations *= 2;
+    }
+    iterations *= 4;
+
+    std::vector<double> nsPerOp;
+    uint64_t allocationsBefore = getAllocationCount();
+    for (int r = 0; r < repetitions; r++) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; i++)
+            benchCase.operation();
+        nsPerOp.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations);
+    }
+    uint64_t allocations = getAllocationCount() - allocationsBefore;
+
+    std::sort(nsPerOp.begin(), nsPerOp.end());
+    CaseResult result;
+    result.name = benchCase.name;
+    result.nsPerOp = nsPerOp[nsPerOp.size() / 2];
+    result.nsMin = nsPerOp.front();
+    result.nsMax = nsPerOp.back();
+    result.allocationsPerOp = static_cast<double>(allocations) / (static_cast<double>(iterations) * repetitions);
+    result.iterations = iterations;
+    return result;
+}
+
+static std::string resultsToJson(const std::vector<CaseResult>& results) {
+    std::string json = "{\n  \"benchmark\": \"microbench\",\n  \"unit\": \"ns\",\n  \"cases\": [\n";
+    char line[512];
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const CaseResult& r = results[i];
+        std::snprintf(line, sizeof(line), "    { \"name\": \"%s\", \"ns_per_op\": %.2f, \"ns_min\": %.2f, \"ns_max\": %.2f, \"allocations_per_op\": %.3f, \"iterations\": %llu }%s\n",
+            r.name.c_str(), r.nsPerOp, r.nsMin, r.nsMax, r.allocationsPerOp, static_cast<unsigned long long>(r.iterations), i + 1 < results.size() ? "," : "");
+        json += line;
+    }
+    json += "  ]\n}\n";
+    return json;
+}
+
+static std::FILE* openFile(const std::string& path, const char* mode) {
+    std::FILE* file = nullptr;
+#if defined(_WIN32)
+    if (fopen_s(&file, path.c_str(), mode) != 0)
+        file = nullptr;
+#else
+    file = std::fopen(path.c_str(), mode);
+#endif
+    return file;
+}
+
+// the number after "key": in the case starting at, 0 if the case has none
+static double readCaseField(const std::string& text, std::size_t at, const char* key) {
+    std::size_t caseEnd = text.find('}', at);
+    std::size_t field = text.find(key, at);
+    if (field == std::string::npos || field > caseEnd)
+        return 0.0;
+    return std::strtod(text.c_str() + field + std::strlen(key), nullptr);
+}
+
+// name, median and spread of every case in a json file written by resultsToJson
+static bool readBaseline(const std::string& path, std::vector<CaseResult>& baseline) {
+    std::FILE* file = openFile(path, "rb");
+    if (!file)
+        return false;
+    std::string text;
+    char buffer[4096];
+    std::size_t bytes;
+    while ((bytes = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+        text.append(buffer, bytes);
+    std::fclose(file);
+
+    std::size_t at = 0;
+    while ((at = text.find("\"name\": \"", at)) != std::string::npos) {
+        at += 9;
+        std::size_t end = text.find('"', at);
+        if (end == std::string::npos)
+            break;
+        CaseResult r;
+        r.name = text.substr(at, end - at);
+        r.nsPerOp = readCaseField(text, end, "\"ns_per_op\": ");
+        r.nsMin = readCaseField(text, end, "\"ns_min\": ");
+        r.nsMax = readCaseField(text, end, "\"ns_max\": ");
+        r.allocationsPerOp = readCaseField(text, end, "\"allocations_per_op\": ");
+        r.iterations = static_cast<uint64_t>(readCaseField(text, end, "\"iterations\": "));
+        baseline.push_back(r);
+        at = end;
+    }
+    return !baseline.empty();
+}
+
+static bool writeFile(const std::string& path, const std::string& text) {
+    std::FILE* file = openFile(path, "wb");
+    if (!file)
+        return false;
+    bool ok = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+#pragma endregion
+
+#pragma region Cases
+
+// sixteen wandering values like one sample
+static std::vector<std::optional<double>> benchValues(uint64_t tick) {
+    std::vector<std::optional<double>> values(fakeMetricCount);
+    for (int i = 0; i < fakeMetricCount; i++)
+        values[i] = 40.0 + 2000.0 * std::abs(std::sin(tick * 0.01 + i)) / (1 + i);
+    return values;
+}
+
+static std::vector<BenchCase> buildCases() {
+    std::vector<BenchCase> cases;
+    fakeSetupServices();
+
+    // acquisition, the adlx pattern
+    cases.push_back({ "adlx_tick", "setupServices() then every std::function getter with its IsSupported check", [] {
+        fakeSetupServices();
+        double total = 0.0;
+        for (const auto& getter : fakeGetters)
+            total += getter().value_or(0.0);
+        sink = total;
+    } });
+    cases.push_back({ "adlx_setup_services", "services, gpu, support and a new metrics snapshot re-acquired", [] {
+        fakeSetupServices();
+    } });
+    cases.push_back({ "getters_std_function", "16 getters through std::function, IsSupported included", [] {
+        double total = 0.0;
+        for (const auto& getter : fakeGetters)
+            total += getter().value_or(0.0);
+        sink = total;
+    } });
+    cases.push_back({ "getters_function_pointer", "the same 16 getters through plain function pointers", [] {
+        double total = 0.0;
+        for (GetterFunction getter : fakeGetterPointers)
+            total += getter().value_or(0.0);
+        sink = total;
+    } });
+    cases.push_back({ "is_supported_checks", "16 IsSupported calls alone", [] {
+        int supported = 0;
+        for (int i = 0; i < fakeMetricCount; i++) {
+            bool s = false;
+            (i < 9 ? gpuMetricsSupport : systemMetricsSupport)->IsSupported(i, &s);
+            supported += s;
+        }
+        sink = supported;
+    } });
+
+    // acquisition, the portable sampler path
+    static MetricSource fake = fakeMetricSource(1);
+    cases.push_back({ "core_fake_source_tick", "beginSample and every getter of the core fake source", [] {
+        fake.beginSample();
+        double total = 0.0;
+        for (const auto& getter : fake.getters)
+            total += getter().value_or(0.0);
+        sink = total;
+    } });
+
+    // formatting
+    static std::vector<std::optional<double>> values = benchValues(7);
+    cases.push_back({ "format_to_string_lround", "std::to_string(std::lround(v)) plus unit for 16 values", [] {
+        std::size_t length = 0;
+        for (int i = 0; i < fakeMetricCount; i++) {
+            std::string text = std::to_string(std::lround(values[i].value())) + " MHz";
+            length += text.size();
+        }
+        sink = static_cast<double>(length);
+    } });
+    cases.push_back({ "format_metric_value", "formatMetricValue for 16 metrics", [] {
+        std::size_t length = 0;
+        for (int i = 0; i < fakeMetricCount; i++)
+            length += formatMetricValue(i, values[i]).size();
+        sink = static_cast<double>(length);
+    } });
+    cases.push_back({ "format_to_chars", "std::to_chars into a stack buffer for 16 values", [] {
+        std::size_t length = 0;
+        char buffer[32];
+        for (int i = 0; i < fakeMetricCount; i++)
+            length += std::to_chars(buffer, buffer + sizeof(buffer), std::lround(values[i].value())).ptr - buffer;
+        sink = static_cast<double>(length);
+    } });
+
+    // layout of a full overlay from measured widths
+    static GlyphMetrics glyphs;
+    static std::vector<LayoutItem> items;
+    for (int c = 0; c < 256; c++)
+        glyphs.advances[c] = 8.0f + (c % 7);
+    for (const MetricName& name : getMetricNames())
+        items.push_back({ std::string(name.label) + ": ", "00000 MHz" });
+    cases.push_back({ "overlay_layout", "computeOverlayLayout for 16 metrics in two columns", [] {
+        LayoutParams params;
+        params.columns = 2;
+        sink = computeOverlayLayout(items, glyphs, params).width;
+    } });
+
+    // trace spans around every getter, off as shipped and on while a trace is taken
+    cases.push_back({ "trace_spans_off", "16 TraceScope spans with tracing off", [] {
+        setTracingEnabled(false);
+        for (int i = 0; i < fakeMetricCount; i++)
+            TraceScope scope("getter");
+    } });
+    cases.push_back({ "trace_spans_on", "16 TraceScope spans recorded into the thread's ring", [] {
+        setTracingEnabled(true);
+        for (int i = 0; i < fakeMetricCount; i++)
+            TraceScope scope("getter");
+        setTracingEnabled(false);
+    } });
+
+    // the driver latency histograms around every accessor, always on
+    static const int benchCall = registerDriverCall("microbench");
+    cases.push_back({ "getters_timed_driver_calls", "16 getters each timed into a driver latency histogram", [] {
+        double total = 0.0;
+        for (GetterFunction getter : fakeGetterPointers)
+            total += timeDriverCall(benchCall, getter).value_or(0.0);
+        sink = total;
+    } });
+
+#if defined(EASYMETRICS_BENCH_SFML)
+    // what the overlay did per value before it batched text: a new sf::String and sf::Text every tick
+    static sf::Font font;
+    const std::vector<unsigned char>& interFont = getInterFont();
+    if (!font.openFromMemory(interFont.data(), interFont.size()))
+        std::cerr << "Failed to load font" << std::endl;
+    cases.push_back({ "sf_string_value", "formatValue plus unit into an sf::String for 16 values", [] {
+        std::size_t length = 0;
+        for (int i = 0; i < fakeMetricCount; i++) {
+            sf::String text(formatValue(values[i].value(), 0) + " MHz");
+            length += text.getSize();
+        }
+        sink = static_cast<double>(length);
+    } });
+    cases.push_back({ "sf_text_bounds", "sf::Text construction and getLocalBounds for 16 values", [] {
+        float width = 0.f;
+        for (int i = 0; i < fakeMetricCount; i++) {
+            sf::Text text(font, formatValue(values[i].value(), 0) + " MHz", 24);
+            width += text.getLocalBounds().size.x;
+        }
+        sink = width;
+    } });
+#endif
+
+    return cases;
+}
+
+// run the suite in separate processes and merge them: the median of the medians and the fastest and slowest
+// repetition of any run. layout and machine noise differ from one process to the next, so a baseline recorded
+// this way has a spread a later single run rarely falls outside of by chance
+static bool runInProcesses(const char* self, int runs, const std::string& arguments, std::vector<CaseResult>& merged) {
+    std::vector<std::vector<CaseResult>> perRun;
+    for (int run = 0; run < runs; run++) {
+        std::string path = "microbench-run" + std::to_string(run) + ".json";
+#if defined(_WIN32)
+        std::string command = "\"\"" + std::string(self) + "\" " + arguments + " --json \"" + path + "\" > NUL\"";
+#else
+        std::string command = "\"" + std::string(self) + "\" " + arguments + " --json \"" + path + "\" > /dev/null";
+#endif
+        std::printf("run %d/%d\n", run + 1, runs);
+        std::fflush(stdout);
+        std::vector<CaseResult> results;
+        bool read = std::system(command.c_str()) == 0 && readBaseline(path, results);
+        std::remove(path.c_str());
+        if (!read)
+            return false;
+        perRun.push_back(std::move(results));
+    }
+
+    merged = perRun[0];
+    for (CaseResult& result : merged) {
+        std::vector<double> medians;
+        for (const std::vector<CaseResult>& results : perRun) {
+            for (const CaseResult& r : results) {
+                if (r.name != result.name)
+                    continue;
+                medians.push_back(r.nsPerOp);
+                result.nsMin = std::min(result.nsMin, r.nsMin);
+                result.nsMax = std::max(result.nsMax, r.nsMax);
+            }
+        }
+        std::sort(medians.begin(), medians.end());
+        result.nsPerOp = medians[medians.size() / 2];
+    }
+    return true;
+}
+
+#pragma endregion
+
+static void printUsage() {
+    std::cout << "usage: microbench [--filter TEXT] [--ms N] [--repetitions N] [--runs N] [--json PATH] [--baseline PATH] [--threshold PCT]\n"
+        << "  --filter TEXT      only cases whose name contains TEXT\n"
+        << "  --ms N             target time of each repetition (default 100)\n"
+        << "  --repetitions N    repetitions per case, the median is reported (default 9)\n"
+        << "  --runs N           run the suite in N processes and merge them, use 5 or more to record a baseline\n"
+        << "  --json PATH        write the results as json, e.g. to keep as the next baseline\n"
+        << "  --baseline PATH    compare against results saved with --json\n"
+        << "  --threshold PCT    median slowdown against the baseline that fails the run, when no repetition\n"
+        << "                     overlaps the baseline's either (default 50)\n"
+        << "  --list             list the cases\n";
+}
+
+int main(int argc, char** argv) {
+    std::string filter;
+    std::string jsonPath;
+    std::string baselinePath;
+    double targetMs = 100.0;
+    int repetitions = 9;
+    int runs = 1;
+    double thresholdPercent = 50.0;
+    bool list = false;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--filter") && i + 1 < argc)
+            filter = argv[++i];
+        else if (!std::strcmp(argv[i], "--ms") && i + 1 < argc)
+            targetMs = std::max(1.0, std::atof(argv[++i]));
+        else if (!std::strcmp(argv[i], "--repetitions") && i + 1 < argc)
+            repetitions = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--runs") && i + 1 < argc)
+            runs = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--json") && i + 1 < argc)
+            jsonPath = argv[++i];
+        else if (!std::strcmp(argv[i], "--baseline") && i + 1 < argc)
+            baselinePath = argv[++i];
+        else if (!std::strcmp(argv[i], "--threshold") && i + 1 < argc)
+            thresholdPercent = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--list"))
+            list = true;
+        else {
+            printUsage();
+            return 2;
+        }
+    }
+
+    std::vector<CaseResult> baseline;
+    if (!baselinePath.empty() && !readBaseline(baselinePath, baseline)) {
+        std::cout << "Failure: could not read baseline " << baselinePath << std::endl;
+        return 2;
+    }
+
+    std::vector<BenchCase> cases = buildCases();
+    if (list) {
+        for (const BenchCase& c : cases)
+            std::printf("%-26s %s\n", c.name, c.description);
+        return 0;
+    }
+
+    std::vector<CaseResult> results;
+    if (runs > 1) {
+        std::string arguments = "--ms " + std::to_string(targetMs) + " --repetitions " + std::to_string(repetitions);
+        if (!filter.empty())
+            arguments += " --filter \"" + filter + "\"";
+        if (!runInProcesses(argv[0], runs, arguments, results)) {
+            std::cout << "Failure: a benchmark run did not complete" << std::endl;
+            return 1;
+        }
+    }
+
+    std::printf("%-26s %12s %12s %12s %10s %10s\n", "case", "ns_per_op", "ns_min", "ns_max", "allocs_op", "vs_base");
+    int regressions = 0;
+    for (std::size_t i = 0; runs > 1 ? i < results.size() : i < cases.size(); i++) {
+        if (runs == 1) {
+            if (!filter.empty() && std::strstr(cases[i].name, filter.c_str()) == nullptr)
+                continue;
+            results.push_back(runCase(cases[i], targetMs, repetitions));
+        }
+        const CaseResult& result = runs > 1 ? results[i] : results.back();
+
+        // a single repetition moves by tens of percent between runs of the same build (heap and code layout, other
+        // processes), so only a median over the threshold with even the fastest repetition above the baseline's
+        // slowest counts. baselines without ns_max compare on the median alone
+        char comparison[32] = "-";
+        for (const CaseResult& base : baseline) {
+            if (base.name == result.name && base.nsPerOp > 0.0) {
+                double change = 100.0 * (result.nsPerOp - base.nsPerOp) / base.nsPerOp;
+                bool regressed = change > thresholdPercent && result.nsMin > base.nsMax;
+                regressions += regressed;
+                std::snprintf(comparison, sizeof(comparison), "%+.1f%%%s", change, regressed ? " !" : "");
+            }
+        }
+        std::printf("%-26s %12.1f %12.1f %12.1f %10.3f %10s\n", result.name.c_str(), result.nsPerOp, result.nsMin, result.nsMax,
+            result.allocationsPerOp, comparison);
+        std::fflush(stdout);
+    }
+
+    if (!jsonPath.empty() && !writeFile(jsonPath, resultsToJson(results))) {
+        std::cout << "Failure: could not write " << jsonPath << std::endl;
+        return 1;
+    }
+    if (regressions > 0) {
+        std::printf("%d case(s) more than %.0f%% slower than the baseline, outside its spread\n", regressions, thresholdPercent);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,180 @@
+// headless overlay rendering benchmark
+// renders the overlay text and sparklines into an offscreen sf::RenderTexture with fake values,
+// so it runs without a windows desktop or an amd gpu (e.g. xvfb-run or a software gl context on linux)
+#include "../include/metricsource.h"
+#include "../include/overlayrender.h"
+#include "../include/selfcost.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// one benchmark configuration
+struct BenchConfig {
+    int metricCount;
+    int textSize;
+    float scaleFactor;
+    int updateRateHz;
+    bool sparklines;
+};
+
+// results for one configuration
+struct BenchResult {
+    double meanMs;
+    double p50Ms;
+    double p99Ms;
+    double maxMs;
+    double drawCallsPerFrame;
+    double allocationsPerFrame;
+};
+
+static BenchResult runConfig(const BenchConfig& config, int frames) {
+    // same sizing as createOverlayWindow()
+    setSelectedMetrics((1u << config.metricCount) - 1);
+    int fontSize = static_cast<int>(config.textSize * config.scaleFactor);
+    int lineSpacing = static_cast<int>(fontSize * 0.4f);
+
+    LayoutParams params;
+    params.fontSize = fontSize;
+    params.lineSpacing = lineSpacing;
+    params.marginTop = static_cast<int>(20 * config.scaleFactor);
+    params.marginLeft = static_cast<int>(20 * config.scaleFactor);
+    params.graphWidth = config.sparklines ? fontSize * 4 : 0;
+
+    OverlayFont font;
+    if (!font.load(fontSize))
+        std::cerr << "Failed to load font" << std::endl;
+    GlyphMetrics glyphs = measureGlyphs(font);
+    OverlayLayout layout = computeOverlayLayout(buildLayoutItems(glyphs), glyphs, params);
+
+    sf::RenderTexture target(sf::Vector2u(layout.width, layout.height));
+
+    TextBatch labels(font);
+    TextBatch valueLines(font);
+    MetricSource source = fakeMetricSource(1);
+    std::vector<std::optional<double>> values;
+    drawLabels(labels, layout);
+
+    std::vector<Sparkline> sparklines;
+    if (config.sparklines) {
+        sf::Vector2f graphSize(static_cast<float>(params.graphWidth), static_cast<float>(fontSize));
+        for (int i = 0; i < numOfMetricsSelected; i++)
+            sparklines.emplace_back(120, sf::Vector2f(), graphSize, valueColor);
+        positionSparklines(sparklines, layout, lineSpacing * 0.5f);
+        // start with a full history like a long running overlay
+        for (int f = 0; f < 120; f++) {
+            readMetricSample(source, values);
+            pushSparklines(sparklines, values);
+        }
+    }
+
+    // the overlay draws at 60 fps and updates values at the configured rate
+    int framesPerUpdate = std::max(1, 60 / config.updateRateHz);
+    std::vector<double> frameMs;
+    frameMs.reserve(frames);
+    long long drawCalls = 0;
+    uint64_t allocationsBefore = getAllocationCount();
+
+    for (int f = 0; f < frames; f++) {
+        auto start = std::chrono::steady_clock::now();
+
+        if (f % framesPerUpdate == 0) {
+            readMetricSample(source, values);
+            drawValues(valueLines, layout, values);
+            pushSparklines(sparklines, values);
+        }
+        drawCalls += renderOverlayFrame(target, labels, valueLines, sparklines, nullptr);
+        target.display();
+
+        auto end = std::chrono::steady_clock::now();
+        frameMs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    uint64_t allocations = getAllocationCount() - allocationsBefore;
+
+    std::vector<double> sorted = frameMs;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0.0;
+    for (double ms : frameMs)
+        total += ms;
+
+    BenchResult result;
+    result.meanMs = total / frames;
+    result.p50Ms = sorted[sorted.size() / 2];
+    result.p99Ms = sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)];
+    result.maxMs = sorted.back();
+    result.drawCallsPerFrame = static_cast<double>(drawCalls) / frames;
+    result.allocationsPerFrame = static_cast<double>(allocations) / frames;
+    return result;
+}
+
+static void printUsage() {
+    std::cout << "usage: overlaybench [--frames N] [--budget-ms MS] [--quick]\n"
+        << "  --frames N      frames rendered per configuration (default 600)\n"
+        << "  --budget-ms MS  exit with an error if any configuration's p99 frame time exceeds MS\n"
+        << "  --quick         only run the smallest and largest configurations\n";
+}
+
+int main(int argc, char** argv) {
+    int frames = 600;
+    double budgetMs = 0.0;
+    bool quick = false;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--frames") && i + 1 < argc)
+            frames = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--budget-ms") && i + 1 < argc)
+            budgetMs = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--quick"))
+            quick = true;
+        else {
+            printUsage();
+            return 2;
+        }
+    }
+
+    // same defaults as the main window
+    float overlayCol[3] = { 0.0f, 0.0f, 0.0f };
+    float labelCol[3] = { 1.0f, 0.0f, 0.0f };
+    float valueCol[3] = { 0.0f, 1.0f, 0.0f };
+    setPreferences(overlayCol, labelCol, valueCol, 0.5f, 24);
+
+    // metric count, text size (the 10-38 slider range), scale factor (1080p/1440p/2160p) and update rate
+    std::vector<int> metricCounts = { 1, 4, 8, static_cast<int>(metrics.size()) };
+    std::vector<int> textSizes = { 10, 24, 38 };
+    std::vector<float> scaleFactors = { 1.0f, 1.333f, 2.0f };
+    std::vector<int> updateRates = { 1, 10, 60 };
+    if (quick) {
+        metricCounts = { 1, static_cast<int>(metrics.size()) };
+        textSizes = { 10, 38 };
+        scaleFactors = { 1.0f, 2.0f };
+        updateRates = { 1, 60 };
+    }
+
+    std::printf("%7s %4s %5s %4s %5s %9s %9s %9s %9s %7s %8s\n",
+        "metrics", "text", "scale", "hz", "spark", "mean_ms", "p50_ms", "p99_ms", "max_ms", "draws", "allocs");
+
+    bool overBudget = false;
+    for (int metricCount : metricCounts)
+        for (int size : textSizes)
+            for (float scale : scaleFactors)
+                for (int rate : updateRates)
+                    for (bool spark : { false, true }) {
+                        BenchConfig config{ metricCount, size, scale, rate, spark };
+                        BenchResult r = runConfig(config, frames);
+                        std::printf("%7d %4d %5.2f %4d %5s %9.4f %9.4f %9.4f %9.4f %7.1f %8.1f\n",
+                            metricCount, size, scale, rate, spark ? "on" : "off",
+                            r.meanMs, r.p50Ms, r.p99Ms, r.maxMs, r.drawCallsPerFrame, r.allocationsPerFrame);
+
+                        if (budgetMs > 0.0 && r.p99Ms > budgetMs)
+                            overBudget = true;
+                    }
+
+    if (overBudget) {
+        std::cerr << "p99 frame time exceeded the " << budgetMs << " ms budget" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,277 @@
+// push exporter loopback benchmark
+// pushes fake samples to a udp listener on 127.0.0.1 in each format and flush interval, then checks every
+// line arrived and reports datagrams and bytes per sample. also pushes to a port nobody listens on and
+// through a queue too small for the flush interval, to show sampling never waits and the oldest are dropped
+#include "../include/metricsource.h"
+#include "../include/pushexporter.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+typedef SOCKET SocketHandle;
+#define closeSocket closesocket
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int SocketHandle;
+#define closeSocket ::close
+#endif
+
+// the core fake source without hotspot temperature and voltage, which many machines do not report
+const uint32_t unsupportedMetrics = (1u << 2) | (1u << 4);
+
+static std::size_t countLines(const std::string& text) {
+    return static_cast<std::size_t>(std::count(text.begin(), text.end(), '\n'));
+}
+
+// udp socket bound to an ephemeral loopback port
+static SocketHandle bindListener(uint16_t& port) {
+    SocketHandle listener = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    int bufferBytes = 8 << 20;
+    setsockopt(listener, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&bufferBytes), sizeof(bufferBytes));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        closeSocket(listener);
+        return static_cast<SocketHandle>(-1);
+    }
+    port = ntohs(address.sin_port);
+    return listener;
+}
+
+struct Received {
+    uint64_t datagrams = 0;
+    uint64_t bytes = 0;
+    uint64_t lines = 0;
+    uint64_t largest = 0;
+    int64_t lastTimestamp = 0; // influx, of the last line received
+};
+
+// counts what arrives until stop is set and nothing more comes for a moment
+static void receive(SocketHandle listener, std::atomic<bool>& stop, Received& received) {
+#if defined(_WIN32)
+    DWORD timeout = 100;
+#else
+    timeval timeout = { 0, 100000 };
+#endif
+    setsockopt(listener, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+    std::vector<char> buffer(65536);
+    while (true) {
+        int bytes = static_cast<int>(recv(listener, buffer.data(), static_cast<int>(buffer.size()), 0));
+        if (bytes <= 0) {
+            if (stop.load())
+                break;
+            continue;
+        }
+        std::string datagram(buffer.data(), bytes);
+        received.datagrams++;
+        received.bytes += bytes;
+        received.largest = std::max<uint64_t>(received.largest, bytes);
+        received.lines += countLines(datagram);
+        std::size_t space = datagram.rfind(' ');
+        if (space != std::string::npos)
+            received.lastTimestamp = std::strtoll(datagram.c_str() + space + 1, nullptr, 10);
+    }
+}
+
+struct RunResult {
+    uint64_t samples = 0;
+    uint64_t expectedLines = 0;
+    double pushP99Ns = 0.0;
+    double pushMaxNs = 0.0;
+    int64_t lastTimestamp = 0;
+    PushExporter::Stats stats;
+};
+
+// push samples at a fixed rate for a while, timing every push() the sampler would make
+static bool runPush(const PushOptions& options, int rateHz, double seconds, RunResult& result) {
+    PushExporter exporter;
+    if (!exporter.start(options))
+        return false;
+
+    MetricSource source = fakeMetricSource(1, unsupportedMetrics);
+    std::vector<std::optional<double>> values;
+    std::vector<double> pushNs;
+    std::string lines;
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+    auto next = start;
+    while (std::chrono::steady_clock::now() < end) {
+        result.samples++;
+        readMetricSample(source, values);
+        int64_t unixNs = 1700000000000000000LL + static_cast<int64_t>(result.samples) * 1000000;
+        lines.clear();
+        renderPushLines(options.format, unixNs, values, lines);
+        result.expectedLines += countLines(lines);
+        result.lastTimestamp = unixNs;
+
+        auto pushStart = std::chrono::steady_clock::now();
+        exporter.push(unixNs, values);
+        pushNs.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - pushStart).count());
+
+        next += std::chrono::microseconds(1000000 / rateHz);
+        std::this_thread::sleep_until(next);
+    }
+    exporter.stop();
+    result.stats = exporter.getStats();
+
+    std::sort(pushNs.begin(), pushNs.end());
+    result.pushP99Ns = pushNs[std::min(pushNs.size() - 1, pushNs.size() * 99 / 100)];
+    result.pushMaxNs = pushNs.back();
+    return true;
+}
+
+static void printUsage() {
+    std::cout << "usage: pushbench [--seconds S] [--rate HZ]\n"
+        << "  --seconds S  length of each run (default 3)\n"
+        << "  --rate HZ    samples pushed per second (default 100)\n";
+}
+
+int main(int argc, char** argv) {
+    double seconds = 3.0;
+    int rateHz = 100;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--seconds") && i + 1 < argc)
+            seconds = std::max(0.1, std::atof(argv[++i]));
+        else if (!std::strcmp(argv[i], "--rate") && i + 1 < argc)
+            rateHz = std::max(1, std::atoi(argv[++i]));
+        else {
+            printUsage();
+            return 2;
+        }
+    }
+
+#if defined(_WIN32)
+    WSADATA data;
+    WSAStartup(MAKEWORD(2, 2), &data);
+#endif
+
+    bool failed = false;
+    std::printf("%-7s %8s %8s %10s %12s %13s %10s %9s %9s %7s\n", "format", "flush_ms", "samples", "datagrams",
+        "dgrams/smpl", "bytes/sample", "largest", "lines_ok", "push_p99", "drops");
+    for (PushFormat format : { PushFormat::StatsD, PushFormat::Influx }) {
+        for (int flushMs : { 100, 1000 }) {
+            uint16_t port = 0;
+            SocketHandle listener = bindListener(port);
+            std::atomic<bool> stop = false;
+            Received received;
+            std::thread receiver(receive, listener, std::ref(stop), std::ref(received));
+
+            PushOptions options;
+            options.format = format;
+            options.port = port;
+            options.flushIntervalMs = flushMs;
+            RunResult result;
+            bool ok = runPush(options, rateHz, seconds, result);
+            stop = true;
+            receiver.join();
+            closeSocket(listener);
+
+            bool linesOk = ok && received.lines == result.expectedLines && result.stats.samplesDropped == 0;
+            failed |= !linesOk;
+            std::printf("%-7s %8d %8llu %10llu %12.3f %13.1f %10llu %9s %8.0fns %7llu\n", format == PushFormat::StatsD ? "statsd" : "influx",
+                flushMs, static_cast<unsigned long long>(result.samples), static_cast<unsigned long long>(received.datagrams),
+                static_cast<double>(received.datagrams) / result.samples, static_cast<double>(received.bytes) / result.samples,
+                static_cast<unsigned long long>(received.largest), linesOk ? "yes" : "NO", result.pushP99Ns,
+                static_cast<unsigned long long>(result.stats.samplesDropped));
+        }
+    }
+
+    // nobody listening: every datagram is refused, pushing must not notice
+    {
+        uint16_t port = 0;
+        SocketHandle closed = bindListener(port);
+        closeSocket(closed);
+
+        PushOptions options;
+        options.port = port;
+        options.flushIntervalMs = 10;
+        RunResult result;
+        bool ok = runPush(options, rateHz, seconds, result);
+        std::printf("\ndead collector: %llu samples, %llu datagrams refused, push p99 %.0f ns, max %.0f ns\n",
+            static_cast<unsigned long long>(result.samples), static_cast<unsigned long long>(result.stats.sendErrors),
+            result.pushP99Ns, result.pushMaxNs);
+        failed |= !ok;
+    }
+
+    // flush interval longer than the queue: only the newest samples survive, and the last one is among them
+    {
+        uint16_t port = 0;
+        SocketHandle listener = bindListener(port);
+        std::atomic<bool> stop = false;
+        Received received;
+        std::thread receiver(receive, listener, std::ref(stop), std::ref(received));
+
+        PushOptions options;
+        options.format = PushFormat::Influx;
+        options.port = port;
+        options.flushIntervalMs = 60000;
+        options.queueSamples = 50;
+        RunResult result;
+        bool ok = runPush(options, rateHz, seconds, result);
+        stop = true;
+        receiver.join();
+        closeSocket(listener);
+
+        bool dropsOk = ok && result.stats.samplesSent == std::min<uint64_t>(result.samples, 50) &&
+            result.stats.samplesDropped == result.samples - result.stats.samplesSent && received.lastTimestamp == result.lastTimestamp;
+        std::printf("full queue: %llu samples, %llu dropped oldest, %llu sent, newest kept %s\n",
+            static_cast<unsigned long long>(result.samples), static_cast<unsigned long long>(result.stats.samplesDropped),
+            static_cast<unsigned long long>(result.stats.samplesSent), dropsOk ? "yes" : "NO");
+        failed |= !dropsOk;
+    }
+
+    // file output, one write per flush
+    {
+        std::string path = "pushbench.influx";
+        std::remove(path.c_str());
+        PushOptions options;
+        options.format = PushFormat::Influx;
+        options.path = path;
+        RunResult result;
+        bool ok = runPush(options, rateHz, seconds, result);
+
+        std::size_t lines = 0;
+        FILE* file = nullptr;
+#if defined(_WIN32)
+        fopen_s(&file, path.c_str(), "rb");
+#else
+        file = std::fopen(path.c_str(), "rb");
+#endif
+        if (file) {
+            char buffer[65536];
+            std::size_t bytes;
+            while ((bytes = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+                lines += static_cast<std::size_t>(std::count(buffer, buffer + bytes, '\n'));
+            std::fclose(file);
+        }
+        std::remove(path.c_str());
+
+        bool fileOk = ok && lines == result.expectedLines;
+        std::printf("file: %llu samples, %llu writes, %.1f bytes/sample, lines ok %s\n", static_cast<unsigned long long>(result.samples),
+            static_cast<unsigned long long>(result.stats.writes), static_cast<double>(result.stats.bytes) / result.samples, fileOk ? "yes" : "NO");
+        failed |= !fileOk;
+    }
+
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+    std::printf("%s\n", failed ? "FAILED" : "ok");
+    return failed ? 1 : 0;
+}
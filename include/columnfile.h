@@ -0,0 +1,120 @@
+#ifndef COLUMNFILE_H
+#define COLUMNFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// chunked columnar capture files for long sessions. rows are collected into chunks of a fixed row count,
+// each chunk stores its timestamps delta-of-delta encoded and every column on its own, xor encoded against
+// the previous value, followed by a footer with each column's offset, size, min and max. the file ends with a
+// sparse index (first and last time of every chunk), so a reader seeks straight to a time range and only
+// decodes the columns it asks for. values are stored as f32, missing values come back as nan.
+//
+// layout, little endian:
+//   header   "EMCOL\0\0\0", u32 version, u32 column count, u32 rows per chunk, names as u16 length + bytes
+//   chunk    u32 'EMCK', u32 rows, u64 chunk bytes, i64 first time us, i64 last time us, u32 time bytes,
+//            u32 footer offset, time block, column blocks, footer (ColumnStats per column)
+//   index    i64 first time us, i64 last time us, u64 chunk offset per chunk
+//   trailer  u64 index offset, u32 chunk count, u32 'EMIX'
+// a file that was never closed has no index, the reader then walks the chunks from the start instead
+
+// per chunk statistics of one column, kept in the chunk footer
+struct ColumnStats {
+    uint32_t offset = 0; // of the column block from the start of the chunk
+    uint32_t bytes = 0;
+    uint32_t present = 0; // rows with a value, the block has a presence bitmap unless every row has one
+    float min = 0.f;
+    float max = 0.f;
+};
+
+// where a chunk is and what it covers
+struct ChunkInfo {
+    int64_t firstTimeUs = 0;
+    int64_t lastTimeUs = 0;
+    uint64_t offset = 0;
+};
+
+// encodes rows into chunks and writes them to a file opened by the caller
+class ColumnFileWriter {
+public:
+    // write the header, up to 64 columns. returns the bytes written, 0 on failure
+    std::size_t begin(std::FILE* file, const std::vector<std::string>& columns, std::size_t chunkRows);
+
+    // add one row, the value of column i is present if bit i of mask is set.
+    // returns the bytes written to the file, 0 unless the row completed a chunk
+    std::size_t append(double timeSeconds, uint64_t mask, const float* values);
+
+    // write the last partial chunk and the index, the caller closes the file. returns the bytes written
+    std::size_t finish();
+
+private:
+    std::size_t writeChunk();
+
+    std::FILE* file = nullptr;
+    std::size_t columnCount = 0;
+    std::size_t chunkRows = 0;
+    uint64_t fileOffset = 0;
+
+    // the chunk being collected, one vector per column
+    std::vector<int64_t> times;
+    std::vector<uint64_t> masks;
+    std::vector<std::vector<float>> columnValues;
+    std::vector<unsigned char> encoded; // reused for every chunk
+
+    std::vector<ChunkInfo> index;
+};
+
+// rows read back from a columnar file, values[c][r] belongs to the c-th requested column
+struct ColumnSlice {
+    std::vector<double> times;
+    std::vector<std::vector<float>> values;
+};
+
+// reads a columnar file, written or still being written
+class ColumnFileReader {
+public:
+    ColumnFileReader() = default;
+    ColumnFileReader(const ColumnFileReader&) = delete;
+    ColumnFileReader& operator=(const ColumnFileReader&) = delete;
+    ~ColumnFileReader();
+
+    bool open(const std::string& path);
+    void close();
+
+    const std::vector<std::string>& getColumns() const { return columns; }
+    const std::vector<ChunkInfo>& getChunks() const { return chunks; }
+    bool wasClosed() const { return indexed; } // false if the index was missing and the chunks were scanned
+
+    // read the rows with beginSeconds <= time <= endSeconds of the given columns
+    bool read(double beginSeconds, double endSeconds, const std::vector<int>& columnIds, ColumnSlice& slice);
+
+    // min and max of a column between two times. chunks entirely inside the range are answered from
+    // their footers, only the chunks at either end are decoded. false if the column has no value in the range
+    bool summarize(int columnId, double beginSeconds, double endSeconds, float& min, float& max);
+
+private:
+    // the chunk header and footer, plus the decoded times
+    struct Chunk {
+        uint32_t rows = 0;
+        std::vector<ColumnStats> stats;
+        std::vector<int64_t> times;
+    };
+
+    bool loadChunk(std::size_t chunkIndex, Chunk& chunk);
+    bool decodeColumn(std::size_t chunkIndex, const Chunk& chunk, int columnId, std::vector<float>& values);
+    bool scanChunks(uint64_t offset);
+    std::size_t firstChunkAfter(int64_t timeUs) const;
+
+    std::FILE* file = nullptr;
+    uint64_t fileBytes = 0;
+    std::size_t chunkRows = 0;
+    std::vector<std::string> columns;
+    std::vector<ChunkInfo> chunks;
+    bool indexed = false;
+    std::vector<unsigned char> buffer; // reused for every block read
+};
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef DRIVERLATENCY_H
+#define DRIVERLATENCY_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// latency of every driver call the sampler makes (adlx accessors, sysfs reads), one hdr histogram per call.
+// calls are registered once by name, recording is lock-free and always on: two clock reads per call
+
+// calls that can be registered, the rest are not timed
+const int maxDriverCalls = 64;
+
+// per call summary for the main window and the headless summary
+struct DriverCallStats {
+    std::string name;
+    int metricId; // the metric this call reads, -1 for calls shared by every metric
+    uint64_t calls;
+    double meanUs;
+    double p50Us;
+    double p99Us;
+    double p999Us;
+    double maxUs;
+};
+
+// id of the call with this name, registered on first use. -1 once maxDriverCalls are taken
+int registerDriverCall(const char* name, int metricId = -1);
+
+// add one call's duration to its histogram, from the thread that makes the call
+void recordDriverCall(int call, int64_t durationNs);
+
+// run a driver call and record how long it took, returns what the call returned
+template <typename Call>
+auto timeDriverCall(int call, Call&& driverCall) {
+    auto start = std::chrono::steady_clock::now();
+    auto result = driverCall();
+    recordDriverCall(call, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    return result;
+}
+
+// every call made at least once, in registration order
+std::vector<DriverCallStats> getDriverCallStats();
+
+// start every histogram over, e.g. after changing driver settings
+void resetDriverLatency();
+
+// write every histogram in the hdrhistogram percentile format (.hgrm), readable by its plotter
+bool writeDriverLatencyFile(const std::string& path);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef FONTCACHE_H
+#define FONTCACHE_H
+
+#include <memory>
+#include "../include/glyphatlas.h"
+
+// process wide glyph cache shared by the main window (imgui) and the overlay, safe to call from any thread.
+// each size is unpacked from the pre-baked data or rasterized once, then kept until the app exits,
+// so reopening the overlay never touches the font again
+
+// atlas of the ui characters at characterSize pixels per em, nullptr if the embedded font is broken
+std::shared_ptr<const GlyphAtlas> acquireGlyphAtlas(int characterSize);
+
+// em size that imgui's pixel height (ascent - descent) corresponds to
+int glyphAtlasSizeForPixelHeight(float pixelHeight);
+
+#endif
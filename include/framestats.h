@@ -0,0 +1,58 @@
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// rolling frame time statistics (average fps, 1% and 0.1% lows) over a time window
+// frame times are binned into a fenwick tree so adding, evicting and percentile
+// queries are all O(log bins) instead of sorting the window on every refresh
+class FrameTimeStats {
+public:
+    // binResolutionMs is the precision of the percentiles, frame times above maxFrameTimeMs share the last bin
+    explicit FrameTimeStats(double windowMs = 10000.0, double binResolutionMs = 0.01, double maxFrameTimeMs = 250.0);
+
+    // add a frame time observed at timestampMs, frames > 1 weights it as that many frames
+    void addSample(int64_t timestampMs, double frameTimeMs, uint32_t frames = 1);
+    void clear();
+
+    uint64_t getFrameCount() const { return totalFrames; }
+    double getAverageFPS() const;
+    double getAverageFrameTime() const;
+
+    // frame time that the given fraction of frames are at or below (0.99 -> 99th percentile)
+    double getPercentileFrameTime(double fraction) const;
+
+    // mean frame time of the slowest fraction of frames (0.01 -> the slowest 1%), at least one frame.
+    // unlike a percentile this still sees stutter that makes up exactly that fraction of the frames
+    double getSlowestFramesMeanTime(double fraction) const;
+
+    // fps of the slowest 1% / 0.1% of frames (1000 / their mean frame time)
+    double getOnePercentLowFPS() const;
+    double getPointOnePercentLowFPS() const;
+
+private:
+    struct Sample {
+        int64_t timestampMs;
+        uint32_t bin;
+        uint32_t frames;
+        double frameTimeMs;
+    };
+
+    void evictOlderThan(int64_t timestampMs);
+    void addToBin(uint32_t bin, int64_t delta);
+    uint32_t findBin(uint64_t rank) const;
+    uint64_t prefixSum(const std::vector<uint64_t>& fenwick, uint32_t bin) const;
+
+    double windowMs;
+    double binResolutionMs;
+    std::vector<uint64_t> tree; // fenwick tree of frame counts per bin (1-based)
+    std::vector<uint64_t> binTree; // fenwick tree of frame count * bin index, exact sums of the binned frame times
+    uint32_t treeMask; // highest power of two <= number of bins, for the descent
+    std::deque<Sample> window;
+    uint64_t totalFrames = 0;
+    double totalTimeMs = 0.0;
+};
+
+#endif
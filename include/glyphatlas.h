@@ -0,0 +1,43 @@
+#ifndef GLYPHATLAS_H
+#define GLYPHATLAS_H
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+// one glyph in an atlas, in pixels relative to the pen position on the baseline (like sf::Glyph)
+struct AtlasGlyph {
+    float advance = 0.f;
+    int left = 0;
+    int top = 0;
+    int width = 0;
+    int height = 0;
+    int x = 0; // top left in the atlas, excluding padding
+    int y = 0;
+};
+
+// 8 bit coverage atlas of the ui characters at one size
+struct GlyphAtlas {
+    int characterSize = 0; // pixels per em, as in freetype and sf::Font
+    float ascent = 0.f;
+    float lineSpacing = 0.f;
+    int width = 0;
+    int height = 0;
+    std::array<AtlasGlyph, 256> glyphs = {}; // latin-1, missing characters have no size or advance
+    std::vector<unsigned char> pixels;
+};
+
+// characters every atlas holds: printable ascii and the degree sign
+const std::vector<int>& atlasCodePoints();
+
+// rasterize the atlas characters with stb_truetype and shelf pack them, used at runtime by the
+// font cache for sizes that were not pre-baked and by tools/fontbake to pre-bake the common ones
+bool rasterizeGlyphAtlas(const unsigned char* otf, size_t otfSize, int characterSize, GlyphAtlas& atlas);
+
+// ascent and line spacing of the font at a size, for atlases unpacked from pre-baked data
+bool measureFontLines(const unsigned char* otf, size_t otfSize, int characterSize, GlyphAtlas& atlas);
+
+// em size in pixels whose ascent - descent is pixelHeight (imgui sizes fonts that way)
+float emSizeForPixelHeight(const unsigned char* otf, size_t otfSize, float pixelHeight);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+// command line mode that samples, logs and exports without ever creating a window or gl context.
+// on windows the app runs it when started with --headless, elsewhere it is its own executable
+// (easymetrics_headless) reading sysfs or fake values
+int runHeadless(int argc, char** argv);
+
+#endif
@@ -1,7 +1,51 @@
 #ifndef INTER_H
 #define INTER_H
 
-extern unsigned char Inter_UI_Regular_otf[];
-extern unsigned int Inter_UI_Regular_otf_len;
+#include <cstdint>
+#include <vector>
 
-#endif
\ No newline at end of file
+// embedded Inter subset and overlay glyph atlas, generated into src/inter.cpp by tools/fontbake
+
+// lz compressed otf (basic latin + latin-1)
+extern const unsigned char Inter_UI_Regular_otf_lz[];
+extern const unsigned int Inter_UI_Regular_otf_lz_len;
+extern const unsigned int Inter_UI_Regular_otf_len;
+
+// one pre-rasterized glyph, positions in pixels relative to the baseline like sf::Glyph
+struct BakedGlyph {
+    uint16_t codePoint;
+    int16_t advance;
+    int16_t left;
+    int16_t top;
+    int16_t width;
+    int16_t height;
+    int16_t x; // top left in the atlas, excluding padding
+    int16_t y;
+};
+
+// one baked character size, the atlas is an lz compressed 8 bit alpha image
+struct BakedFontSize {
+    int characterSize;
+    int atlasWidth;
+    int atlasHeight;
+    int firstGlyph; // index into bakedInterGlyphs
+    int glyphCount;
+    int pixelsOffset; // index into bakedInterPixels_lz
+    int pixelsLength;
+};
+
+extern const BakedFontSize bakedInterSizes[];
+extern const int bakedInterSizeCount;
+extern const BakedGlyph bakedInterGlyphs[];
+extern const unsigned char bakedInterPixels_lz[];
+
+// decompressed otf, unpacked on first use and shared by imgui and the overlay
+const std::vector<unsigned char>& getInterFont();
+
+// baked size matching characterSize, or nullptr if it has to be rasterized at runtime
+const BakedFontSize* findBakedInterSize(int characterSize);
+
+// decompress the atlas of a baked size, returns an empty vector on corrupt data
+std::vector<unsigned char> getBakedInterPixels(const BakedFontSize& size);
+
+#endif
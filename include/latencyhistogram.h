@@ -0,0 +1,41 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+// hdr style histogram of durations in nanoseconds: exact below 64 ns, then 64 linear sub-buckets per power of two,
+// so any value from 1 ns to about 18 minutes is kept to within 1.6% in a fixed 18 KB with no allocation.
+// one thread records at a time, any thread may read: every count is a relaxed atomic, so a read taken mid-record
+// can be one value behind but never torn
+class LatencyHistogram {
+public:
+    static const int subBucketBits = 6;
+    static const int maxValueBits = 40; // longer durations are counted in the last bucket, the max stays exact
+    static const int bucketCount = (maxValueBits - subBucketBits + 1) << subBucketBits;
+
+    void record(int64_t durationNs);
+    void reset();
+
+    uint64_t count() const;
+    int64_t min() const;
+    int64_t max() const;
+    double mean() const;
+
+    // highest value equivalent to the recorded value at this percentile (0-100), 0 when empty
+    int64_t valueAtPercentile(double percentile) const;
+
+    // every non-empty bucket, lowest first, with the range of values it holds
+    void forEachBucket(const std::function<void(int64_t lowNs, int64_t highNs, uint64_t count)>& visit) const;
+
+private:
+    std::array<std::atomic<uint64_t>, bucketCount> counts = {};
+    std::atomic<uint64_t> total = 0;
+    std::atomic<uint64_t> sumNs = 0;
+    std::atomic<int64_t> minNs = INT64_MAX;
+    std::atomic<int64_t> maxNs = 0;
+};
+
+#endif
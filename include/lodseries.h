@@ -0,0 +1,60 @@
+#ifndef LODSERIES_H
+#define LODSERIES_H
+
+#include <cstddef>
+#include <vector>
+
+// append-only time series with a min/max level-of-detail tree for plotting.
+// every level summarises blocks of the one below (fanout 8), built incrementally as samples arrive,
+// so reducing any range to one min/max pair per pixel costs O(pixels * log n) whatever the zoom.
+// with a capacity only the newest samples are kept: the oldest quarter is dropped, with the nodes
+// that covered nothing else, whenever the series grows past it by that much
+class LodSeries {
+public:
+    // capacity 0 keeps every sample
+    explicit LodSeries(std::size_t capacity = 0) : capacity(capacity) {}
+
+    // add the newest sample, nan marks a gap (the metric had no value)
+    void push(float value);
+    void clear();
+
+    // indices count every sample pushed since the series was created or cleared,
+    // samples before oldest() have been dropped
+    std::size_t size() const { return first + samples.size(); }
+    std::size_t oldest() const { return first; }
+    float at(std::size_t index) const { return samples[index - first]; }
+
+    // min and max of each of `buckets` equal slices of [begin, end), in the order they occurred
+    // (two points per bucket). ranges with fewer samples than points are copied as is,
+    // begin is clamped to oldest(). gaps repeat the previous point (leading ones the first value)
+    // so the points can go straight to a plot, a range with no values at all gives none
+    void query(std::size_t begin, std::size_t end, std::size_t buckets, std::vector<float>& points) const;
+
+    // bytes held by the samples and the tree
+    std::size_t memoryUsage() const;
+
+private:
+    struct Node {
+        float min;
+        float max;
+        bool minFirst; // min occurred before max, keeps the plotted line in order
+    };
+
+    // running min/max over several nodes of a range
+    struct Extremes;
+
+    static const std::size_t fanoutBits = 3;
+    static const std::size_t fanout = std::size_t(1) << fanoutBits;
+
+    void addLevel();
+    void dropOldest();
+    void accumulate(std::size_t begin, std::size_t end, Extremes& extremes) const;
+
+    std::size_t capacity;
+    std::size_t first = 0; // index of samples[0]
+    std::vector<float> samples;
+    std::vector<std::vector<Node>> levels; // levels[k] has one node per fanout^(k+1) samples
+    std::vector<std::size_t> levelFirst; // index of levels[k][0] within its level
+};
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef LZ_H
+#define LZ_H
+
+#include <cstddef>
+#include <vector>
+
+// small lz77 codec for the data embedded in the binary (font and glyph atlas)
+// stream of sequences: token (literal count << 4 | match length - 4), extra literal count bytes,
+// literals, 2 byte little-endian offset, extra match length bytes. the last sequence has literals only
+
+// compress a buffer, only used by the build tools
+std::vector<unsigned char> lzCompress(const unsigned char* data, size_t size);
+
+// decompress into a buffer of exactly the original size, returns false on corrupt input
+bool lzDecompress(const unsigned char* src, size_t srcSize, unsigned char* dst, size_t dstSize);
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef METRICFORMAT_H
+#define METRICFORMAT_H
+
+#include <optional>
+#include <string>
+#include <vector>
+
+// value formatting shared by the main window, the overlay and the headless mode, driven by the
+// metric table in metricsource.h. strings are utf-8, the overlay converts once for its latin-1 font
+
+// function to format a metric value with the given number of decimals
+std::string formatValue(double value, int precision);
+
+// unit as shown after a value: a space before words, none before % or degrees
+std::string displayUnit(int metricId);
+
+// value with the metric's precision and unit, or N/A when unsupported
+std::string formatMetricValue(int metricId, const std::optional<double>& value);
+
+// one column per metric for recordings and exports, named with its unit
+std::vector<std::string> metricColumnNames();
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef METRICSAMPLER_H
+#define METRICSAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "../include/metricsource.h"
+#include "../include/pushexporter.h"
+#include "../include/sessionlog.h"
+
+// one sampling loop shared by the main window preview and the overlay: every metric is read from a
+// metric source (adlx in the app) once per interval on the sampler's own thread, readers only copy the results
+
+// time between samples
+const int sampleIntervalMs = 1000;
+
+struct SamplerOptions {
+    int intervalMs = sampleIntervalMs;
+    bool keepHistory = true; // recent samples for copyMetricHistory, off for headless runs
+    std::size_t historySamples = 6 * 60 * 60; // newest samples kept per metric, six hours at the default interval
+};
+
+// start/stop the sampling thread, called from the main window thread
+void startMetricSampling(MetricSource source, const SamplerOptions& options = SamplerOptions());
+void stopMetricSampling();
+
+// true once stopped, or if the source could not be opened
+bool isMetricSamplingStopped();
+
+// number of samples taken so far, cheap enough to poll every frame
+uint64_t getSampleCount();
+
+// block until there is a sample newer than afterCount, the sampler stops, or timeoutMs passes.
+// returns the sample count
+uint64_t waitForSample(uint64_t afterCount, int timeoutMs);
+
+// copy the newest value of every metric (indexed by metric id, nullopt if unsupported or not sampled yet),
+// returns the sample count the values belong to
+uint64_t copyLatestSample(std::vector<std::optional<double>>& values);
+
+// copy a metric's last windowSamples samples (fewer until that many were taken) for plotting, oldest first and
+// at most maxPoints long. longer windows are reduced to the min and max of each bucket so peaks survive the downsampling
+// missing samples are filled from the neighbouring values, so the points never hold a nan
+void copyMetricHistory(int metricId, std::size_t windowSamples, std::size_t maxPoints, std::vector<float>& points);
+
+// write every sample from now on to a file, one column per metric. the sampler only formats into memory,
+// the disk writes happen on the logger's own thread
+bool startRecording(const std::string& path, const std::vector<std::string>& columns, const LogOptions& options);
+void stopRecording();
+
+// keep the last slotCount samples in a memory-mapped ring file that survives the process crashing,
+// recover it with tools/ringrecover. closed by stopMetricSampling()
+bool startCrashCapture(const std::string& path, const std::vector<std::string>& columns, std::size_t slotCount);
+void stopCrashCapture();
+
+// publish every sample to other processes through shared memory (see sharedmetrics.h),
+// keeping the last historySlots for readers. closed by stopMetricSampling()
+bool startMetricPublishing(const std::string& name, const std::vector<std::string>& columns, std::size_t historySlots);
+void stopMetricPublishing();
+
+// serve every sample in the prometheus text format on http://127.0.0.1:port/metrics (see prometheusexporter.h).
+// closed by stopMetricSampling()
+bool startMetricsEndpoint(uint16_t port);
+void stopMetricsEndpoint();
+
+// push every sample to a statsd or influx collector (see pushexporter.h). closed by stopMetricSampling()
+bool startMetricPush(const PushOptions& options);
+void stopMetricPush();
+
+#endif
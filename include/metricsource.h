@@ -0,0 +1,46 @@
+#ifndef METRICSOURCE_H
+#define METRICSOURCE_H
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+// where the sampler reads every metric from. the app reads adlx (adlxMetricSource in performancemonitor.h);
+// headless runs can also read amdgpu through linux sysfs, or fake values so the whole pipeline runs on any
+// machine. every function is called on the sampler thread only
+
+struct MetricSource {
+    std::string name;
+    std::function<bool()> open; // false if the source cannot be read here, called once before the first sample
+    std::function<void()> beginSample; // refresh anything the getters share, once per sample before them
+    std::vector<std::function<std::optional<double>()>> getters; // indexed by metric id, nullopt if unsupported
+    std::function<void()> close; // after the last sample
+};
+
+// key, label, unit and display precision of each metric, indexed by metric id. every front-end's table is built from this
+struct MetricName {
+    const char* key; // lowercase with underscores, used on the command line
+    const char* label;
+    const char* unit; // utf-8, empty if the metric has none
+    int precision; // decimal places shown
+    int maxDigits; // integer digits of the largest plausible value, used for layout
+};
+
+const std::vector<MetricName>& getMetricNames();
+
+// deterministic values that move like a game running, the same sequence for the same seed.
+// metrics with their bit set in unsupported read as nullopt, like sensors a machine does not have
+MetricSource fakeMetricSource(uint64_t seed, uint32_t unsupported = 0);
+
+// one sample from a source outside the sampler: beginSample, then every getter into values by metric id
+void readMetricSample(MetricSource& source, std::vector<std::optional<double>>& values);
+
+#if !defined(_WIN32)
+// amdgpu card<gpu> through /sys/class/drm and its hwmon, cpu and memory from /proc/stat and /proc/meminfo.
+// the fps metrics have no sysfs counterpart and stay unsupported
+MetricSource sysfsMetricSource(int gpu);
+#endif
+
+#endif
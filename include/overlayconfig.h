@@ -0,0 +1,34 @@
+#ifndef OVERLAYCONFIG_H
+#define OVERLAYCONFIG_H
+
+#include <array>
+#include <cstdint>
+#include "../include/overlaylayout.h"
+
+// everything the main window can change about the overlay. published as an immutable snapshot
+// through the OverlayController, the overlay thread picks up the newest one at the start of its next frame
+struct OverlayConfig {
+    uint64_t version = 0; // stamped on publish, not part of the comparison
+    unsigned int selectedMetrics = 0; // binary representation
+    std::array<float, 3> overlayColor = { 0.0f, 0.0f, 0.0f };
+    std::array<float, 3> labelColor = { 1.0f, 0.0f, 0.0f };
+    std::array<float, 3> valueColor = { 0.0f, 1.0f, 0.0f };
+    float transparency = 0.5f;
+    int textSize = 24;
+    bool showSparklines = false;
+    int sparklineSeconds = 60;
+    bool showSelfCost = false;
+    int columns = 1;
+    LayoutMode layoutMode = LayoutMode::MultiColumn;
+};
+
+bool operator==(const OverlayConfig& a, const OverlayConfig& b);
+bool operator!=(const OverlayConfig& a, const OverlayConfig& b);
+
+// true when the two only differ in colours or transparency, so a scene can be recoloured without a re-layout
+bool sameOverlayLayout(const OverlayConfig& a, const OverlayConfig& b);
+
+// alpha of the layered overlay window, 0-255
+int overlayWindowAlpha(const OverlayConfig& config);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef OVERLAYCONTROLLER_H
+#define OVERLAYCONTROLLER_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include "../include/overlayconfig.h"
+
+// owns the overlay thread and the config handed to it.
+// start/stop are called from the main window thread only, the overlay thread only reads the config
+// and polls for a stop request, so the two never share anything but the atomics below
+class OverlayController {
+public:
+    OverlayController() = default;
+    OverlayController(const OverlayController&) = delete;
+    OverlayController& operator=(const OverlayController&) = delete;
+    ~OverlayController();
+
+    // run the overlay on its own thread, false if one is already running.
+    // joins the previous thread first if that overlay closed itself
+    bool start(std::function<void(OverlayController&)> run);
+
+    // ask the overlay to close after its current frame, does not wait
+    void requestStop();
+
+    // ask the overlay to close and wait for its thread to finish
+    void stop();
+
+    // true from start() until the overlay function has returned
+    bool isRunning() const;
+
+    // polled by the overlay once per frame
+    bool stopRequested() const;
+
+    // replace the config snapshot, stamped with the next version
+    void publishConfig(const OverlayConfig& config);
+
+    // newest snapshot, never null (defaults with version 0 until the first publish)
+    std::shared_ptr<const OverlayConfig> loadConfig() const;
+
+private:
+    std::thread thread;
+    std::atomic<bool> running = false;
+    std::atomic<bool> stopping = false;
+
+    // only ever swapped as a whole with the atomic shared_ptr functions
+    std::shared_ptr<const OverlayConfig> config = std::make_shared<const OverlayConfig>();
+    uint64_t lastVersion = 0; // publishers are serialized by the main window thread
+};
+
+#endif
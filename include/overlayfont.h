@@ -0,0 +1,45 @@
+#ifndef OVERLAYFONT_H
+#define OVERLAYFONT_H
+
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../include/glyphatlas.h"
+
+// overlay font at one character size, a texture made from the shared glyph cache's atlas
+class OverlayFont {
+public:
+    bool load(int characterSize);
+
+    int getCharacterSize() const { return characterSize; }
+    float getLineSpacing() const { return atlas ? atlas->lineSpacing : 0.f; }
+    const sf::Glyph& getGlyph(unsigned char c) const { return glyphs[c]; }
+    const sf::Texture& getTexture() const { return texture; }
+
+private:
+    int characterSize = 0;
+    std::shared_ptr<const GlyphAtlas> atlas;
+    std::array<sf::Glyph, 256> glyphs = {}; // latin-1
+    sf::Texture texture;
+};
+
+// overlay text in a single vertex array, one draw call however many lines it holds.
+// text is latin-1 and may span lines, kerning is ignored (Inter's is in GPOS, which sf::Text never read either)
+class TextBatch : public sf::Drawable {
+public:
+    explicit TextBatch(const OverlayFont& font) : font(&font) {}
+
+    void clear() { vertices.clear(); }
+    void add(const std::string& text, sf::Vector2f position, sf::Color color);
+    float measure(const std::string& text) const; // widest line
+
+private:
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+    const OverlayFont* font;
+    std::vector<sf::Vertex> vertices; // reused, so steady state updates do not allocate
+};
+
+#endif
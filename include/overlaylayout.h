@@ -0,0 +1,60 @@
+#ifndef OVERLAYLAYOUT_H
+#define OVERLAYLAYOUT_H
+
+#include <array>
+#include <string>
+#include <vector>
+
+// how the selected metrics are arranged in the overlay
+enum class LayoutMode {
+    MultiColumn, // fill each column top to bottom, columns sized to their own contents
+    Grid // fill row by row, every cell the same width
+};
+
+// horizontal advance of each (latin-1) character at one font size, measured once from the font
+struct GlyphMetrics {
+    std::array<float, 256> advances = {};
+
+    float measure(const std::string& text) const;
+};
+
+// one line of the overlay as seen by the layout pass
+struct LayoutItem {
+    std::string label; // including the ": " suffix
+    std::string widestValue; // worst case value string, e.g. "20000 MHz"
+};
+
+// inputs that affect the layout, anything else (colours, values) never triggers a re-layout
+struct LayoutParams {
+    int fontSize = 24;
+    int lineSpacing = 0;
+    int marginTop = 0;
+    int marginLeft = 0;
+    int columns = 1;
+    LayoutMode mode = LayoutMode::MultiColumn;
+    int graphWidth = 0; // sparkline column per cell, 0 when disabled
+    int footerWidth = 0; // extra block under the metrics (self-cost panel)
+    int footerHeight = 0;
+};
+
+// position of one metric line in the overlay
+struct CellLayout {
+    float labelX;
+    float valueRight; // values are right aligned to this x
+    float graphX;
+    float y;
+};
+
+// result of the layout pass
+struct OverlayLayout {
+    int width = 0;
+    int height = 0;
+    int lineHeight = 0;
+    float footerY = 0.f;
+    std::vector<CellLayout> cells; // one per item, in item order
+};
+
+// lay out the items from their measured widths, no font or window needed
+OverlayLayout computeOverlayLayout(const std::vector<LayoutItem>& items, const GlyphMetrics& glyphs, const LayoutParams& params);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef OVERLAYRENDER_H
+#define OVERLAYRENDER_H
+
+#include <SFML/Graphics.hpp>
+#include <optional>
+#include <string>
+#include <vector>
+#include "../include/metricformat.h"
+#include "../include/sparkline.h"
+#include "../include/overlaylayout.h"
+#include "../include/overlayfont.h"
+
+// struct to hold metric info
+struct MetricInfo {
+    int id;
+    sf::String label;
+    sf::String unit;
+    int precision = 0; // decimal places shown
+    int maxDigits = 3; // integer digits of the largest plausible value, used for layout
+};
+
+// display info for every metric, indexed by metric id
+extern const std::vector<MetricInfo> metrics;
+
+// overlay selection and colours, set from main and read while rendering
+extern int numOfMetricsSelected;
+extern unsigned int selectedMetrics;
+extern sf::Color overlayColor;
+extern sf::Color labelColor;
+extern sf::Color valueColor;
+extern int textSize;
+extern int alpha;
+
+// functions for building the overlay text, these only need a render target so they can run offscreen
+GlyphMetrics measureGlyphs(const OverlayFont& font);
+std::vector<LayoutItem> buildLayoutItems(const GlyphMetrics& glyphs);
+void drawLabels(TextBatch& lines, const OverlayLayout& layout);
+void drawValues(TextBatch& lines, const OverlayLayout& layout, const std::vector<std::optional<double>>& values);
+void positionSparklines(std::vector<Sparkline>& sparklines, const OverlayLayout& layout, float offsetY);
+void pushSparklines(std::vector<Sparkline>& sparklines, const std::vector<std::optional<double>>& values);
+int renderOverlayFrame(sf::RenderTarget& target, const TextBatch& labels, const TextBatch& values, const std::vector<Sparkline>& sparklines, const TextBatch* debugText);
+
+// functions for overlay window properties
+void setPreferences(const float overlayColor[3], const float labelColor[3], const float valueColor[3], float alpha, int textSize);
+
+// functions for metrics
+void setSelectedMetrics(unsigned int selectedMetricsBinary);
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef OVERLAYSCENE_H
+#define OVERLAYSCENE_H
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "../include/overlayconfig.h"
+#include "../include/overlayrender.h"
+
+// everything drawn in the overlay for one config snapshot, rebuilt when a newer snapshot is published.
+// never moved once built, the text batches point at the fonts next to them.
+// only needs a render target, so the soak harness drives the same scene offscreen as createOverlayWindow()
+struct OverlayScene {
+    OverlayFont font;
+    OverlayFont debugFont;
+    TextBatch labels{ font };
+    TextBatch values{ font };
+    TextBatch debugText{ debugFont };
+    GlyphMetrics glyphs;
+    LayoutParams layoutParams;
+    OverlayLayout layout;
+    std::vector<Sparkline> sparklines;
+};
+
+// function to apply a config snapshot and build its scene with the current values drawn.
+// when replacing a scene, pass the previous one and its config so the sparkline history can carry over
+std::unique_ptr<OverlayScene> buildOverlayScene(const OverlayConfig& config, float scaleFactor, const std::vector<std::optional<double>>& values,
+    const std::string& debugString, OverlayScene* previous = nullptr, const OverlayConfig* previousConfig = nullptr);
+
+// function to move a scene to a newer config snapshot. a change of colours or transparency redraws the text
+// in place, anything else builds a new scene. true when it was rebuilt, so the window size may have changed
+bool reconfigureOverlayScene(std::unique_ptr<OverlayScene>& scene, const OverlayConfig& previous, const OverlayConfig& next, float scaleFactor,
+    const std::vector<std::optional<double>>& values, const std::string& debugString);
+
+// function to draw a new sample into the scene, and refresh the self-cost panel when it is shown
+void updateOverlayScene(OverlayScene& scene, const OverlayConfig& config, const std::vector<std::optional<double>>& values, std::string& debugString);
+
+#endif
@@ -2,19 +2,28 @@
 #define PERFORMANCEMONITOR_H
 
 #include "../include/ADLXHelper.h"
+#include "../include/metricsource.h"
 #include "IPerformanceMonitoring.h"
 #include "IPerformanceMonitoring2.h"
 #include <iostream>
 #include <optional>
 
 // functions to initialize/terminate the helper object
-void initializeHelper();
+void startADLXInitialization();
+bool initializeHelper(); // false if adlx could not be initialized
 void terminateHelper();
 
 // function to get metrics
 void setupServices();
+void stopFPSTracking();
 void releaseAndTerminate();
 
+// function to pull new samples from the adlx fps history into the frame time stats
+void updateFPSHistory();
+
+// function to read the current fps once per sample, getFPS and getFrameTime report it
+void updateCurrentFPS();
+
 // helper functions for showing each individual metric
 std::optional<adlx_double> getGPUUsage();
 std::optional<adlx_double> getGPUTemperature();
@@ -27,5 +36,13 @@ std::optional<adlx_double> getGPUVRAM();
 std::optional<adlx_double> getGPUVRAMClockSpeed();
 std::optional<adlx_double> getCPUUsage();
 std::optional<adlx_double> getSystemRAM();
+std::optional<adlx_double> getFPS();
+std::optional<adlx_double> getAverageFPS();
+std::optional<adlx_double> getOnePercentLowFPS();
+std::optional<adlx_double> getPointOnePercentLowFPS();
+std::optional<adlx_double> getFrameTime();
+
+// the sampler's source for the first gpu, waits on the background start when opened
+MetricSource adlxMetricSource();
 
 #endif
@@ -0,0 +1,51 @@
+#ifndef PROMETHEUSEXPORTER_H
+#define PROMETHEUSEXPORTER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// optional http endpoint serving every metric in the prometheus text format on localhost only.
+// the body is rendered once per sample into an immutable buffer that connections share, so a scrape is a
+// pointer copy and a send, and never reaches adlx. one thread serves every connection from a poll loop
+
+// port used when none is given
+const uint16_t defaultPrometheusPort = 9464;
+
+// render the /metrics body for one sample, values indexed by metric id (nullopt metrics are left out)
+std::string renderPrometheusBody(const std::vector<std::optional<double>>& values, uint64_t sampleCount);
+
+class PrometheusExporter {
+public:
+    PrometheusExporter() = default;
+    PrometheusExporter(const PrometheusExporter&) = delete;
+    PrometheusExporter& operator=(const PrometheusExporter&) = delete;
+    ~PrometheusExporter();
+
+    // listen on 127.0.0.1:port and start the server thread
+    bool start(uint16_t port);
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+    // render a new body, called from the sampler after every sample. scrapes in flight keep the old one
+    void publish(const std::vector<std::optional<double>>& values, uint64_t sampleCount);
+
+    // requests answered so far
+    uint64_t getScrapeCount() const { return scrapeCount.load(std::memory_order_relaxed); }
+
+private:
+    void serverLoop();
+
+    std::shared_ptr<const std::string> body; // only accessed with std::atomic_load/atomic_store
+    std::thread server;
+    std::atomic<bool> running = false;
+    std::atomic<bool> stopping = false;
+    std::atomic<uint64_t> scrapeCount = 0;
+    intptr_t listenSocket = -1;
+};
+
+#endif
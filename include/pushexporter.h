@@ -0,0 +1,97 @@
+#ifndef PUSHEXPORTER_H
+#define PUSHEXPORTER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// pushes samples to a local collector instead of being scraped, as statsd gauges or influx line protocol,
+// over udp or appended to a file. the sampler only copies a sample into a bounded queue; a flusher thread
+// drains it every flush interval and packs as many lines as fit into each datagram or write. when the queue
+// is full the oldest sample is dropped, so a dead or slow collector never holds up sampling
+
+enum class PushFormat {
+    StatsD, // easymetrics.<metric>:<value>|g, no timestamps so samples are sent as they are flushed
+    Influx  // one easymetrics_gpu and one easymetrics_system line per sample, nanosecond timestamps
+};
+
+struct PushOptions {
+    PushFormat format = PushFormat::StatsD;
+    std::string host = "127.0.0.1"; // numeric ipv4 address of the collector
+    uint16_t port = 8125;
+    std::string path; // append to this file instead of sending udp when set
+    int flushIntervalMs = 1000;
+    std::size_t maxDatagramBytes = 1432; // fits one ethernet frame, lines are never split across datagrams
+    std::size_t queueSamples = 600; // samples waiting to be flushed before the oldest are dropped
+};
+
+// default collector ports
+const uint16_t defaultStatsDPort = 8125;
+const uint16_t defaultInfluxPort = 8089;
+
+// render the lines for one sample in the given format, values indexed by metric id (nullopt metrics are left out)
+void renderPushLines(PushFormat format, int64_t unixNs, const std::vector<std::optional<double>>& values, std::string& out);
+
+class PushExporter {
+public:
+    PushExporter() = default;
+    PushExporter(const PushExporter&) = delete;
+    PushExporter& operator=(const PushExporter&) = delete;
+    ~PushExporter();
+
+    bool start(const PushOptions& options);
+    // flushes whatever is still queued, then joins the flusher
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+    // queue one sample, called from the sampler. never blocks on the collector
+    void push(int64_t unixNs, const std::vector<std::optional<double>>& values);
+
+    struct Stats {
+        uint64_t samplesQueued = 0;
+        uint64_t samplesDropped = 0; // pushed out of a full queue
+        uint64_t samplesSent = 0;
+        uint64_t writes = 0; // datagrams, or file writes
+        uint64_t bytes = 0;
+        uint64_t sendErrors = 0; // datagrams the socket would not take, their samples are lost
+    };
+    Stats getStats() const;
+
+private:
+    struct QueuedSample {
+        int64_t unixNs = 0;
+        std::vector<std::optional<double>> values;
+    };
+
+    void flushLoop();
+    void flush(std::vector<QueuedSample>& batch);
+    void write(const std::string& data);
+
+    PushOptions options;
+    std::thread flusher;
+    std::atomic<bool> running = false;
+
+    // guarded by queueMutex
+    mutable std::mutex queueMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::deque<QueuedSample> queue;
+    std::vector<QueuedSample> spare; // drained samples handed back so push() reuses their storage
+    Stats stats;
+
+    // only touched by the flusher
+    std::string lines;
+    std::string payload;
+    intptr_t socketHandle = -1;
+    FILE* file = nullptr;
+};
+
+#endif
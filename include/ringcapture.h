@@ -0,0 +1,66 @@
+#ifndef RINGCAPTURE_H
+#define RINGCAPTURE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// crash-safe capture of the most recent samples: a fixed-size ring in a memory-mapped file.
+// each slot is written, stamped with its sequence number and then published through the header's commit count,
+// so whatever the process had committed is in the page cache when it dies, with no flush needed.
+// readRingFile() recovers the committed slots and skips one that was torn mid-write
+class RingCapture {
+public:
+    RingCapture() = default;
+    RingCapture(const RingCapture&) = delete;
+    RingCapture& operator=(const RingCapture&) = delete;
+    ~RingCapture();
+
+    // create (or truncate) the ring file, up to 64 columns
+    bool create(const std::string& path, const std::vector<std::string>& columns, std::size_t slotCount);
+    void close();
+    bool isOpen() const { return base != nullptr; }
+
+    // store one sample in the next slot, overwriting the oldest once the ring is full. called from a single thread
+    void write(double timeSeconds, const std::vector<std::optional<double>>& values);
+
+private:
+    unsigned char* slotAt(uint64_t sequence) const;
+
+    unsigned char* base = nullptr;
+    std::size_t mappedBytes = 0;
+    std::size_t columnCount = 0;
+    std::size_t slotBytes = 0;
+    std::size_t slotCount = 0;
+    std::size_t dataOffset = 0;
+    uint64_t committed = 0;
+
+#if defined(_WIN32)
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+// one committed sample read back from a ring file
+struct RingRecord {
+    uint64_t sequence;
+    double time;
+    std::vector<std::optional<double>> values;
+};
+
+// everything recovered from a ring file, oldest record first
+struct RingContents {
+    std::vector<std::string> columns;
+    int64_t startUnixMs = 0; // wall clock time the capture was created
+    std::vector<RingRecord> records;
+    uint64_t skippedSlots = 0; // committed slots that failed validation (torn by a crash mid-overwrite)
+};
+
+// read a ring file with plain file io, works on the file of a process that has crashed or is still running
+bool readRingFile(const std::string& path, RingContents& contents);
+
+#endif
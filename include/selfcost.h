@@ -0,0 +1,65 @@
+#ifndef SELFCOST_H
+#define SELFCOST_H
+
+#include <cstdint>
+#include <string>
+
+// counters for easy metrics' own overhead, cheap enough to leave on permanently:
+// hot paths only touch thread locals or relaxed atomics, the report is built once per second
+
+// snapshot of the overhead over the last report period
+struct SelfCostReport {
+    double tickP50Ms = 0.0; // sampling tick duration percentiles over the last 60 ticks
+    double tickP99Ms = 0.0;
+    double adlxCallsPerTick = 0.0;
+    double renderFrameMs = 0.0; // average cpu time to build and submit a frame
+    double framesPerSecond = 0.0;
+    double allocationsPerSecond = 0.0;
+    uint64_t residentBytes = 0; // process working set / rss
+    double overlayOpenMs = 0.0; // last overlay open to first frame
+    double adlxDllLoadMs = 0.0; // adlx startup phases, recorded once per run
+    double adlxInitMs = 0.0;
+    double adlxGpuEnumerationMs = 0.0;
+    double adlxFirstSampleMs = 0.0;
+    double mainWindowFramesPerSecond = 0.0; // main window frames built and presented, near 0 while it sits idle
+    double mainWindowFrameMs = 0.0; // average time to build and present one of them
+};
+
+// count an adlx call made by the current thread, folded into the tick on recordSamplingTick
+inline thread_local uint32_t adlxCallsThisTick = 0;
+inline void countADLXCall() { adlxCallsThisTick++; }
+
+// record one sampling tick and the adlx calls the current thread made during it
+void recordSamplingTick(int64_t durationUs);
+
+// record the cpu time of one overlay frame
+void recordRenderFrame(int64_t durationUs);
+
+// record the time to build and present one main window frame
+void recordMainWindowFrame(int64_t durationUs);
+
+// record how long the overlay took from being opened to its first frame
+void recordOverlayOpen(int64_t durationUs);
+
+// record how long each phase of bringing adlx up took
+void recordADLXStartup(int64_t dllLoadUs, int64_t initUs, int64_t gpuEnumerationUs, int64_t firstSampleUs);
+
+// build a new report from the counters accumulated since the last call
+SelfCostReport updateSelfCostReport();
+
+// total heap allocations made by the process so far
+uint64_t getAllocationCount();
+
+// heap allocations not freed yet, to within a batch per thread
+int64_t getLiveAllocationCount();
+
+// current resident memory of the process
+uint64_t getResidentBytes();
+
+// open kernel handles of the process (plus gdi and user objects on windows, file descriptors elsewhere)
+uint64_t getHandleCount();
+
+// three-line summary of a report for the overlay debug panel
+std::string formatSelfCostReport(const SelfCostReport& report);
+
+#endif
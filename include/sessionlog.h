@@ -0,0 +1,89 @@
+#ifndef SESSIONLOG_H
+#define SESSIONLOG_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/columnfile.h"
+
+// file formats for a recorded session
+enum class LogFormat {
+    CSV, // one row per sample, empty fields where a metric had no value
+    Binary, // header with the column names, then per row: f64 time, u64 presence mask, f32 per present value
+    Columnar // chunks of encoded columns with a time index, for long sessions (see columnfile.h)
+};
+
+// when the writer thread forces data to disk
+enum class SyncPolicy {
+    Never, // leave it to the os
+    OnClose,
+    EveryBlock // after every block written, survives power loss up to the last block
+};
+
+struct LogOptions {
+    LogFormat format = LogFormat::CSV;
+    SyncPolicy sync = SyncPolicy::OnClose;
+    std::size_t blockBytes = 256 * 1024; // size of each of the two buffers
+    int flushIntervalMs = 5000; // hand a partly filled block to the writer at least this often, 0 = only when full
+    int precision = 2; // decimals in csv output
+    std::size_t chunkRows = 1024; // rows per chunk in columnar files, a chunk only reaches the file once it is full
+};
+
+// records samples to a file without ever blocking the caller on disk.
+// rows are formatted straight into the front of two preallocated blocks, a writer thread writes the back one.
+// if the writer falls a whole block behind, rows are dropped (and counted) instead of waiting
+class SessionLogger {
+public:
+    SessionLogger() = default;
+    SessionLogger(const SessionLogger&) = delete;
+    SessionLogger& operator=(const SessionLogger&) = delete;
+    ~SessionLogger();
+
+    // create the file and start the writer thread, up to 64 columns
+    bool open(const std::string& path, const std::vector<std::string>& columns, const LogOptions& options);
+
+    // queue one row, values indexed like the columns. called from a single thread
+    void append(double timeSeconds, const std::vector<std::optional<double>>& values);
+
+    // write everything queued, sync if the policy says so and close the file
+    void close();
+
+    bool isOpen() const { return file != nullptr; }
+    uint64_t getDroppedRows() const;
+    uint64_t getBytesWritten() const;
+
+private:
+    void writerLoop();
+    void handOff(); // called with the lock held
+    std::size_t formatRow(char* out, double timeSeconds, const std::vector<std::optional<double>>& values) const;
+    std::size_t maxRowBytes() const;
+    std::size_t writeBlock(const char* data, std::size_t bytes); // called from the writer, or from close() once it has stopped
+
+    std::FILE* file = nullptr;
+    LogOptions options;
+    std::size_t columnCount = 0;
+    ColumnFileWriter columnWriter; // columnar files queue binary rows, the writer thread encodes them
+
+    // front is only touched by append(), back only by the writer while backFull is set
+    std::vector<char> front;
+    std::vector<char> back;
+    std::size_t frontUsed = 0;
+    std::size_t backUsed = 0;
+    bool backFull = false;
+    bool stopping = false;
+    uint64_t lastHandOffMs = 0;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::thread writer;
+
+    uint64_t droppedRows = 0; // guarded by mutex
+    uint64_t bytesWritten = 0;
+};
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef SHAREDMETRICS_H
+#define SHAREDMETRICS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// live samples published to other processes on the same machine through a named shared memory segment
+// ("Local\<name>" on windows, "/<name>" posix shm elsewhere). the segment holds a header with the column
+// names and a short ring of the latest samples. every slot starts with its own seqlock word, odd while the
+// writer is filling it, so the writer never waits on readers and a reader simply retries a slot that changed
+// under it. reading is a copy out of mapped memory, no system call or round trip to the writer
+//
+// layout, little endian:
+//   header   "EMSHM\0\0\0", u32 version, u32 column count, u32 slot bytes, u32 slot count, u32 data offset,
+//            u32 writer running, i64 start unix ms, u64 published sample count
+//   names    64 bytes per column from offset 64, nul terminated
+//   slots    from data offset: u64 seqlock (2n once sample n is complete), f64 time, u64 presence mask, f32 per column
+
+// name the app publishes under
+const char* const sharedMetricsName = "easymetrics";
+
+// one sample as read from the segment
+struct SharedSample {
+    uint64_t sequence = 0; // 1 for the first sample published
+    double time = 0.0; // seconds since the writer started
+    uint64_t mask = 0; // bit i set if column i has a value
+    std::array<float, 64> values = {};
+
+    bool has(std::size_t column) const { return (mask >> column) & 1; }
+};
+
+// creates the segment and publishes samples, called from a single thread
+class SharedMetricsWriter {
+public:
+    SharedMetricsWriter() = default;
+    SharedMetricsWriter(const SharedMetricsWriter&) = delete;
+    SharedMetricsWriter& operator=(const SharedMetricsWriter&) = delete;
+    ~SharedMetricsWriter();
+
+    // up to 64 columns, historySlots samples kept for readers that poll slower than the writer publishes
+    bool create(const std::string& name, const std::vector<std::string>& columns, std::size_t historySlots);
+    void close();
+    bool isOpen() const { return base != nullptr; }
+
+    void publish(double timeSeconds, const std::vector<std::optional<double>>& values);
+
+private:
+    unsigned char* base = nullptr;
+    std::size_t mappedBytes = 0;
+    std::size_t columnCount = 0;
+    std::size_t slotBytes = 0;
+    std::size_t slotCount = 0;
+    std::size_t dataOffset = 0;
+    uint64_t published = 0;
+    std::string segmentName;
+
+#if defined(_WIN32)
+    void* mappingHandle = nullptr;
+#endif
+};
+
+// maps a published segment read only, any number of readers in any number of processes
+class SharedMetricsReader {
+public:
+    SharedMetricsReader() = default;
+    SharedMetricsReader(const SharedMetricsReader&) = delete;
+    SharedMetricsReader& operator=(const SharedMetricsReader&) = delete;
+    ~SharedMetricsReader();
+
+    // false if nothing is published under the name yet
+    bool open(const std::string& name);
+    void close();
+    bool isOpen() const { return base != nullptr; }
+
+    const std::vector<std::string>& getColumns() const { return columns; }
+    int64_t getStartUnixMs() const;
+
+    // false once the writer has closed the segment. reopen when it is, or when the start time changes
+    // (on windows a new writer takes over a segment that readers of the previous one kept alive)
+    bool isWriterRunning() const;
+
+    // samples published so far
+    uint64_t getSampleCount() const;
+
+    // copy the newest sample, false if there is none yet
+    bool readLatest(SharedSample& sample) const;
+
+    // append every sample newer than afterSequence still in the ring, oldest first.
+    // returns how many newer samples were missed because the writer had already overwritten them
+    uint64_t readSince(uint64_t afterSequence, std::vector<SharedSample>& samples) const;
+
+private:
+    bool readSlot(uint64_t sequence, SharedSample& sample) const;
+
+    const unsigned char* base = nullptr;
+    std::size_t mappedBytes = 0;
+    std::size_t columnCount = 0;
+    std::size_t slotBytes = 0;
+    std::size_t slotCount = 0;
+    std::size_t dataOffset = 0;
+    std::vector<std::string> columns;
+
+#if defined(_WIN32)
+    void* mappingHandle = nullptr;
+#endif
+};
+
+#endif
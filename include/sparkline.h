@@ -0,0 +1,46 @@
+#ifndef SPARKLINE_H
+#define SPARKLINE_H
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+// mini time-series graph drawn beside an overlay metric
+// samples live in a ring buffer and the geometry in a vertex buffer that is only ever
+// patched one sample at a time, scrolling is done with the transform instead of rebuilding
+class Sparkline : public sf::Drawable {
+public:
+    Sparkline(std::size_t capacity, sf::Vector2f position, sf::Vector2f size, sf::Color color);
+
+    // add the newest sample, dropping the oldest once the ring is full
+    void push(float value);
+    void clear();
+
+    void setPosition(sf::Vector2f position);
+    void setColor(sf::Color color);
+    std::size_t getCapacity() const { return capacity; }
+
+private:
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+    void writeVertex(std::size_t slot, float value);
+
+    std::size_t capacity;
+    std::vector<float> samples; // ring buffer of raw values
+    std::size_t head = 0; // slot the next sample is written to
+    std::size_t count = 0; // number of valid samples
+
+    // each sample is stored twice (slot and slot + capacity) so the last n samples
+    // are always one contiguous range of the buffer
+    sf::VertexBuffer vertices;
+    bool useVertexBuffer;
+    std::vector<sf::Vertex> fallbackVertices; // used when vertex buffers are not available
+
+    sf::Vector2f position;
+    sf::Vector2f size;
+    sf::Color color;
+
+    // vertical range of the samples currently in the ring
+    float minValue = 0.f;
+    float maxValue = 1.f;
+};
+
+#endif
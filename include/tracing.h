@@ -0,0 +1,49 @@
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// scoped trace spans written as chrome trace events (open in ui.perfetto.dev or chrome://tracing).
+// every thread appends to its own fixed ring with no locks, a dump copies the rings without stopping anyone.
+// while tracing is off a span is one relaxed load and a branch
+
+extern std::atomic<bool> tracingEnabled;
+
+// nanoseconds on the steady clock, the time base of every span
+inline int64_t traceClockNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// append a finished span to the calling thread's ring. name must outlive the trace (a literal or a static table)
+void recordTraceSpan(const char* name, int64_t startNs, int64_t endNs);
+
+// name the calling thread in the trace
+void setTraceThreadName(const char* name);
+
+// start/stop recording spans, what was recorded stays until it is overwritten
+void setTracingEnabled(bool enabled);
+
+// write the newest spans of every thread as chrome trace event json
+bool writeTraceFile(const std::string& path);
+
+// records the span from construction to the end of its scope, if tracing was on when it started
+class TraceScope {
+public:
+    explicit TraceScope(const char* spanName)
+        : name(spanName), startNs(tracingEnabled.load(std::memory_order_relaxed) ? traceClockNs() : 0) {}
+    ~TraceScope() {
+        if (startNs != 0)
+            recordTraceSpan(name, startNs, traceClockNs());
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    int64_t startNs;
+};
+
+#endif
@@ -0,0 +1,602 @@
+#include "../include/columnfile.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+static const char fileMagic[8] = { 'E', 'M', 'C', 'O', 'L', 0, 0, 0 };
+static const uint32_t fileVersion = 1;
+static const uint32_t chunkMagic = 0x4b434d45; // "EMCK"
+static const uint32_t indexMagic = 0x58494d45; // "EMIX"
+
+// u32 magic, u32 rows, u64 chunk bytes, i64 first time, i64 last time, u32 time bytes, u32 footer offset
+const std::size_t chunkHeaderBytes = 40;
+const std::size_t statsBytes = 20;
+const std::size_t indexEntryBytes = 24;
+const std::size_t trailerBytes = 16;
+
+#pragma region Encoding helpers
+
+template <typename T>
+static void put(std::vector<unsigned char>& out, std::size_t at, T value) {
+    std::memcpy(out.data() + at, &value, sizeof(value));
+}
+
+template <typename T>
+static T get(const unsigned char* in) {
+    T value;
+    std::memcpy(&value, in, sizeof(value));
+    return value;
+}
+
+template <typename T>
+static bool readValue(std::FILE* file, T& value) {
+    return std::fread(&value, sizeof(value), 1, file) == 1;
+}
+
+static bool seekTo(std::FILE* file, uint64_t offset) {
+#if defined(_WIN32)
+    return _fseeki64(file, static_cast<long long>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+static uint64_t fileSize(std::FILE* file) {
+#if defined(_WIN32)
+    _fseeki64(file, 0, SEEK_END);
+    long long size = _ftelli64(file);
+#else
+    fseeko(file, 0, SEEK_END);
+    off_t size = ftello(file);
+#endif
+    return size > 0 ? static_cast<uint64_t>(size) : 0;
+}
+
+static int64_t toMicroseconds(double seconds) {
+    return static_cast<int64_t>(std::llround(seconds * 1e6));
+}
+
+// zigzag varints for the time deltas, small in magnitude either side of zero
+static void putVarint(std::vector<unsigned char>& out, int64_t value) {
+    uint64_t zigzag = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    while (zigzag >= 0x80) {
+        out.push_back(static_cast<unsigned char>(zigzag | 0x80));
+        zigzag >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(zigzag));
+}
+
+static int64_t getVarint(const unsigned char*& p, const unsigned char* end) {
+    uint64_t zigzag = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        unsigned char byte = *p++;
+        zigzag |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            break;
+    }
+    return static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+}
+
+static int leadingZeros(uint32_t x) {
+    int count = 0;
+    for (uint32_t bit = 0x80000000u; bit && !(x & bit); bit >>= 1)
+        count++;
+    return count;
+}
+
+static int trailingZeros(uint32_t x) {
+    int count = 0;
+    for (uint32_t bit = 1; bit && !(x & bit); bit <<= 1)
+        count++;
+    return count;
+}
+
+// msb first bit stream appended to a byte vector
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<unsigned char>& out) : out(out) {}
+
+    // count <= 32
+    void write(uint32_t value, int count) {
+        pending = (pending << count) | (value & lowBits(count));
+        used += count;
+        while (used >= 8) {
+            used -= 8;
+            out.push_back(static_cast<unsigned char>(pending >> used));
+        }
+    }
+
+    void flush() {
+        if (used > 0)
+            out.push_back(static_cast<unsigned char>(pending << (8 - used)));
+        pending = 0;
+        used = 0;
+    }
+
+    static uint32_t lowBits(int count) {
+        return count >= 32 ? 0xffffffffu : (1u << count) - 1;
+    }
+
+private:
+    std::vector<unsigned char>& out;
+    uint64_t pending = 0;
+    int used = 0;
+};
+
+// reads a BitWriter stream a byte at a time into a 64 bit buffer, zeros past the end
+class BitReader {
+public:
+    BitReader(const unsigned char* data, std::size_t bytes) : data(data), bytes(bytes) {}
+
+    // count <= 32
+    uint32_t read(int count) {
+        while (available < count) {
+            buffered = (buffered << 8) | (position < bytes ? data[position] : 0);
+            position++;
+            available += 8;
+        }
+        available -= count;
+        return static_cast<uint32_t>(buffered >> available) & BitWriter::lowBits(count);
+    }
+
+private:
+    const unsigned char* data;
+    std::size_t bytes;
+    std::size_t position = 0;
+    uint64_t buffered = 0;
+    int available = 0;
+};
+
+// gorilla style xor encoding of f32 bits: a 0 bit for a repeated value, otherwise the xor with the previous value,
+// either inside the previous leading/trailing zero window or with a new 5 bit leading count and 5 bit length
+static void encodeValues(std::vector<unsigned char>& out, const std::vector<float>& values) {
+    BitWriter bits(out);
+    uint32_t previous = 0;
+    int windowLead = -1;
+    int windowTrail = 0;
+    for (std::size_t i = 0; i < values.size(); i++) {
+        uint32_t current;
+        std::memcpy(&current, &values[i], sizeof(current));
+        if (i == 0) {
+            bits.write(current, 32);
+            previous = current;
+            continue;
+        }
+
+        uint32_t x = current ^ previous;
+        previous = current;
+        if (!x) {
+            bits.write(0, 1);
+            continue;
+        }
+
+        int lead = leadingZeros(x);
+        int trail = trailingZeros(x);
+        if (windowLead >= 0 && lead >= windowLead && trail >= windowTrail) {
+            bits.write(2, 2);
+            bits.write(x >> windowTrail, 32 - windowLead - windowTrail);
+        }
+        else {
+            int length = 32 - lead - trail;
+            bits.write(3, 2);
+            bits.write(static_cast<uint32_t>(lead), 5);
+            bits.write(static_cast<uint32_t>(length - 1), 5);
+            bits.write(x >> trail, length);
+            windowLead = lead;
+            windowTrail = trail;
+        }
+    }
+    bits.flush();
+}
+
+static void decodeValues(const unsigned char* data, std::size_t bytes, std::size_t count, std::vector<float>& values) {
+    BitReader bits(data, bytes);
+    values.resize(count);
+    uint32_t previous = 0;
+    int windowLead = 0;
+    int windowTrail = 0;
+    for (std::size_t i = 0; i < count; i++) {
+        if (i == 0)
+            previous = bits.read(32);
+        else if (bits.read(1)) {
+            if (bits.read(1)) {
+                windowLead = static_cast<int>(bits.read(5));
+                windowTrail = 32 - windowLead - (static_cast<int>(bits.read(5)) + 1);
+                if (windowTrail < 0)
+                    windowTrail = 0;
+            }
+            previous ^= bits.read(32 - windowLead - windowTrail) << windowTrail;
+        }
+        std::memcpy(&values[i], &previous, sizeof(previous));
+    }
+}
+
+#pragma endregion
+
+#pragma region Writer
+
+std::size_t ColumnFileWriter::begin(std::FILE* outFile, const std::vector<std::string>& columnNames, std::size_t rowsPerChunk) {
+    if (!outFile || columnNames.size() > 64 || rowsPerChunk == 0)
+        return 0;
+
+    file = outFile;
+    columnCount = columnNames.size();
+    chunkRows = rowsPerChunk;
+    times.clear();
+    masks.clear();
+    columnValues.assign(columnCount, std::vector<float>());
+    index.clear();
+
+    uint32_t count = static_cast<uint32_t>(columnCount);
+    uint32_t rows = static_cast<uint32_t>(chunkRows);
+    std::fwrite(fileMagic, 1, sizeof(fileMagic), file);
+    std::fwrite(&fileVersion, sizeof(fileVersion), 1, file);
+    std::fwrite(&count, sizeof(count), 1, file);
+    std::fwrite(&rows, sizeof(rows), 1, file);
+    fileOffset = sizeof(fileMagic) + sizeof(fileVersion) + sizeof(count) + sizeof(rows);
+    for (const std::string& name : columnNames) {
+        uint16_t length = static_cast<uint16_t>(name.size());
+        std::fwrite(&length, sizeof(length), 1, file);
+        std::fwrite(name.data(), 1, length, file);
+        fileOffset += sizeof(length) + length;
+    }
+    return static_cast<std::size_t>(fileOffset);
+}
+
+std::size_t ColumnFileWriter::append(double timeSeconds, uint64_t mask, const float* values) {
+    if (!file)
+        return 0;
+
+    times.push_back(toMicroseconds(timeSeconds));
+    masks.push_back(mask);
+    for (std::size_t c = 0; c < columnCount; c++)
+        if (mask & (uint64_t(1) << c))
+            columnValues[c].push_back(values[c]);
+
+    return times.size() >= chunkRows ? writeChunk() : 0;
+}
+
+std::size_t ColumnFileWriter::writeChunk() {
+    std::size_t rows = times.size();
+    if (rows == 0)
+        return 0;
+
+    encoded.assign(chunkHeaderBytes, 0);
+
+    // timestamps as delta of delta, 1 byte per row when the interval is steady
+    int64_t previousDelta = 0;
+    for (std::size_t i = 1; i < rows; i++) {
+        int64_t delta = times[i] - times[i - 1];
+        putVarint(encoded, delta - previousDelta);
+        previousDelta = delta;
+    }
+    uint32_t timeBytes = static_cast<uint32_t>(encoded.size() - chunkHeaderBytes);
+
+    // each column on its own: a presence bitmap if some rows lack a value, then the present values
+    std::vector<ColumnStats> stats(columnCount);
+    for (std::size_t c = 0; c < columnCount; c++) {
+        const std::vector<float>& values = columnValues[c];
+        ColumnStats& column = stats[c];
+        column.offset = static_cast<uint32_t>(encoded.size());
+        column.present = static_cast<uint32_t>(values.size());
+        column.min = values.empty() ? NAN : values[0];
+        column.max = column.min;
+        for (float value : values) {
+            column.min = std::min(column.min, value);
+            column.max = std::max(column.max, value);
+        }
+
+        if (!values.empty() && values.size() < rows) {
+            std::size_t bitmapAt = encoded.size();
+            encoded.resize(bitmapAt + (rows + 7) / 8, 0);
+            for (std::size_t r = 0; r < rows; r++)
+                if (masks[r] & (uint64_t(1) << c))
+                    encoded[bitmapAt + r / 8] |= static_cast<unsigned char>(1 << (r % 8));
+        }
+        encodeValues(encoded, values);
+        column.bytes = static_cast<uint32_t>(encoded.size() - column.offset);
+    }
+
+    // footer
+    uint32_t footerOffset = static_cast<uint32_t>(encoded.size());
+    encoded.resize(encoded.size() + statsBytes * columnCount);
+    for (std::size_t c = 0; c < columnCount; c++) {
+        std::size_t at = footerOffset + statsBytes * c;
+        put(encoded, at, stats[c].offset);
+        put(encoded, at + 4, stats[c].bytes);
+        put(encoded, at + 8, stats[c].present);
+        put(encoded, at + 12, stats[c].min);
+        put(encoded, at + 16, stats[c].max);
+    }
+
+    // header now that the sizes are known
+    put(encoded, 0, chunkMagic);
+    put(encoded, 4, static_cast<uint32_t>(rows));
+    put(encoded, 8, static_cast<uint64_t>(encoded.size()));
+    put(encoded, 16, times.front());
+    put(encoded, 24, times.back());
+    put(encoded, 32, timeBytes);
+    put(encoded, 36, footerOffset);
+
+    std::fwrite(encoded.data(), 1, encoded.size(), file);
+    index.push_back({ times.front(), times.back(), fileOffset });
+    fileOffset += encoded.size();
+
+    times.clear();
+    masks.clear();
+    for (std::vector<float>& values : columnValues)
+        values.clear();
+    return encoded.size();
+}
+
+std::size_t ColumnFileWriter::finish() {
+    if (!file)
+        return 0;
+
+    std::size_t written = writeChunk();
+
+    uint64_t indexOffset = fileOffset;
+    for (const ChunkInfo& chunk : index) {
+        std::fwrite(&chunk.firstTimeUs, sizeof(chunk.firstTimeUs), 1, file);
+        std::fwrite(&chunk.lastTimeUs, sizeof(chunk.lastTimeUs), 1, file);
+        std::fwrite(&chunk.offset, sizeof(chunk.offset), 1, file);
+    }
+    uint32_t chunkCount = static_cast<uint32_t>(index.size());
+    std::fwrite(&indexOffset, sizeof(indexOffset), 1, file);
+    std::fwrite(&chunkCount, sizeof(chunkCount), 1, file);
+    std::fwrite(&indexMagic, sizeof(indexMagic), 1, file);
+    written += indexEntryBytes * index.size() + trailerBytes;
+
+    file = nullptr;
+    return written;
+}
+
+#pragma endregion
+
+#pragma region Reader
+
+ColumnFileReader::~ColumnFileReader() {
+    close();
+}
+
+bool ColumnFileReader::open(const std::string& path) {
+    close();
+
+#if defined(_WIN32)
+    if (fopen_s(&file, path.c_str(), "rb") != 0)
+        file = nullptr;
+#else
+    file = std::fopen(path.c_str(), "rb");
+#endif
+    if (!file) {
+        std::cout << "Failure: could not open " << path << std::endl;
+        return false;
+    }
+
+    // header
+    char magic[8];
+    uint32_t version = 0, count = 0, rows = 0;
+    if (std::fread(magic, 1, sizeof(magic), file) != sizeof(magic) || std::memcmp(magic, fileMagic, sizeof(magic)) != 0 ||
+        !readValue(file, version) || version != fileVersion || !readValue(file, count) || count > 64 || !readValue(file, rows)) {
+        std::cout << "Failure: " << path << " is not a columnar capture" << std::endl;
+        close();
+        return false;
+    }
+    chunkRows = rows;
+    for (uint32_t i = 0; i < count; i++) {
+        uint16_t length = 0;
+        std::string name;
+        if (readValue(file, length)) {
+            name.resize(length);
+            if (length == 0 || std::fread(&name[0], 1, length, file) == length) {
+                columns.push_back(name);
+                continue;
+            }
+        }
+        close();
+        return false;
+    }
+    uint64_t dataOffset = sizeof(magic) + sizeof(version) + sizeof(count) + sizeof(rows);
+    for (const std::string& name : columns)
+        dataOffset += sizeof(uint16_t) + name.size();
+
+    // index from the trailer, or walk the chunks if the writer never finished
+    fileBytes = fileSize(file);
+    if (fileBytes >= dataOffset + trailerBytes && seekTo(file, fileBytes - trailerBytes)) {
+        uint64_t indexOffset = 0;
+        uint32_t chunkCount = 0, magicValue = 0;
+        if (readValue(file, indexOffset) && readValue(file, chunkCount) && readValue(file, magicValue) && magicValue == indexMagic &&
+            indexOffset >= dataOffset && indexOffset + uint64_t(chunkCount) * indexEntryBytes + trailerBytes == fileBytes &&
+            seekTo(file, indexOffset)) {
+            chunks.resize(chunkCount);
+            indexed = true;
+            for (ChunkInfo& chunk : chunks)
+                if (!readValue(file, chunk.firstTimeUs) || !readValue(file, chunk.lastTimeUs) || !readValue(file, chunk.offset))
+                    indexed = false;
+        }
+    }
+    if (!indexed)
+        return scanChunks(dataOffset);
+    return true;
+}
+
+void ColumnFileReader::close() {
+    if (file)
+        std::fclose(file);
+    file = nullptr;
+    fileBytes = 0;
+    columns.clear();
+    chunks.clear();
+    indexed = false;
+}
+
+// rebuild the index from the chunk headers, stopping at the first incomplete chunk
+bool ColumnFileReader::scanChunks(uint64_t offset) {
+    chunks.clear();
+    unsigned char header[chunkHeaderBytes];
+    while (offset + chunkHeaderBytes <= fileBytes && seekTo(file, offset) &&
+        std::fread(header, 1, chunkHeaderBytes, file) == chunkHeaderBytes) {
+        uint64_t chunkBytes = get<uint64_t>(header + 8);
+        if (get<uint32_t>(header) != chunkMagic || chunkBytes < chunkHeaderBytes || offset + chunkBytes > fileBytes)
+            break;
+        chunks.push_back({ get<int64_t>(header + 16), get<int64_t>(header + 24), offset });
+        offset += chunkBytes;
+    }
+    return true;
+}
+
+// read a chunk's header, footer and timestamps
+bool ColumnFileReader::loadChunk(std::size_t chunkIndex, Chunk& chunk) {
+    uint64_t offset = chunks[chunkIndex].offset;
+    unsigned char header[chunkHeaderBytes];
+    if (!seekTo(file, offset) || std::fread(header, 1, chunkHeaderBytes, file) != chunkHeaderBytes || get<uint32_t>(header) != chunkMagic)
+        return false;
+
+    chunk.rows = get<uint32_t>(header + 4);
+    uint64_t chunkBytes = get<uint64_t>(header + 8);
+    uint32_t timeBytes = get<uint32_t>(header + 32);
+    uint32_t footerOffset = get<uint32_t>(header + 36);
+    std::size_t footerBytes = statsBytes * columns.size();
+    if (chunk.rows == 0 || chunkHeaderBytes + timeBytes > footerOffset || footerOffset + footerBytes > chunkBytes)
+        return false;
+
+    // times follow the header directly
+    buffer.resize(timeBytes);
+    if (timeBytes > 0 && std::fread(buffer.data(), 1, timeBytes, file) != timeBytes)
+        return false;
+    chunk.times.resize(chunk.rows);
+    chunk.times[0] = get<int64_t>(header + 16);
+    const unsigned char* p = buffer.data();
+    const unsigned char* end = p + timeBytes;
+    int64_t delta = 0;
+    for (uint32_t i = 1; i < chunk.rows; i++) {
+        delta += getVarint(p, end);
+        chunk.times[i] = chunk.times[i - 1] + delta;
+    }
+
+    buffer.resize(footerBytes);
+    if (!seekTo(file, offset + footerOffset) || std::fread(buffer.data(), 1, footerBytes, file) != footerBytes)
+        return false;
+    chunk.stats.resize(columns.size());
+    for (std::size_t c = 0; c < columns.size(); c++) {
+        const unsigned char* at = buffer.data() + statsBytes * c;
+        ColumnStats& stats = chunk.stats[c];
+        stats.offset = get<uint32_t>(at);
+        stats.bytes = get<uint32_t>(at + 4);
+        stats.present = get<uint32_t>(at + 8);
+        stats.min = get<float>(at + 12);
+        stats.max = get<float>(at + 16);
+        if (stats.offset + uint64_t(stats.bytes) > footerOffset || stats.present > chunk.rows)
+            return false;
+    }
+    return true;
+}
+
+// read and decode one column of a loaded chunk, nan where a row has no value
+bool ColumnFileReader::decodeColumn(std::size_t chunkIndex, const Chunk& chunk, int columnId, std::vector<float>& values) {
+    const ColumnStats& stats = chunk.stats[columnId];
+    values.assign(chunk.rows, NAN);
+    if (stats.present == 0)
+        return true;
+
+    buffer.resize(stats.bytes);
+    if (!seekTo(file, chunks[chunkIndex].offset + stats.offset) || std::fread(buffer.data(), 1, stats.bytes, file) != stats.bytes)
+        return false;
+
+    if (stats.present == chunk.rows) {
+        decodeValues(buffer.data(), buffer.size(), chunk.rows, values);
+        return true;
+    }
+
+    std::size_t bitmapBytes = (chunk.rows + 7) / 8;
+    if (bitmapBytes > buffer.size())
+        return false;
+    std::vector<float> present;
+    decodeValues(buffer.data() + bitmapBytes, buffer.size() - bitmapBytes, stats.present, present);
+    std::size_t next = 0;
+    for (uint32_t r = 0; r < chunk.rows && next < present.size(); r++)
+        if (buffer[r / 8] & (1 << (r % 8)))
+            values[r] = present[next++];
+    return true;
+}
+
+// first chunk that ends at or after a time
+std::size_t ColumnFileReader::firstChunkAfter(int64_t timeUs) const {
+    auto it = std::lower_bound(chunks.begin(), chunks.end(), timeUs,
+        [](const ChunkInfo& chunk, int64_t time) { return chunk.lastTimeUs < time; });
+    return static_cast<std::size_t>(it - chunks.begin());
+}
+
+bool ColumnFileReader::read(double beginSeconds, double endSeconds, const std::vector<int>& columnIds, ColumnSlice& slice) {
+    slice.times.clear();
+    slice.values.assign(columnIds.size(), std::vector<float>());
+    if (!file)
+        return false;
+    for (int id : columnIds)
+        if (id < 0 || static_cast<std::size_t>(id) >= columns.size())
+            return false;
+
+    int64_t beginUs = toMicroseconds(beginSeconds);
+    int64_t endUs = toMicroseconds(endSeconds);
+    Chunk chunk;
+    std::vector<float> values;
+    for (std::size_t i = firstChunkAfter(beginUs); i < chunks.size() && chunks[i].firstTimeUs <= endUs; i++) {
+        if (!loadChunk(i, chunk))
+            return false;
+
+        // rows of this chunk inside the range
+        std::size_t first = std::lower_bound(chunk.times.begin(), chunk.times.end(), beginUs) - chunk.times.begin();
+        std::size_t last = std::upper_bound(chunk.times.begin(), chunk.times.end(), endUs) - chunk.times.begin();
+        if (first >= last)
+            continue;
+
+        for (std::size_t r = first; r < last; r++)
+            slice.times.push_back(chunk.times[r] / 1e6);
+        for (std::size_t c = 0; c < columnIds.size(); c++) {
+            if (!decodeColumn(i, chunk, columnIds[c], values))
+                return false;
+            slice.values[c].insert(slice.values[c].end(), values.begin() + first, values.begin() + last);
+        }
+    }
+    return true;
+}
+
+bool ColumnFileReader::summarize(int columnId, double beginSeconds, double endSeconds, float& min, float& max) {
+    if (!file || columnId < 0 || static_cast<std::size_t>(columnId) >= columns.size())
+        return false;
+
+    int64_t beginUs = toMicroseconds(beginSeconds);
+    int64_t endUs = toMicroseconds(endSeconds);
+    bool found = false;
+    Chunk chunk;
+    std::vector<float> values;
+    for (std::size_t i = firstChunkAfter(beginUs); i < chunks.size() && chunks[i].firstTimeUs <= endUs; i++) {
+        if (!loadChunk(i, chunk))
+            return false;
+        const ColumnStats& stats = chunk.stats[columnId];
+        if (stats.present == 0)
+            continue;
+
+        // whole chunk inside the range, the footer has the answer
+        if (chunks[i].firstTimeUs >= beginUs && chunks[i].lastTimeUs <= endUs) {
+            min = found ? std::min(min, stats.min) : stats.min;
+            max = found ? std::max(max, stats.max) : stats.max;
+            found = true;
+            continue;
+        }
+
+        if (!decodeColumn(i, chunk, columnId, values))
+            return false;
+        for (uint32_t r = 0; r < chunk.rows; r++) {
+            if (chunk.times[r] < beginUs || chunk.times[r] > endUs || std::isnan(values[r]))
+                continue;
+            min = found ? std::min(min, values[r]) : values[r];
+            max = found ? std::max(max, values[r]) : values[r];
+            found = true;
+        }
+    }
+    return found;
+}
+
+#pragma endregion
@@ -0,0 +1,127 @@
+#include "../include/driverlatency.h"
+#include "../include/latencyhistogram.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+// one registered call. filled in before registeredCalls is raised, never changed afterwards
+struct DriverCall {
+    std::string name;
+    int metricId = -1;
+    LatencyHistogram histogram;
+};
+
+// only registration locks, recorders and readers see entries below registeredCalls
+static std::mutex registerMutex;
+static std::array<std::unique_ptr<DriverCall>, maxDriverCalls> driverCalls;
+static std::atomic<int> registeredCalls = 0;
+
+int registerDriverCall(const char* name, int metricId) {
+    std::lock_guard<std::mutex> lock(registerMutex);
+    int count = registeredCalls.load(std::memory_order_relaxed);
+    for (int i = 0; i < count; i++) {
+        if (driverCalls[i]->name == name)
+            return i;
+    }
+    if (count == maxDriverCalls)
+        return -1;
+
+    driverCalls[count] = std::make_unique<DriverCall>();
+    driverCalls[count]->name = name;
+    driverCalls[count]->metricId = metricId;
+    registeredCalls.store(count + 1, std::memory_order_release);
+    return count;
+}
+
+void recordDriverCall(int call, int64_t durationNs) {
+    if (call < 0 || call >= registeredCalls.load(std::memory_order_acquire))
+        return;
+    driverCalls[call]->histogram.record(durationNs);
+}
+
+std::vector<DriverCallStats> getDriverCallStats() {
+    std::vector<DriverCallStats> stats;
+    int count = registeredCalls.load(std::memory_order_acquire);
+    for (int i = 0; i < count; i++) {
+        const LatencyHistogram& histogram = driverCalls[i]->histogram;
+        if (histogram.count() == 0)
+            continue;
+        stats.push_back({ driverCalls[i]->name, driverCalls[i]->metricId, histogram.count(), histogram.mean() / 1000.0,
+            histogram.valueAtPercentile(50.0) / 1000.0, histogram.valueAtPercentile(99.0) / 1000.0,
+            histogram.valueAtPercentile(99.9) / 1000.0, histogram.max() / 1000.0 });
+    }
+    return stats;
+}
+
+void resetDriverLatency() {
+    int count = registeredCalls.load(std::memory_order_acquire);
+    for (int i = 0; i < count; i++)
+        driverCalls[i]->histogram.reset();
+}
+
+// one histogram as the percentile distribution hdrhistogram writes, values in microseconds
+static void writeDistribution(std::FILE* file, const DriverCall& call) {
+    const LatencyHistogram& histogram = call.histogram;
+    uint64_t total = 0;
+    double sumSquares = 0.0;
+    double mean = histogram.mean();
+    histogram.forEachBucket([&](int64_t low, int64_t high, uint64_t count) {
+        double middle = (low + high) / 2.0 - mean;
+        sumSquares += middle * middle * count;
+        total += count;
+    });
+
+    std::fprintf(file, "# %s%s%s\n", call.name.c_str(), call.metricId >= 0 ? ", metric " : "",
+        call.metricId >= 0 ? std::to_string(call.metricId).c_str() : "");
+    std::fprintf(file, "%12s %14s %10s %14s\n\n", "Value", "Percentile", "TotalCount", "1/(1-Percentile)");
+
+    // the bucket edges, so every distinct recorded value range shows up once
+    uint64_t seen = 0;
+    histogram.forEachBucket([&](int64_t, int64_t high, uint64_t count) {
+        seen += count;
+        double fraction = static_cast<double>(seen) / total;
+        double valueUs = std::min(high, histogram.max()) / 1000.0;
+        if (fraction < 1.0)
+            std::fprintf(file, "%12.3f %14.12f %10llu %14.2f\n", valueUs, fraction, static_cast<unsigned long long>(seen), 1.0 / (1.0 - fraction));
+        else
+            std::fprintf(file, "%12.3f %14.12f %10llu\n", valueUs, fraction, static_cast<unsigned long long>(seen));
+    });
+
+    std::fprintf(file, "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n", mean / 1000.0, total ? std::sqrt(sumSquares / total) / 1000.0 : 0.0);
+    std::fprintf(file, "#[Max     = %12.3f, Total count    = %12llu]\n", histogram.max() / 1000.0, static_cast<unsigned long long>(total));
+    std::fprintf(file, "#[Buckets = %12d, SubBuckets     = %12d]\n\n", LatencyHistogram::maxValueBits - LatencyHistogram::subBucketBits + 1,
+        1 << LatencyHistogram::subBucketBits);
+}
+
+bool writeDriverLatencyFile(const std::string& path) {
+    std::FILE* file = nullptr;
+#if defined(_WIN32)
+    if (fopen_s(&file, path.c_str(), "wb") != 0)
+        file = nullptr;
+#else
+    file = std::fopen(path.c_str(), "wb");
+#endif
+    if (!file)
+        return false;
+
+    // a summary first, then one distribution per call
+    std::fprintf(file, "# driver call latency in microseconds\n#%-31s %10s %10s %10s %10s %10s %10s\n",
+        "call", "calls", "mean", "p50", "p99", "p99.9", "max");
+    for (const DriverCallStats& call : getDriverCallStats()) {
+        std::fprintf(file, "#%-31s %10llu %10.2f %10.2f %10.2f %10.2f %10.2f\n", call.name.c_str(), static_cast<unsigned long long>(call.calls),
+            call.meanUs, call.p50Us, call.p99Us, call.p999Us, call.maxUs);
+    }
+    std::fprintf(file, "\n");
+
+    int count = registeredCalls.load(std::memory_order_acquire);
+    for (int i = 0; i < count; i++) {
+        if (driverCalls[i]->histogram.count() > 0)
+            writeDistribution(file, *driverCalls[i]);
+    }
+    return std::fclose(file) == 0;
+}
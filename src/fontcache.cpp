@@ -0,0 +1,64 @@
+#include "../include/fontcache.h"
+#include "../include/inter.h"
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <mutex>
+
+static std::mutex cacheMutex;
+static std::map<int, std::shared_ptr<const GlyphAtlas>> atlases;
+
+// unpack a pre-baked size, false if the size was not baked
+static bool loadBakedAtlas(int characterSize, GlyphAtlas& atlas) {
+    const BakedFontSize* baked = findBakedInterSize(characterSize);
+    if (!baked)
+        return false;
+
+    atlas.pixels = getBakedInterPixels(*baked);
+    if (atlas.pixels.empty())
+        return false;
+
+    atlas.characterSize = characterSize;
+    atlas.width = baked->atlasWidth;
+    atlas.height = baked->atlasHeight;
+    for (int i = 0; i < baked->glyphCount; i++) {
+        const BakedGlyph& b = bakedInterGlyphs[baked->firstGlyph + i];
+        AtlasGlyph& g = atlas.glyphs[b.codePoint & 0xFF];
+        g.advance = b.advance;
+        g.left = b.left;
+        g.top = b.top;
+        g.width = b.width;
+        g.height = b.height;
+        g.x = b.x;
+        g.y = b.y;
+    }
+
+    const std::vector<unsigned char>& font = getInterFont();
+    return measureFontLines(font.data(), font.size(), characterSize, atlas);
+}
+
+std::shared_ptr<const GlyphAtlas> acquireGlyphAtlas(int characterSize) {
+    // held while building so two threads asking for the same new size only rasterize it once
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    auto it = atlases.find(characterSize);
+    if (it != atlases.end())
+        return it->second;
+
+    auto atlas = std::make_shared<GlyphAtlas>();
+    if (!loadBakedAtlas(characterSize, *atlas)) {
+        const std::vector<unsigned char>& font = getInterFont();
+        if (!rasterizeGlyphAtlas(font.data(), font.size(), characterSize, *atlas)) {
+            std::cout << "Failure: could not rasterize the font at size " << characterSize << std::endl;
+            return nullptr;
+        }
+    }
+
+    atlases[characterSize] = atlas;
+    return atlas;
+}
+
+int glyphAtlasSizeForPixelHeight(float pixelHeight) {
+    const std::vector<unsigned char>& font = getInterFont();
+    return static_cast<int>(std::lround(emSizeForPixelHeight(font.data(), font.size(), pixelHeight)));
+}
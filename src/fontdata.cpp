@@ -0,0 +1,33 @@
+#include "../include/inter.h"
+#include "../include/lz.h"
+#include <iostream>
+
+const std::vector<unsigned char>& getInterFont() {
+    // static init is thread safe, the main window and overlay thread can both ask for it
+    static const std::vector<unsigned char> font = [] {
+        std::vector<unsigned char> data(Inter_UI_Regular_otf_len);
+        if (!lzDecompress(Inter_UI_Regular_otf_lz, Inter_UI_Regular_otf_lz_len, data.data(), data.size())) {
+            std::cout << "Failure: embedded font is corrupt" << std::endl;
+            data.clear();
+        }
+        return data;
+    }();
+    return font;
+}
+
+const BakedFontSize* findBakedInterSize(int characterSize) {
+    for (int i = 0; i < bakedInterSizeCount; i++) {
+        if (bakedInterSizes[i].characterSize == characterSize)
+            return &bakedInterSizes[i];
+    }
+    return nullptr;
+}
+
+std::vector<unsigned char> getBakedInterPixels(const BakedFontSize& size) {
+    std::vector<unsigned char> pixels(static_cast<size_t>(size.atlasWidth) * size.atlasHeight);
+    if (!lzDecompress(bakedInterPixels_lz + size.pixelsOffset, size.pixelsLength, pixels.data(), pixels.size())) {
+        std::cout << "Failure: embedded glyph atlas is corrupt" << std::endl;
+        pixels.clear();
+    }
+    return pixels;
+}
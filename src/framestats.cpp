@@ -0,0 +1,128 @@
+#include "../include/framestats.h"
+#include <algorithm>
+#include <cmath>
+
+FrameTimeStats::FrameTimeStats(double windowMs, double binResolutionMs, double maxFrameTimeMs)
+    : windowMs(windowMs), binResolutionMs(binResolutionMs) {
+    uint32_t bins = static_cast<uint32_t>(std::ceil(maxFrameTimeMs / binResolutionMs)) + 1;
+    tree.assign(bins + 1, 0);
+    binTree.assign(bins + 1, 0);
+
+    treeMask = 1;
+    while ((treeMask << 1) <= bins)
+        treeMask <<= 1;
+}
+
+// add a frame time sample and drop whatever fell out of the window
+void FrameTimeStats::addSample(int64_t timestampMs, double frameTimeMs, uint32_t frames) {
+    if (frameTimeMs <= 0.0 || frames == 0)
+        return;
+
+    uint32_t lastBin = static_cast<uint32_t>(tree.size() - 2);
+    uint32_t bin = std::min(lastBin, static_cast<uint32_t>(frameTimeMs / binResolutionMs));
+
+    window.push_back({ timestampMs, bin, frames, frameTimeMs });
+    addToBin(bin, frames);
+    totalFrames += frames;
+    totalTimeMs += frameTimeMs * frames;
+
+    evictOlderThan(timestampMs - static_cast<int64_t>(windowMs));
+}
+
+void FrameTimeStats::clear() {
+    std::fill(tree.begin(), tree.end(), 0);
+    std::fill(binTree.begin(), binTree.end(), 0);
+    window.clear();
+    totalFrames = 0;
+    totalTimeMs = 0.0;
+}
+
+double FrameTimeStats::getAverageFPS() const {
+    return totalTimeMs > 0.0 ? totalFrames * 1000.0 / totalTimeMs : 0.0;
+}
+
+double FrameTimeStats::getAverageFrameTime() const {
+    return totalFrames > 0 ? totalTimeMs / totalFrames : 0.0;
+}
+
+// walk the fenwick tree to the bin holding the requested rank
+double FrameTimeStats::getPercentileFrameTime(double fraction) const {
+    if (totalFrames == 0)
+        return 0.0;
+
+    uint64_t rank = static_cast<uint64_t>(std::ceil(fraction * totalFrames));
+    rank = std::clamp<uint64_t>(rank, 1, totalFrames);
+
+    // report the middle of the bin
+    return (findBin(rank) + 0.5) * binResolutionMs;
+}
+
+// the slowest count frames are every frame in the bins above the one holding the first of them,
+// plus as many as are still missing from that bin
+double FrameTimeStats::getSlowestFramesMeanTime(double fraction) const {
+    if (totalFrames == 0)
+        return 0.0;
+
+    // 1% of 1000 frames is 10, not 11 from the rounding error in the product
+    uint64_t count = static_cast<uint64_t>(std::ceil(fraction * totalFrames - 1e-9));
+    count = std::clamp<uint64_t>(count, 1, totalFrames);
+
+    uint32_t bin = findBin(totalFrames - count + 1);
+    uint64_t framesAbove = totalFrames - prefixSum(tree, bin);
+    uint64_t binsAbove = prefixSum(binTree, static_cast<uint32_t>(tree.size() - 2)) - prefixSum(binTree, bin);
+
+    // frame times are the middle of their bin, as for the percentiles
+    double sumBins = static_cast<double>(binsAbove) + static_cast<double>(count - framesAbove) * bin;
+    return (sumBins / count + 0.5) * binResolutionMs;
+}
+
+double FrameTimeStats::getOnePercentLowFPS() const {
+    double frameTime = getSlowestFramesMeanTime(0.01);
+    return frameTime > 0.0 ? 1000.0 / frameTime : 0.0;
+}
+
+double FrameTimeStats::getPointOnePercentLowFPS() const {
+    double frameTime = getSlowestFramesMeanTime(0.001);
+    return frameTime > 0.0 ? 1000.0 / frameTime : 0.0;
+}
+
+void FrameTimeStats::evictOlderThan(int64_t timestampMs) {
+    while (!window.empty() && window.front().timestampMs < timestampMs) {
+        const Sample& old = window.front();
+        addToBin(old.bin, -static_cast<int64_t>(old.frames));
+        totalFrames -= old.frames;
+        totalTimeMs -= old.frameTimeMs * old.frames;
+        window.pop_front();
+    }
+
+    // avoid drift from the running floating point sum
+    if (window.empty())
+        totalTimeMs = 0.0;
+}
+
+void FrameTimeStats::addToBin(uint32_t bin, int64_t delta) {
+    for (size_t i = bin + 1; i < tree.size(); i += i & (~i + 1)) {
+        tree[i] += delta;
+        binTree[i] += delta * static_cast<int64_t>(bin);
+    }
+}
+
+// total of bins 0..bin
+uint64_t FrameTimeStats::prefixSum(const std::vector<uint64_t>& fenwick, uint32_t bin) const {
+    uint64_t sum = 0;
+    for (size_t i = bin + 1; i > 0; i -= i & (~i + 1))
+        sum += fenwick[i];
+    return sum;
+}
+
+// smallest bin whose cumulative frame count reaches rank
+uint32_t FrameTimeStats::findBin(uint64_t rank) const {
+    size_t pos = 0;
+    for (size_t step = treeMask; step > 0; step >>= 1) {
+        if (pos + step < tree.size() && tree[pos + step] < rank) {
+            pos += step;
+            rank -= tree[pos];
+        }
+    }
+    return static_cast<uint32_t>(pos);
+}
@@ -0,0 +1,99 @@
+#include "../include/glyphatlas.h"
+#include <algorithm>
+#include <cmath>
+
+#define STB_TRUETYPE_IMPLEMENTATION
+#define STBTT_STATIC
+#include "../dependencies/imgui/include/imstb_truetype.h"
+
+// padding around each glyph so smoothing never samples a neighbour, same as sf::Font
+const int padding = 2;
+
+const std::vector<int>& atlasCodePoints() {
+    static const std::vector<int> codePoints = [] {
+        std::vector<int> cps;
+        for (int c = 0x20; c < 0x7F; c++)
+            cps.push_back(c);
+        cps.push_back(0xB0);
+        return cps;
+    }();
+    return codePoints;
+}
+
+static bool initFont(const unsigned char* otf, size_t otfSize, stbtt_fontinfo& font) {
+    return otfSize > 0 && stbtt_InitFont(&font, otf, stbtt_GetFontOffsetForIndex(otf, 0));
+}
+
+// freetype's metrics.height, which sf::Font reports as the line spacing
+static void setLineMetrics(const stbtt_fontinfo& font, float scale, GlyphAtlas& atlas) {
+    int ascent, descent, lineGap;
+    stbtt_GetFontVMetrics(&font, &ascent, &descent, &lineGap);
+    atlas.ascent = ascent * scale;
+    atlas.lineSpacing = std::round((ascent - descent + lineGap) * scale);
+}
+
+bool rasterizeGlyphAtlas(const unsigned char* otf, size_t otfSize, int characterSize, GlyphAtlas& atlas) {
+    stbtt_fontinfo font;
+    if (!initFont(otf, otfSize, font))
+        return false;
+
+    // freetype pixel sizes are per em, not per ascent + descent
+    float scale = stbtt_ScaleForMappingEmToPixels(&font, static_cast<float>(characterSize));
+    atlas.characterSize = characterSize;
+    atlas.width = characterSize <= 16 ? 256 : 512;
+    atlas.glyphs.fill(AtlasGlyph{});
+    setLineMetrics(font, scale, atlas);
+
+    // shelf packing in code point order, the glyphs are all about the same height
+    int penX = 0, penY = 0, shelfHeight = 0;
+    for (int cp : atlasCodePoints()) {
+        int advance, lsb, x0, y0, x1, y1;
+        stbtt_GetCodepointHMetrics(&font, cp, &advance, &lsb);
+        stbtt_GetCodepointBitmapBox(&font, cp, scale, scale, &x0, &y0, &x1, &y1);
+
+        AtlasGlyph& g = atlas.glyphs[cp];
+        g.advance = std::round(advance * scale);
+        g.left = x0;
+        g.top = y0;
+        g.width = x1 - x0;
+        g.height = y1 - y0;
+
+        int cellWidth = g.width + padding * 2;
+        int cellHeight = g.height + padding * 2;
+        if (penX + cellWidth > atlas.width) {
+            penX = 0;
+            penY += shelfHeight;
+            shelfHeight = 0;
+        }
+        g.x = penX + padding;
+        g.y = penY + padding;
+        penX += cellWidth;
+        shelfHeight = std::max(shelfHeight, cellHeight);
+    }
+    atlas.height = (penY + shelfHeight + 3) & ~3;
+
+    atlas.pixels.assign(static_cast<size_t>(atlas.width) * atlas.height, 0);
+    for (int cp : atlasCodePoints()) {
+        const AtlasGlyph& g = atlas.glyphs[cp];
+        if (g.width > 0 && g.height > 0)
+            stbtt_MakeCodepointBitmap(&font, &atlas.pixels[static_cast<size_t>(g.y) * atlas.width + g.x], g.width, g.height, atlas.width, scale, scale, cp);
+    }
+    return true;
+}
+
+bool measureFontLines(const unsigned char* otf, size_t otfSize, int characterSize, GlyphAtlas& atlas) {
+    stbtt_fontinfo font;
+    if (!initFont(otf, otfSize, font))
+        return false;
+
+    setLineMetrics(font, stbtt_ScaleForMappingEmToPixels(&font, static_cast<float>(characterSize)), atlas);
+    return true;
+}
+
+float emSizeForPixelHeight(const unsigned char* otf, size_t otfSize, float pixelHeight) {
+    stbtt_fontinfo font;
+    if (!initFont(otf, otfSize, font))
+        return pixelHeight;
+
+    return pixelHeight * stbtt_ScaleForPixelHeight(&font, 1.f) / stbtt_ScaleForMappingEmToPixels(&font, 1.f);
+}
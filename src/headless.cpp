@@ -0,0 +1,332 @@
+#include "../include/headless.h"
+#include "../include/driverlatency.h"
+#include "../include/metricformat.h"
+#include "../include/metricsampler.h"
+#include "../include/metricsource.h"
+#include "../include/prometheusexporter.h"
+#include "../include/selfcost.h"
+#include "../include/sharedmetrics.h"
+#include "../include/tracing.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include "../include/performancemonitor.h"
+#endif
+
+struct HeadlessOptions {
+#if defined(_WIN32)
+    std::string source = "adlx";
+#else
+    std::string source = "sysfs";
+#endif
+    std::vector<bool> selected; // per metric id
+    int intervalMs = sampleIntervalMs;
+    int gpu = 0;
+    std::string output; // recorded to this file, or printed when empty
+    double durationSeconds = 0.0; // until interrupted when 0
+    int servePort = 0;
+    std::string push; // statsd or influx, optionally followed by :host:port
+    bool publish = false;
+    std::string trace; // chrome trace of the sampler written here on exit
+    std::string latency; // driver call latency histograms written here on exit
+    uint64_t seed = 1;
+    bool quiet = false;
+};
+
+// set from the ctrl+c handler, the main loop notices within one wait
+static std::atomic<bool> interrupted = false;
+
+static void onInterrupt(int) {
+    interrupted = true;
+}
+
+#pragma region Options
+
+static void printUsage() {
+    std::cout << "usage: easymetrics --headless [options]\n"
+        << "  --source NAME      adlx (windows), sysfs (linux) or fake\n"
+        << "  --metrics A,B,...  metric keys to read, default all (see below)\n"
+        << "  --interval MS      time between samples (default " << sampleIntervalMs << ")\n"
+        << "  --gpu N            card index for sysfs, adlx reads the first gpu\n"
+        << "  --output PATH      record to a .csv, .bin or .emc file instead of printing csv\n"
+        << "  --duration S       stop after this many seconds of samples, default until ctrl+c\n"
+        << "  --serve PORT       serve prometheus metrics on 127.0.0.1:PORT\n"
+        << "  --push FMT[:H:P]   push to statsd or influx over udp, default 127.0.0.1 and port\n"
+        << "  --publish          publish to shared memory as the app does\n"
+        << "  --trace PATH       write a chrome trace of every sample and getter on exit\n"
+        << "  --latency PATH     write the driver call latency histograms (.hgrm) on exit\n"
+        << "  --seed N           seed for the fake source\n"
+        << "  --quiet            no summary on exit\n"
+        << "metrics:";
+    for (const MetricName& name : getMetricNames())
+        std::cout << ' ' << name.key;
+    std::cout << std::endl;
+}
+
+// comma separated metric keys, false if one is unknown
+static bool parseMetrics(const std::string& list, std::vector<bool>& selected) {
+    const std::vector<MetricName>& names = getMetricNames();
+    selected.assign(names.size(), false);
+    std::size_t begin = 0;
+    while (begin <= list.size()) {
+        std::size_t end = list.find(',', begin);
+        if (end == std::string::npos)
+            end = list.size();
+        std::string key = list.substr(begin, end - begin);
+        bool found = false;
+        for (std::size_t i = 0; i < names.size(); i++) {
+            if (key == names[i].key) {
+                selected[i] = found = true;
+                break;
+            }
+        }
+        if (!found) {
+            std::cout << "Failure: unknown metric " << key << std::endl;
+            return false;
+        }
+        begin = end + 1;
+    }
+    return true;
+}
+
+static bool parseOptions(int argc, char** argv, HeadlessOptions& options) {
+    options.selected.assign(getMetricNames().size(), true);
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--headless"))
+            continue;
+        else if (!std::strcmp(argv[i], "--source") && hasValue)
+            options.source = argv[++i];
+        else if (!std::strcmp(argv[i], "--metrics") && hasValue) {
+            if (!parseMetrics(argv[++i], options.selected))
+                return false;
+        }
+        else if (!std::strcmp(argv[i], "--interval") && hasValue)
+            options.intervalMs = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--gpu") && hasValue)
+            options.gpu = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--output") && hasValue)
+            options.output = argv[++i];
+        else if (!std::strcmp(argv[i], "--duration") && hasValue)
+            options.durationSeconds = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--serve") && hasValue)
+            options.servePort = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--push") && hasValue)
+            options.push = argv[++i];
+        else if (!std::strcmp(argv[i], "--publish"))
+            options.publish = true;
+        else if (!std::strcmp(argv[i], "--trace") && hasValue)
+            options.trace = argv[++i];
+        else if (!std::strcmp(argv[i], "--latency") && hasValue)
+            options.latency = argv[++i];
+        else if (!std::strcmp(argv[i], "--seed") && hasValue)
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--quiet"))
+            options.quiet = true;
+        else
+            return false;
+    }
+    return options.intervalMs > 0 && options.durationSeconds >= 0.0 && options.servePort >= 0 && options.servePort <= 65535;
+}
+
+// statsd or influx, then an optional :host:port
+static bool parsePush(const std::string& text, PushOptions& options) {
+    std::size_t colon = text.find(':');
+    std::string format = text.substr(0, colon);
+    if (format == "statsd") {
+        options.format = PushFormat::StatsD;
+        options.port = defaultStatsDPort;
+    }
+    else if (format == "influx") {
+        options.format = PushFormat::Influx;
+        options.port = defaultInfluxPort;
+    }
+    else
+        return false;
+
+    if (colon != std::string::npos) {
+        std::size_t portColon = text.rfind(':');
+        if (portColon == colon)
+            return false;
+        options.host = text.substr(colon + 1, portColon - colon - 1);
+        options.port = static_cast<uint16_t>(std::atoi(text.c_str() + portColon + 1));
+    }
+    return true;
+}
+
+#pragma endregion
+
+static LogFormat formatForPath(const std::string& path) {
+    std::size_t dot = path.rfind('.');
+    std::string extension = dot == std::string::npos ? "" : path.substr(dot);
+    if (extension == ".bin")
+        return LogFormat::Binary;
+    if (extension == ".emc")
+        return LogFormat::Columnar;
+    return LogFormat::CSV;
+}
+
+// the selected metrics of one sample as a csv row, unread metrics are left out
+static void printRow(double timeSeconds, const std::vector<std::optional<double>>& values, const std::vector<bool>& selected) {
+    char row[1024];
+    int used = std::snprintf(row, sizeof(row), "%.3f", timeSeconds);
+    for (std::size_t i = 0; i < values.size() && used < static_cast<int>(sizeof(row)) - 32; i++) {
+        if (!selected[i])
+            continue;
+        if (values[i].has_value())
+            used += std::snprintf(row + used, sizeof(row) - used, ",%.2f", values[i].value());
+        else
+            used += std::snprintf(row + used, sizeof(row) - used, ",");
+    }
+    std::fputs(row, stdout);
+    std::fputc('\n', stdout);
+    std::fflush(stdout);
+}
+
+int runHeadless(int argc, char** argv) {
+#if defined(_WIN32)
+    // a windows app has no console of its own, write to the one it was started from
+    if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+        FILE* console = nullptr;
+        freopen_s(&console, "CONOUT$", "w", stdout);
+        freopen_s(&console, "CONOUT$", "w", stderr);
+    }
+#endif
+
+    HeadlessOptions options;
+    PushOptions pushOptions;
+    if (!parseOptions(argc, argv, options) || (!options.push.empty() && !parsePush(options.push, pushOptions))) {
+        printUsage();
+        return 2;
+    }
+
+    MetricSource source;
+    if (options.source == "fake")
+        source = fakeMetricSource(options.seed);
+#if defined(_WIN32)
+    else if (options.source == "adlx" && options.gpu == 0)
+        source = adlxMetricSource();
+#else
+    else if (options.source == "sysfs")
+        source = sysfsMetricSource(options.gpu);
+#endif
+    else {
+        std::cout << "Failure: source " << options.source << " with gpu " << options.gpu << " is not available here" << std::endl;
+        return 2;
+    }
+
+    // unselected metrics are never asked for, so they cost nothing per sample
+    for (std::size_t i = 0; i < source.getters.size(); i++) {
+        if (!options.selected[i])
+            source.getters[i] = []() -> std::optional<double> { return std::nullopt; };
+    }
+
+    std::vector<std::string> columns = metricColumnNames();
+    bool print = options.output.empty();
+    if (!print) {
+        LogOptions logOptions;
+        logOptions.format = formatForPath(options.output);
+        if (!startRecording(options.output, columns, logOptions)) {
+            std::cout << "Failure: could not create " << options.output << std::endl;
+            return 1;
+        }
+    }
+    if (options.servePort > 0 && !startMetricsEndpoint(static_cast<uint16_t>(options.servePort)))
+        return 1;
+    if (!options.push.empty() && !startMetricPush(pushOptions))
+        return 1;
+    if (options.publish)
+        startMetricPublishing(sharedMetricsName, columns, 2 * 60 * 1000 / options.intervalMs);
+    if (!options.trace.empty())
+        setTracingEnabled(true);
+
+    if (print) {
+        std::string header = "time (s)";
+        for (std::size_t i = 0; i < columns.size(); i++) {
+            if (options.selected[i])
+                header += "," + columns[i];
+        }
+        std::puts(header.c_str());
+    }
+
+    std::signal(SIGINT, onInterrupt);
+    std::signal(SIGTERM, onInterrupt);
+
+    // no history: a headless run holds one sample at a time however long it goes
+    SamplerOptions samplerOptions;
+    samplerOptions.intervalMs = options.intervalMs;
+    samplerOptions.keepHistory = false;
+    auto start = std::chrono::steady_clock::now();
+    startMetricSampling(std::move(source), samplerOptions);
+
+    // counted in samples rather than wall time, so a run always has the same number of rows
+    uint64_t sampleLimit = static_cast<uint64_t>(std::ceil(options.durationSeconds * 1000.0 / options.intervalMs));
+    uint64_t seen = 0;
+    uint64_t allocationsAfterFirst = 0;
+    std::vector<std::optional<double>> values;
+    while (!interrupted && (sampleLimit == 0 || seen < sampleLimit)) {
+        uint64_t count = waitForSample(seen, 250);
+        if (count == seen) {
+            if (isMetricSamplingStopped())
+                break;
+            continue;
+        }
+        seen = count;
+
+        // everything after the first sample is steady state
+        if (seen == 1) {
+            allocationsAfterFirst = getAllocationCount();
+            updateSelfCostReport();
+        }
+        if (print) {
+            copyLatestSample(values);
+            printRow(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), values, options.selected);
+        }
+    }
+
+    SelfCostReport report = updateSelfCostReport();
+    uint64_t allocations = getAllocationCount() - allocationsAfterFirst;
+    stopMetricSampling();
+    if (!options.trace.empty() && !writeTraceFile(options.trace))
+        std::cout << "Failure: could not write " << options.trace << std::endl;
+    if (!options.latency.empty() && !writeDriverLatencyFile(options.latency))
+        std::cout << "Failure: could not write " << options.latency << std::endl;
+#if defined(_WIN32)
+    if (options.source == "adlx")
+        releaseAndTerminate();
+#endif
+
+    if (seen == 0) {
+        std::cout << "Failure: the " << options.source << " source could not be read" << std::endl;
+        return 1;
+    }
+    if (!options.quiet) {
+        std::fprintf(stderr, "%llu samples, last 60 ticks p50 %.3f ms p99 %.3f ms, %.1f allocations per sample, %.1f MB resident\n",
+            static_cast<unsigned long long>(seen), report.tickP50Ms, report.tickP99Ms,
+            seen > 1 ? static_cast<double>(allocations) / (seen - 1) : 0.0, report.residentBytes / (1024.0 * 1024.0));
+
+        // the most expensive driver call, the fake source makes none
+        std::vector<DriverCallStats> calls = getDriverCallStats();
+        auto slowest = std::max_element(calls.begin(), calls.end(), [](const DriverCallStats& a, const DriverCallStats& b) { return a.p99Us < b.p99Us; });
+        if (slowest != calls.end())
+            std::fprintf(stderr, "slowest driver call %s, p50 %.1f us p99 %.1f us max %.1f us\n", slowest->name.c_str(), slowest->p50Us, slowest->p99Us, slowest->maxUs);
+    }
+    return 0;
+}
+
+#if !defined(_WIN32)
+int main(int argc, char** argv) {
+    return runHeadless(argc, argv);
+}
+#endif
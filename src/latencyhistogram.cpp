@@ -0,0 +1,109 @@
+#include "../include/latencyhistogram.h"
+#include <algorithm>
+#include <cmath>
+
+// bucket index of a duration: the value itself below 2^subBucketBits, above that the power of two
+// and the next subBucketBits bits under its highest set bit
+static int bucketFor(int64_t ns) {
+    uint64_t value = static_cast<uint64_t>(std::max<int64_t>(ns, 0));
+    const int bits = LatencyHistogram::subBucketBits;
+    if (value < (1ull << bits))
+        return static_cast<int>(value);
+
+    int msb = 63;
+    while (!(value & (1ull << msb)))
+        msb--;
+    if (msb >= LatencyHistogram::maxValueBits)
+        return LatencyHistogram::bucketCount - 1;
+    int sub = static_cast<int>((value >> (msb - bits)) & ((1ull << bits) - 1));
+    return ((msb - bits + 1) << bits) + sub;
+}
+
+// lowest and highest duration counted in a bucket
+static void bucketRange(int bucket, int64_t& low, int64_t& high) {
+    const int bits = LatencyHistogram::subBucketBits;
+    if (bucket < (1 << bits)) {
+        low = high = bucket;
+        return;
+    }
+
+    int msb = (bucket >> bits) + bits - 1;
+    int64_t sub = bucket & ((1 << bits) - 1);
+    low = (1ll << msb) + (sub << (msb - bits));
+    high = low + (1ll << (msb - bits)) - 1;
+}
+
+// only the recording thread writes, so a load and a store replace the locked read-modify-writes
+static void increment(std::atomic<uint64_t>& counter, uint64_t amount) {
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::record(int64_t durationNs) {
+    increment(counts[bucketFor(durationNs)], 1);
+    increment(total, 1);
+    increment(sumNs, static_cast<uint64_t>(std::max<int64_t>(durationNs, 0)));
+
+    if (durationNs < minNs.load(std::memory_order_relaxed))
+        minNs.store(durationNs, std::memory_order_relaxed);
+    if (durationNs > maxNs.load(std::memory_order_relaxed))
+        maxNs.store(durationNs, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::reset() {
+    for (std::atomic<uint64_t>& bucket : counts)
+        bucket.store(0, std::memory_order_relaxed);
+    total.store(0, std::memory_order_relaxed);
+    sumNs.store(0, std::memory_order_relaxed);
+    minNs.store(INT64_MAX, std::memory_order_relaxed);
+    maxNs.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::count() const {
+    return total.load(std::memory_order_relaxed);
+}
+
+int64_t LatencyHistogram::min() const {
+    return count() ? minNs.load(std::memory_order_relaxed) : 0;
+}
+
+int64_t LatencyHistogram::max() const {
+    return maxNs.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const {
+    uint64_t n = count();
+    return n ? static_cast<double>(sumNs.load(std::memory_order_relaxed)) / n : 0.0;
+}
+
+int64_t LatencyHistogram::valueAtPercentile(double percentile) const {
+    // counted from the buckets themselves so a record landing meanwhile cannot push the rank past the end
+    uint64_t n = 0;
+    for (const std::atomic<uint64_t>& bucket : counts)
+        n += bucket.load(std::memory_order_relaxed);
+    if (n == 0)
+        return 0;
+
+    uint64_t rank = static_cast<uint64_t>(std::ceil(std::min(100.0, std::max(0.0, percentile)) / 100.0 * n));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (int i = 0; i < bucketCount; i++) {
+        seen += counts[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            int64_t low, high;
+            bucketRange(i, low, high);
+            return std::min(high, max());
+        }
+    }
+    return max();
+}
+
+void LatencyHistogram::forEachBucket(const std::function<void(int64_t lowNs, int64_t highNs, uint64_t count)>& visit) const {
+    for (int i = 0; i < bucketCount; i++) {
+        uint64_t n = counts[i].load(std::memory_order_relaxed);
+        if (n == 0)
+            continue;
+        int64_t low, high;
+        bucketRange(i, low, high);
+        visit(low, high, n);
+    }
+}
@@ -0,0 +1,202 @@
+#include "../include/lodseries.h"
+#include <algorithm>
+#include <cmath>
+
+struct LodSeries::Extremes {
+    float min = NAN;
+    float max = NAN;
+    std::size_t minAt = 0; // first sample of the node each came from, nodes of one range never share a start
+    std::size_t maxAt = 0;
+    bool minFirst = true; // order inside the node when both came from the same one
+
+    void add(float nodeMin, float nodeMax, bool nodeMinFirst, std::size_t start) {
+        if (std::isnan(nodeMin))
+            return;
+        if (std::isnan(min) || nodeMin < min) {
+            min = nodeMin;
+            minAt = start;
+            minFirst = nodeMinFirst;
+        }
+        if (std::isnan(max) || nodeMax > max) {
+            max = nodeMax;
+            maxAt = start;
+            minFirst = nodeMinFirst;
+        }
+    }
+
+    bool minBeforeMax() const {
+        return minAt == maxAt ? minFirst : minAt < maxAt;
+    }
+};
+
+// fold the newest sample into a node, it is later than everything already in it
+static void mergeSample(float value, float& min, float& max, bool& minFirst) {
+    if (std::isnan(value))
+        return;
+
+    if (std::isnan(min)) {
+        min = max = value;
+        minFirst = true;
+    }
+    else if (value < min) {
+        min = value;
+        minFirst = false;
+    }
+    else if (value > max) {
+        max = value;
+        minFirst = true;
+    }
+}
+
+void LodSeries::push(float value) {
+    samples.push_back(value);
+
+    // every level has exactly one node covering the new sample, the last one or a new one
+    std::size_t index = size() - 1;
+    for (std::size_t k = 0; k < levels.size(); k++) {
+        index >>= fanoutBits;
+        std::vector<Node>& level = levels[k];
+        if (index - levelFirst[k] == level.size())
+            level.push_back(Node{ NAN, NAN, true });
+        Node& node = level[index - levelFirst[k]];
+        mergeSample(value, node.min, node.max, node.minFirst);
+    }
+
+    // keep a single node at the top
+    while ((levels.empty() ? size() : levelFirst.back() + levels.back().size()) > 1)
+        addLevel();
+
+    if (capacity > 0 && samples.size() >= capacity + std::max<std::size_t>(capacity / 4, 1))
+        dropOldest();
+}
+
+void LodSeries::clear() {
+    first = 0;
+    samples.clear();
+    levels.clear();
+    levelFirst.clear();
+}
+
+// drop the samples beyond capacity and every node that covered only those. a node straddling the new
+// oldest sample stays, queries never take it whole since its start is before any range they are given
+void LodSeries::dropOldest() {
+    std::size_t drop = samples.size() - capacity;
+    samples.erase(samples.begin(), samples.begin() + drop);
+    first += drop;
+
+    for (std::size_t k = 0; k < levels.size(); k++) {
+        std::size_t nodeFirst = first >> (fanoutBits * (k + 1));
+        levels[k].erase(levels[k].begin(), levels[k].begin() + (nodeFirst - levelFirst[k]));
+        levelFirst[k] = nodeFirst;
+    }
+}
+
+// add a level above the current top, which has at most fanout entries at this point
+void LodSeries::addLevel() {
+    Extremes extremes;
+    if (levels.empty()) {
+        for (std::size_t i = 0; i < samples.size(); i++)
+            extremes.add(samples[i], samples[i], true, first + i);
+    }
+    else {
+        const std::vector<Node>& top = levels.back();
+        std::size_t span = std::size_t(1) << (fanoutBits * levels.size());
+        for (std::size_t i = 0; i < top.size(); i++)
+            extremes.add(top[i].min, top[i].max, top[i].minFirst, (levelFirst.back() + i) * span);
+    }
+
+    levels.emplace_back();
+    levels.back().push_back(Node{ extremes.min, extremes.max, extremes.minBeforeMax() });
+    levelFirst.push_back(0);
+}
+
+// min/max of [begin, end) from the largest nodes that fit, at most 2 * (fanout - 1) per level.
+// begin is at or after first, so every node taken lies after the dropped samples
+void LodSeries::accumulate(std::size_t begin, std::size_t end, Extremes& extremes) const {
+    // begin and end in units of the current level, 0 being the raw samples
+    for (std::size_t level = 0; begin < end; level++) {
+        std::size_t span = std::size_t(1) << (fanoutBits * level);
+        std::size_t parentBegin = (begin + fanout - 1) >> fanoutBits;
+        std::size_t parentEnd = end >> fanoutBits;
+
+        // the rest fits in no whole parent, take it at this level and stop
+        if (level == levels.size() || parentBegin >= parentEnd) {
+            parentBegin = parentEnd = end;
+        }
+
+        std::size_t headEnd = parentBegin == parentEnd ? end : parentBegin << fanoutBits;
+        for (std::size_t i = begin; i < headEnd; i++) {
+            if (level == 0)
+                extremes.add(samples[i - first], samples[i - first], true, i);
+            else {
+                const Node& node = levels[level - 1][i - levelFirst[level - 1]];
+                extremes.add(node.min, node.max, node.minFirst, i * span);
+            }
+        }
+        if (parentBegin == parentEnd)
+            break;
+
+        for (std::size_t i = parentEnd << fanoutBits; i < end; i++) {
+            if (level == 0)
+                extremes.add(samples[i - first], samples[i - first], true, i);
+            else {
+                const Node& node = levels[level - 1][i - levelFirst[level - 1]];
+                extremes.add(node.min, node.max, node.minFirst, i * span);
+            }
+        }
+
+        begin = parentBegin;
+        end = parentEnd;
+    }
+}
+
+// a gap repeats the value before it, leading gaps the first value, so a plot never gets a nan.
+// a range without any value comes back empty
+static void fillGaps(std::vector<float>& points) {
+    auto firstValue = std::find_if(points.begin(), points.end(), [](float v) { return !std::isnan(v); });
+    if (firstValue == points.end()) {
+        points.clear();
+        return;
+    }
+    float last = *firstValue;
+    for (float& point : points) {
+        if (std::isnan(point))
+            point = last;
+        else
+            last = point;
+    }
+}
+
+void LodSeries::query(std::size_t begin, std::size_t end, std::size_t buckets, std::vector<float>& points) const {
+    points.clear();
+    end = std::min(end, size());
+    begin = std::max(begin, first);
+    if (begin >= end || buckets == 0)
+        return;
+
+    // short enough to plot every sample
+    std::size_t count = end - begin;
+    if (count <= buckets * 2) {
+        points.assign(samples.begin() + (begin - first), samples.begin() + (end - first));
+        fillGaps(points);
+        return;
+    }
+
+    for (std::size_t b = 0; b < buckets; b++) {
+        Extremes extremes;
+        accumulate(begin + b * count / buckets, begin + (b + 1) * count / buckets, extremes);
+
+        // a bucket without values stays nan here and is filled below
+        bool minFirst = extremes.minBeforeMax();
+        points.push_back(minFirst ? extremes.min : extremes.max);
+        points.push_back(minFirst ? extremes.max : extremes.min);
+    }
+    fillGaps(points);
+}
+
+std::size_t LodSeries::memoryUsage() const {
+    std::size_t bytes = samples.capacity() * sizeof(float);
+    for (const std::vector<Node>& level : levels)
+        bytes += level.capacity() * sizeof(Node);
+    return bytes;
+}
@@ -0,0 +1,139 @@
+#include "../include/lz.h"
+#include <cstdint>
+#include <cstring>
+
+const size_t minMatch = 4;
+const size_t maxOffset = 65535;
+const int hashBits = 15;
+const int chainDepth = 64;
+
+// write a length that did not fit in the token nibble
+static void writeLength(std::vector<unsigned char>& out, size_t length) {
+    while (length >= 255) {
+        out.push_back(255);
+        length -= 255;
+    }
+    out.push_back(static_cast<unsigned char>(length));
+}
+
+static uint32_t hash4(const unsigned char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return (v * 2654435761u) >> (32 - hashBits);
+}
+
+static void writeSequence(std::vector<unsigned char>& out, const unsigned char* literals, size_t literalCount, size_t offset, size_t matchLength) {
+    size_t matchCode = matchLength ? matchLength - minMatch : 0;
+    out.push_back(static_cast<unsigned char>(((literalCount < 15 ? literalCount : 15) << 4) | (matchCode < 15 ? matchCode : 15)));
+    if (literalCount >= 15)
+        writeLength(out, literalCount - 15);
+    out.insert(out.end(), literals, literals + literalCount);
+
+    if (matchLength) {
+        out.push_back(static_cast<unsigned char>(offset & 0xFF));
+        out.push_back(static_cast<unsigned char>(offset >> 8));
+        if (matchCode >= 15)
+            writeLength(out, matchCode - 15);
+    }
+}
+
+// greedy parse with hash chains, slow but only runs when regenerating the embedded data
+std::vector<unsigned char> lzCompress(const unsigned char* data, size_t size) {
+    std::vector<unsigned char> out;
+    std::vector<int64_t> head(size_t(1) << hashBits, -1);
+    std::vector<int64_t> chain(size, -1);
+
+    size_t pos = 0;
+    size_t literalStart = 0;
+    while (pos + minMatch <= size) {
+        uint32_t h = hash4(data + pos);
+
+        // longest match among the recent candidates
+        size_t bestLength = 0;
+        size_t bestOffset = 0;
+        int64_t candidate = head[h];
+        for (int depth = 0; depth < chainDepth && candidate >= 0 && pos - candidate <= maxOffset; depth++) {
+            size_t length = 0;
+            while (pos + length < size && data[candidate + length] == data[pos + length])
+                length++;
+            if (length > bestLength) {
+                bestLength = length;
+                bestOffset = pos - static_cast<size_t>(candidate);
+            }
+            candidate = chain[candidate];
+        }
+
+        if (bestLength < minMatch) {
+            chain[pos] = head[h];
+            head[h] = static_cast<int64_t>(pos);
+            pos++;
+            continue;
+        }
+
+        writeSequence(out, data + literalStart, pos - literalStart, bestOffset, bestLength);
+
+        // index every position covered by the match
+        for (size_t end = pos + bestLength; pos < end; pos++) {
+            if (pos + minMatch <= size) {
+                uint32_t hp = hash4(data + pos);
+                chain[pos] = head[hp];
+                head[hp] = static_cast<int64_t>(pos);
+            }
+        }
+        literalStart = pos;
+    }
+
+    writeSequence(out, data + literalStart, size - literalStart, 0, 0);
+    return out;
+}
+
+// read a length continued in extra bytes
+static bool readLength(const unsigned char*& src, const unsigned char* srcEnd, size_t& length) {
+    unsigned char b;
+    do {
+        if (src >= srcEnd)
+            return false;
+        b = *src++;
+        length += b;
+    } while (b == 255);
+    return true;
+}
+
+bool lzDecompress(const unsigned char* src, size_t srcSize, unsigned char* dst, size_t dstSize) {
+    const unsigned char* srcEnd = src + srcSize;
+    size_t pos = 0;
+
+    while (src < srcEnd) {
+        unsigned char token = *src++;
+
+        size_t literalCount = token >> 4;
+        if (literalCount == 15 && !readLength(src, srcEnd, literalCount))
+            return false;
+        if (literalCount > static_cast<size_t>(srcEnd - src) || literalCount > dstSize - pos)
+            return false;
+        std::memcpy(dst + pos, src, literalCount);
+        src += literalCount;
+        pos += literalCount;
+
+        // last sequence
+        if (src == srcEnd)
+            break;
+
+        if (srcEnd - src < 2)
+            return false;
+        size_t offset = src[0] | (src[1] << 8);
+        src += 2;
+        size_t matchLength = token & 0x0F;
+        if (matchLength == 15 && !readLength(src, srcEnd, matchLength))
+            return false;
+        matchLength += minMatch;
+        if (offset == 0 || offset > pos || matchLength > dstSize - pos)
+            return false;
+
+        // byte by byte, matches may overlap their own output
+        for (size_t i = 0; i < matchLength; i++, pos++)
+            dst[pos] = dst[pos - offset];
+    }
+
+    return pos == dstSize;
+}
@@ -1,10 +1,26 @@
 #include <SFML/Graphics.hpp>
 #include "../include/metricsoverlay.h"
 #include <iostream>
-#include <thread>
 #include "imgui.h"
 #include "imgui-SFML.h"
 #include "../resource.h"
+#include "../include/driverlatency.h"
+#include "../include/fontcache.h"
+#include "../include/headless.h"
+#include "../include/metricformat.h"
+#include "../include/metricsampler.h"
+#include "../include/prometheusexporter.h"
+#include "../include/pushexporter.h"
+#include "../include/selfcost.h"
+#include "../include/sharedmetrics.h"
+#include "../include/tracing.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iterator>
 
 // get screen resolution
 sf::VideoMode desktop = sf::VideoMode::getDesktopMode();
@@ -14,6 +30,9 @@ unsigned int screenHeight = screen.y;
 
 unsigned int selectedOptionsBinary = 0;
 
+// owns the overlay thread and the config it draws from
+static OverlayController overlayController;
+
 // overlay selector base colors
 float overlaySelectorColor[3] = { 0.0f, 0.0f, 0.0f };
 float labelSelectorColor[3] = { 1.0f, 0.0f, 0.0f };
@@ -22,6 +41,37 @@ float valueSelectorColor[3] = { 0.0f, 1.0f, 0.0f };
 // overlay stuff
 static int overlayTextSize = 24;
 static float overlayTransparency = 0.5f;
+static bool overlaySparklines = false;
+static int overlaySparklineSeconds = 60;
+static bool overlaySelfCost = false;
+static int overlayColumns = 1;
+static bool overlayGrid = false;
+
+// session recording
+static bool recordSession = false;
+static int recordFormat = 0; // index into the format combo, csv, binary or columnar
+static std::string recordingPath;
+
+// prometheus endpoint
+static bool serveMetrics = false;
+static int metricsPort = defaultPrometheusPort;
+
+// push to a local collector
+static bool pushMetrics = false;
+static int pushTarget = 0; // index into the target combo, statsd, influx over udp or influx to a file
+static std::string pushDestination;
+
+// trace of the sampler and overlay spans, saved on demand
+static bool traceSpans = false;
+static std::string tracePath;
+
+// time range of the history plots beside each metric, an index into historyRangeSeconds
+static const int historyRangeSeconds[] = { 60, 10 * 60, 60 * 60, 6 * 60 * 60 };
+static int historyRange = 1;
+
+// driver call latency, refreshed once per sample for the tooltips and the slowest call line
+static std::vector<DriverCallStats> driverStats;
+static std::string latencyPath;
 
 // base resolution and text size
 const float baseResolutionY = 1080.0f;
@@ -33,11 +83,28 @@ float scaleFactorY = static_cast<float>(screenHeight) / baseResolutionY;
 float scaleFactorX = static_cast<float>(screenWidth) / baseResolutionX;
 int fontSize = static_cast<int>(baseTextSize * scaleFactorX);
 
+// after the last input keep drawing this long, so imgui can finish hover delays, tooltips and popups
+const sf::Time settleTime = sf::milliseconds(500);
+// while idle, wake up this often to notice the overlay opening or closing on its own thread
+const sf::Time idleWakeInterval = sf::milliseconds(250);
+
 // func declarations
 void createMainWindow(sf::RenderWindow& window);
 void setStyleAndColors(ImGuiStyle& style);
+void loadImGuiFont(ImGuiIO& io, float pixelHeight);
+void processMainWindowEvent(sf::RenderWindow& window, const sf::Event& event);
+void drawLiveMetric(int metricId, const std::optional<double>& value, float columnX, float plotWidth);
+bool startSessionRecording(LogFormat format);
+bool startPushing(int target);
+bool saveTrace();
+bool saveDriverLatency();
+OverlayConfig buildOverlayConfig();
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nShowCmd) {
+    // lab machines only log or export, which never needs a window
+    if (std::strstr(lpCmdLine, "--headless"))
+        return runHeadless(__argc, __argv);
+
     // create a render window for the main window
     sf::RenderWindow window;
     createMainWindow(window);
@@ -47,6 +114,21 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 
 // function to create main window
 void createMainWindow(sf::RenderWindow& window) {
+    // bring adlx up in the background while the window and imgui are set up, so display overlay does not wait on the driver
+    startADLXInitialization();
+
+    // keep the last half hour of samples where a crash cannot lose them, the previous run's ring is kept for recovery
+    std::remove("easymetrics.prev.ring");
+    std::rename("easymetrics.ring", "easymetrics.prev.ring");
+    if (!startCrashCapture("easymetrics.ring", metricColumnNames(), 30 * 60 * 1000 / sampleIntervalMs))
+        std::cout << "Failure: could not create easymetrics.ring" << std::endl;
+
+    // live values for other tools on this machine, with the last two minutes for slow pollers
+    startMetricPublishing(sharedMetricsName, metricColumnNames(), 2 * 60 * 1000 / sampleIntervalMs);
+
+    // one sampling loop for the live values here and in the overlay
+    startMetricSampling(adlxMetricSource());
+
     // create the window relative to screen resolution
     sf::Vector2u windowSize(screenWidth / 1.4, screenHeight / 1.15);
     window.create(sf::VideoMode(windowSize), "Easy Metrics", sf::Style::Titlebar | sf::Style::Close);
@@ -60,16 +142,7 @@ void createMainWindow(sf::RenderWindow& window) {
 
     // load the font
     ImGuiIO& io = ImGui::GetIO();
-    ImFontConfig config;
-    config.FontDataOwnedByAtlas = false;
-    io.Fonts->Clear();
-    io.Fonts->AddFontFromMemoryTTF(
-        (void*)Inter_UI_Regular_otf,
-        Inter_UI_Regular_otf_len,
-        fontSize,                  
-        &config
-    );
-    ImGui::SFML::UpdateFontTexture(); 
+    loadImGuiFont(io, static_cast<float>(fontSize));
     
     // prevent saving into imgui.ini
     io.IniFilename = nullptr;
@@ -82,17 +155,41 @@ void createMainWindow(sf::RenderWindow& window) {
     window.setFramerateLimit(60);
 
     sf::Clock deltaClock;
+    sf::Clock lastInputClock;
+    bool overlayWasOpen = overlayController.isRunning();
+    uint64_t drawnSample = getSampleCount();
+    uint64_t statsSample = drawnSample;
+    std::vector<std::optional<double>> liveValues;
 
     while (window.isOpen()) {
+        // when idle, block until input or a window event instead of rebuilding the ui at 60 fps
+        if (lastInputClock.getElapsedTime() > settleTime) {
+            if (const auto event = window.waitEvent(idleWakeInterval)) {
+                processMainWindowEvent(window, *event);
+                lastInputClock.restart();
+            }
+        }
+
         // poll window events
         while (const auto event = window.pollEvent()) {
-            ImGui::SFML::ProcessEvent(window, *event);
+            processMainWindowEvent(window, *event);
+            lastInputClock.restart();
+        }
 
-            // window close
-            if (event->is<sf::Event::Closed>()) {
-                window.close();
-                terminateOverlay = true;
-            }
+        // overlay opened or closed on its own thread, the buttons need redrawing
+        if (overlayController.isRunning() != overlayWasOpen) {
+            overlayWasOpen = overlayController.isRunning();
+            lastInputClock.restart();
+        }
+
+        // while idle only redraw once per new sample, for the live values
+        if (lastInputClock.getElapsedTime() > settleTime && getSampleCount() == drawnSample)
+            continue;
+        sf::Clock frameClock;
+        drawnSample = copyLatestSample(liveValues);
+        if (drawnSample != statsSample) {
+            driverStats = getDriverCallStats();
+            statsSample = drawnSample;
         }
 
         ImGui::SFML::Update(window, deltaClock.restart());
@@ -139,13 +236,18 @@ void createMainWindow(sf::RenderWindow& window) {
         ImGui::SetCursorPosX((windowWidth - textWidth) * 0.5f);
         ImGui::Text("Select metrics for display:");
 
+        // range of the history plots, also stepped with the mouse wheel over any plot
+        ImGui::SameLine(windowWidth * 0.68f + ImGui::CalcTextSize("00000 MHz").x);
+        ImGui::SetNextItemWidth(160.f * scaleFactorX);
+        ImGui::Combo("##historyRange", &historyRange, "1 min\0" "10 min\0" "1 hour\0" "6 hours\0");
+
         ImGui::Spacing();
 
         // bools for checkboxes
         static bool selectAll = false;
-        static bool options[11] = {};
+        static bool options[16] = {};
         // checkbox labels
-        const char* optionLabels[11] = {
+        const char* optionLabels[16] = {
             "GPU Usage",
             "GPU Temperature",
             "GPU Hotspot Temperature",
@@ -156,12 +258,15 @@ void createMainWindow(sf::RenderWindow& window) {
             "GPU VRAM",
             "GPU VRAM Clock Speed",
             "CPU Usage",
-            "System RAM"
+            "System RAM",
+            "FPS",
+            "Average FPS",
+            "1% Low FPS",
+            "0.1% Low FPS",
+            "Frame Time"
         };
 
-        // checkboxes disabled if overlay is running
-        ImGui::BeginDisabled(isOverlayOpen);
-        // individual checkboxes
+        // individual checkboxes, applied live to a running overlay
         for (size_t i = 0; i < sizeof(options); i++) {
             // centering
             float optionWidth = ImGui::CalcTextSize(optionLabels[i]).x + ImGui::GetStyle().FramePadding.x * 4;
@@ -196,6 +301,9 @@ void createMainWindow(sf::RenderWindow& window) {
                     //std::cout << selectedOptionsBinary << std::endl;
                 }
             }
+
+            // live value and recent history beside each metric, to check sensor coverage before opening the overlay
+            drawLiveMetric(static_cast<int>(i), liveValues[i], windowWidth * 0.68f, 160.f * scaleFactorX);
         }
 
         // "Select All" checkbox
@@ -217,7 +325,6 @@ void createMainWindow(sf::RenderWindow& window) {
                 //std::cout << selectedOptionsBinary << std::endl;
             }
         }
-        ImGui::EndDisabled();
 
         // center the buttons
         ImGui::Spacing();
@@ -226,30 +333,22 @@ void createMainWindow(sf::RenderWindow& window) {
         ImGui::SetCursorPosX((windowWidth - totalButtonWidth) * 0.5f);
 
         // disable display button if no options checked or overlay already exists
-        ImGui::BeginDisabled(!selectedOptionsBinary || isOverlayOpen); 
+        ImGui::BeginDisabled(!selectedOptionsBinary || overlayController.isRunning()); 
         if (ImGui::Button("Display Overlay", ImVec2(buttonWidth, 0))) {
-            // set selected metrics to display
-            setSelectedMetrics(selectedOptionsBinary);
-            // set overlay prefs
-            setPreferences(overlaySelectorColor, labelSelectorColor, valueSelectorColor, overlayTransparency, overlayTextSize);
-            // create the overlay on a new thread and run independently
-            std::thread overlayThread(createOverlayWindow);
-            overlayThread.detach();
+            // hand the selected metrics and prefs to the overlay
+            overlayController.publishConfig(buildOverlayConfig());
+            // create the overlay on the controller's thread
+            overlayController.start(createOverlayWindow);
         }
         ImGui::EndDisabled();
 
         ImGui::SameLine();
         // disable terminate button if overlay is not already open
-        ImGui::BeginDisabled(!isOverlayOpen);
+        ImGui::BeginDisabled(!overlayController.isRunning());
         if (ImGui::Button("Terminate Overlay", ImVec2(buttonWidth, 0))) {
-            // terminate the overlay window and thread
-            terminateOverlay = true;
-            // reset all checkboxes and binary
-            for (size_t i = 0; i < sizeof(options); i++) {
-                options[i] = false;
-            }
-            selectAll = false;
-            selectedOptionsBinary = 0;
+            // close the overlay after its current frame, the thread is joined on the next display or at exit.
+            // the selection is kept for the next one
+            overlayController.requestStop();
         }
         ImGui::EndDisabled();
 
@@ -342,9 +441,125 @@ void createMainWindow(sf::RenderWindow& window) {
         ImGui::SameLine(totalWidth + offsetFromLeft - sliderSize);
         ImGui::SliderInt("##", &overlayTextSize, 10, 38);
 
+        // sparkline toggle and graph history length
+        ImGui::SetCursorPosX(offsetFromLeft);
+        ImGui::PushStyleColor(ImGuiCol_FrameBg, ImVec4(0.251f, 0.263f, 0.306f, 1.00f));
+        ImGui::Checkbox("Show Sparklines", &overlaySparklines);
+        ImGui::PopStyleColor();
+        ImGui::SameLine(totalWidth + offsetFromLeft - sliderSize);
+        ImGui::BeginDisabled(!overlaySparklines);
+        ImGui::SliderInt("##history", &overlaySparklineSeconds, 30, 120, "%d s");
+        ImGui::EndDisabled();
+
+        // overlay self-cost debug panel
+        ImGui::SetCursorPosX(offsetFromLeft);
+        ImGui::PushStyleColor(ImGuiCol_FrameBg, ImVec4(0.251f, 0.263f, 0.306f, 1.00f));
+        ImGui::Checkbox("Show Self-Cost", &overlaySelfCost);
+        ImGui::PopStyleColor();
+
+        // overlay layout
+        ImGui::SameLine(totalWidth + offsetFromLeft - sliderSize);
+        ImGui::SliderInt("##columns", &overlayColumns, 1, 4, "%d column(s)");
+        ImGui::SetCursorPosX(offsetFromLeft);
+        ImGui::PushStyleColor(ImGuiCol_FrameBg, ImVec4(0.251f, 0.263f, 0.306f, 1.00f));
+        ImGui::Checkbox("Grid Layout", &overlayGrid);
+        ImGui::PopStyleColor();
+
+        // record every sample of every metric to a file in the working directory
+        ImGui::SetCursorPosX(offsetFromLeft);
+        ImGui::PushStyleColor(ImGuiCol_FrameBg, ImVec4(0.251f, 0.263f, 0.306f, 1.00f));
+        if (ImGui::Checkbox("Record to File", &recordSession)) {
+            if (recordSession)
+                recordSession = startSessionRecording(static_cast<LogFormat>(recordFormat));
+            else
+                stopRecording();
+        }
+        ImGui::PopStyleColor();
+        if (recordSession)
+            ImGui::SetItemTooltip("%s", recordingPath.c_str());
+        ImGui::SameLine(totalWidth + offsetFromLeft - sliderSize);
+        ImGui::BeginDisabled(recordSession);
+        ImGui::Combo("##format", &recordFormat, "CSV\0Binary\0Columnar\0");
+        ImGui::EndDisabled();
+
+        // serve every metric to prometheus and similar scrapers on localhost
+        ImGui::SetCursorPosX(offsetFromLeft);
+        ImGui::PushStyleColor(ImGuiCol_FrameBg, ImVec4(0.251f, 0.263f, 0.306f, 1.00f));
+        if (ImGui::Checkbox("Serve /metrics", &serveMetrics)) {
+            if (serveMetrics)
+                serveMetrics = startMetricsEndpoint(static_cast<uint16_t>(metricsPort));
+            else
+                stopMetricsEndpoint();
+        }
+        ImGui::PopStyleColor();
+        if (serveMetrics)
+            ImGui::SetItemTooltip("http://127.0.0.1:%d/metrics", metricsPort);
+        ImGui::SameLine(totalWidth + offsetFromLeft - sliderSize);
+        ImGui::BeginDisabled(serveMetrics);
+        if (ImGui::InputInt("##port", &metricsPort, 0))
+            metricsPort = std::clamp(metricsPort, 1, 65535);
+        ImGui::EndDisabled();
+
+        // push every metric to a statsd or influx collector on this machine
+        ImGui::SetCursorPosX(offsetFromLeft);
+        ImGui::PushStyleColor(ImGuiCol_FrameBg, ImVec4(0.251f, 0.263f, 0.306f, 1.00f));
+        if (ImGui::Checkbox("Push Metrics", &pushMetrics)) {
+            if (pushMetrics)
+                pushMetrics = startPushing(pushTarget);
+            else
+                stopMetricPush();
+        }
+        ImGui::PopStyleColor();
+        if (pushMetrics)
+            ImGui::SetItemTooltip("%s", pushDestination.c_str());
+        ImGui::SameLine(totalWidth + offsetFromLeft - sliderSize);
+        ImGui::BeginDisabled(pushMetrics);
+        ImGui::Combo("##push", &pushTarget, "StatsD\0Influx\0Influx File\0");
+        ImGui::EndDisabled();
+
+        // record sampler and overlay spans, saved as a chrome trace when the overlay stutters
+        ImGui::SetCursorPosX(offsetFromLeft);
+        ImGui::PushStyleColor(ImGuiCol_FrameBg, ImVec4(0.251f, 0.263f, 0.306f, 1.00f));
+        if (ImGui::Checkbox("Trace", &traceSpans))
+            setTracingEnabled(traceSpans);
+        ImGui::PopStyleColor();
+        ImGui::SameLine(totalWidth + offsetFromLeft - sliderSize);
+        if (ImGui::Button("Save Trace", ImVec2(sliderSize, 0)) && !saveTrace())
+            std::cout << "Failure: could not write " << tracePath << std::endl;
+        if (!tracePath.empty())
+            ImGui::SetItemTooltip("%s", tracePath.c_str());
+
+        // slowest driver call so far, hover for every call and save the full histograms to find the expensive metrics
+        const DriverCallStats* slowest = nullptr;
+        std::string latencyTable;
+        for (const DriverCallStats& call : driverStats) {
+            if (!slowest || call.p99Us > slowest->p99Us)
+                slowest = &call;
+            char line[128];
+            std::snprintf(line, sizeof(line), "%s: p50 %.1f us  p99 %.1f us  max %.1f us\n", call.name.c_str(), call.p50Us, call.p99Us, call.maxUs);
+            latencyTable += line;
+        }
+        ImGui::SetCursorPosX(offsetFromLeft);
+        if (slowest) {
+            ImGui::Text("Slowest driver call: %s, p99 %.2f ms", slowest->name.c_str(), slowest->p99Us / 1000.0);
+            ImGui::SetItemTooltip("%s", latencyTable.c_str());
+        }
+        else
+            ImGui::TextDisabled("Slowest driver call: none yet");
+        ImGui::SameLine(totalWidth + offsetFromLeft - sliderSize);
+        if (ImGui::Button("Save Latency", ImVec2(sliderSize, 0)) && !saveDriverLatency())
+            std::cout << "Failure: could not write " << latencyPath << std::endl;
+        if (!latencyPath.empty())
+            ImGui::SetItemTooltip("%s", latencyPath.c_str());
+
         ImGui::PopItemWidth();
         ImGui::PopStyleColor();
 
+        // push any change to a running overlay as a new snapshot, it is picked up on the overlay's next frame
+        OverlayConfig overlayConfig = buildOverlayConfig();
+        if (overlayController.isRunning() && overlayConfig.selectedMetrics && overlayConfig != *overlayController.loadConfig())
+            overlayController.publishConfig(overlayConfig);
+
         #pragma endregion
 
         #pragma region Overlay Preview
@@ -356,8 +571,18 @@ void createMainWindow(sf::RenderWindow& window) {
         ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(0, 0));
         ImGui::SetWindowFontScale(overlayTextSize / 18.0f);
 
-        const char* label = "Example Metric:";
-        const char* value = "99%";
+        // preview the first selected metric with its live value, or an example until one is picked
+        std::string previewLabel = "Example Metric:";
+        std::string previewValue = "99%";
+        for (size_t i = 0; i < metrics.size(); i++) {
+            if (selectedOptionsBinary & (1 << i)) {
+                previewLabel = metrics[i].label.toAnsiString() + ":";
+                previewValue = formatMetricValue(static_cast<int>(i), liveValues[i]);
+                break;
+            }
+        }
+        const char* label = previewLabel.c_str();
+        const char* value = previewValue.c_str();
 
         // measure both texts
         ImVec2 labelSize = ImGui::CalcTextSize(label);
@@ -425,9 +650,172 @@ void createMainWindow(sf::RenderWindow& window) {
         window.clear(sf::Color(18, 33, 43));
         ImGui::SFML::Render();
         window.display();
-        
+        recordMainWindowFrame(frameClock.getElapsedTime().asMicroseconds());
     }
     ImGui::SFML::Shutdown();
+
+    // let the overlay finish its last frame and stop sampling, then release adlx once for the whole app
+    overlayController.stop();
+    stopMetricSampling();
+    releaseAndTerminate();
+}
+
+// function to start recording to a new file named after the current time
+bool startSessionRecording(LogFormat format) {
+    char name[64];
+    std::time_t now = std::time(nullptr);
+    std::tm local = {};
+    localtime_s(&local, &now);
+    std::strftime(name, sizeof(name), "easymetrics-%Y%m%d-%H%M%S", &local);
+    const char* extensions[] = { ".csv", ".bin", ".emc" };
+    recordingPath = std::string(name) + extensions[static_cast<int>(format)];
+
+    LogOptions options;
+    options.format = format;
+    return startRecording(recordingPath, metricColumnNames(), options);
+}
+
+// function to save the spans recorded so far to a timestamped trace file
+bool saveTrace() {
+    char name[64];
+    std::time_t now = std::time(nullptr);
+    std::tm local = {};
+    localtime_s(&local, &now);
+    std::strftime(name, sizeof(name), "easymetrics-%Y%m%d-%H%M%S.trace.json", &local);
+    tracePath = name;
+    return writeTraceFile(tracePath);
+}
+
+// function to save every driver call's latency histogram to a timestamped .hgrm file
+bool saveDriverLatency() {
+    char name[64];
+    std::time_t now = std::time(nullptr);
+    std::tm local = {};
+    localtime_s(&local, &now);
+    std::strftime(name, sizeof(name), "easymetrics-%Y%m%d-%H%M%S.hgrm", &local);
+    latencyPath = name;
+    return writeDriverLatencyFile(latencyPath);
+}
+
+// function to start pushing to the default collector for a target, or appending to easymetrics.influx
+bool startPushing(int target) {
+    PushOptions options;
+    options.format = target == 0 ? PushFormat::StatsD : PushFormat::Influx;
+    options.port = target == 0 ? defaultStatsDPort : defaultInfluxPort;
+    if (target == 2)
+        options.path = "easymetrics.influx";
+    pushDestination = target == 2 ? options.path : "udp://" + options.host + ":" + std::to_string(options.port);
+    return startMetricPush(options);
+}
+
+// function to draw a metric's live value and a plot of its history on the current line
+void drawLiveMetric(int metricId, const std::optional<double>& value, float columnX, float plotWidth) {
+    // reused every frame, the history is downsampled to at most one point per pixel
+    static std::vector<float> plotPoints;
+
+    ImGui::SameLine(columnX);
+    if (!value.has_value()) {
+        ImGui::TextDisabled("N/A");
+        return;
+    }
+    ImGui::Text("%s", formatMetricValue(metricId, value).c_str());
+
+    // what reading it costs the driver
+    for (const DriverCallStats& call : driverStats) {
+        if (call.metricId == metricId) {
+            ImGui::SetItemTooltip("%s: p50 %.1f us  p99 %.1f us  max %.1f us over %llu calls", call.name.c_str(), call.p50Us, call.p99Us, call.maxUs,
+                static_cast<unsigned long long>(call.calls));
+            break;
+        }
+    }
+
+    ImGui::SameLine(columnX + ImGui::CalcTextSize("00000 MHz").x);
+    std::size_t windowSamples = static_cast<std::size_t>(historyRangeSeconds[historyRange]) * 1000 / sampleIntervalMs;
+    copyMetricHistory(metricId, windowSamples, static_cast<std::size_t>(plotWidth), plotPoints);
+    ImGui::PushID(metricId);
+    ImGui::PlotLines("##history", plotPoints.data(), static_cast<int>(plotPoints.size()), 0, nullptr, FLT_MAX, FLT_MAX, ImVec2(plotWidth, ImGui::GetTextLineHeight()));
+    ImGui::PopID();
+
+    // wheel up zooms in to a shorter range
+    if (ImGui::IsItemHovered() && ImGui::GetIO().MouseWheel != 0.0f) {
+        int last = static_cast<int>(std::size(historyRangeSeconds)) - 1;
+        historyRange = std::clamp(historyRange + (ImGui::GetIO().MouseWheel > 0.0f ? -1 : 1), 0, last);
+    }
+}
+
+// function to gather the current overlay prefs into a config snapshot
+OverlayConfig buildOverlayConfig() {
+    OverlayConfig config;
+    config.selectedMetrics = selectedOptionsBinary;
+    std::copy(std::begin(overlaySelectorColor), std::end(overlaySelectorColor), config.overlayColor.begin());
+    std::copy(std::begin(labelSelectorColor), std::end(labelSelectorColor), config.labelColor.begin());
+    std::copy(std::begin(valueSelectorColor), std::end(valueSelectorColor), config.valueColor.begin());
+    config.transparency = overlayTransparency;
+    config.textSize = overlayTextSize;
+    config.showSparklines = overlaySparklines;
+    config.sparklineSeconds = overlaySparklineSeconds;
+    config.showSelfCost = overlaySelfCost;
+    config.columns = overlayColumns;
+    config.layoutMode = overlayGrid ? LayoutMode::Grid : LayoutMode::MultiColumn;
+    return config;
+}
+
+// function to handle one main window event
+void processMainWindowEvent(sf::RenderWindow& window, const sf::Event& event) {
+    ImGui::SFML::ProcessEvent(window, event);
+
+    // window close
+    if (event.is<sf::Event::Closed>()) {
+        window.close();
+        overlayController.requestStop();
+    }
+}
+
+// function to load the ui font into imgui from the shared glyph cache instead of letting imgui rasterize it
+void loadImGuiFont(ImGuiIO& io, float pixelHeight) {
+    std::shared_ptr<const GlyphAtlas> atlas = acquireGlyphAtlas(glyphAtlasSizeForPixelHeight(pixelHeight));
+    const std::vector<unsigned char>& interFont = getInterFont();
+
+    // imgui still parses the font for its line metrics but only rasterizes the space
+    static const ImWchar spaceOnly[] = { 0x20, 0x20, 0 };
+    ImFontConfig config;
+    config.FontDataOwnedByAtlas = false;
+    io.Fonts->Clear();
+    ImFont* font = io.Fonts->AddFontFromMemoryTTF((void*)interFont.data(), static_cast<int>(interFont.size()), pixelHeight, &config, atlas ? spaceOnly : nullptr);
+    if (!atlas) {
+        ImGui::SFML::UpdateFontTexture();
+        return;
+    }
+
+    // every other glyph is a custom rect filled from the cache
+    std::vector<std::pair<int, int>> rects; // code point, rect index
+    for (int cp : atlasCodePoints()) {
+        const AtlasGlyph& g = atlas->glyphs[cp];
+        if (g.width > 0 && g.height > 0)
+            rects.emplace_back(cp, io.Fonts->AddCustomRectFontGlyph(font, static_cast<ImWchar>(cp), g.width, g.height, g.advance, ImVec2(static_cast<float>(g.left), static_cast<float>(g.top))));
+    }
+    io.Fonts->Build();
+
+    unsigned char* pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsAlpha8(&pixels, &width, &height);
+    for (const auto& [cp, index] : rects) {
+        const ImFontAtlasCustomRect* rect = io.Fonts->GetCustomRectByIndex(index);
+        const AtlasGlyph& g = atlas->glyphs[cp];
+        for (int row = 0; row < g.height; row++)
+            std::memcpy(pixels + (rect->Y + row) * width + rect->X, &atlas->pixels[(g.y + row) * atlas->width + g.x], g.width);
+    }
+
+    // custom glyph offsets are from the top of the line, the cache's from the baseline
+    float ascent = std::round(font->Ascent);
+    for (ImFontGlyph& glyph : font->Glyphs) {
+        if (glyph.Codepoint != ' ') {
+            glyph.Y0 += ascent;
+            glyph.Y1 += ascent;
+        }
+    }
+
+    ImGui::SFML::UpdateFontTexture();
 }
 
 // setup for UI
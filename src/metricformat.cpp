@@ -0,0 +1,33 @@
+#include "../include/metricformat.h"
+#include "../include/metricsource.h"
+#include <cmath>
+#include <cstdio>
+
+std::string formatValue(double value, int precision) {
+    if (precision <= 0)
+        return std::to_string(std::lround(value));
+
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.*f", precision, value);
+    return buffer;
+}
+
+std::string displayUnit(int metricId) {
+    const char* unit = getMetricNames()[metricId].unit;
+    if (unit[0] == '\0' || unit[0] == '%' || unit[0] == '\xC2')
+        return unit;
+    return std::string(" ") + unit;
+}
+
+std::string formatMetricValue(int metricId, const std::optional<double>& value) {
+    if (!value.has_value())
+        return "N/A";
+    return formatValue(value.value(), getMetricNames()[metricId].precision) + displayUnit(metricId);
+}
+
+std::vector<std::string> metricColumnNames() {
+    std::vector<std::string> columns;
+    for (const MetricName& name : getMetricNames())
+        columns.push_back(name.unit[0] ? std::string(name.label) + " (" + name.unit + ")" : std::string(name.label));
+    return columns;
+}
@@ -0,0 +1,268 @@
+#include "../include/metricsampler.h"
+#include "../include/lodseries.h"
+#include "../include/metricsource.h"
+#include "../include/prometheusexporter.h"
+#include "../include/pushexporter.h"
+#include "../include/ringcapture.h"
+#include "../include/selfcost.h"
+#include "../include/sharedmetrics.h"
+#include "../include/tracing.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// set before the sampler thread starts, then only used by it
+static MetricSource source;
+static SamplerOptions samplerOptions;
+
+static std::thread samplerThread;
+static std::condition_variable stopSignal;
+static std::condition_variable sampleSignal; // woken after every sample for waitForSample
+static std::atomic<uint64_t> sampleCount = 0;
+static PrometheusExporter exporter; // renders a body per sample only while serving, safe to call without the lock
+static PushExporter pusher; // queues samples for a collector while pushing, safe to call without the lock
+
+// everything below is guarded by sampleMutex
+static std::mutex sampleMutex;
+static bool stopRequested = false;
+static std::vector<std::optional<double>> latestValues;
+static std::vector<LodSeries> history; // the newest historySamples of each metric, nan where the metric had no value
+static std::unique_ptr<SessionLogger> recorder; // set while recording to a file
+static std::chrono::steady_clock::time_point recordingStart;
+static RingCapture crashCapture; // open while the crash capture is on
+static std::chrono::steady_clock::time_point crashCaptureStart;
+static SharedMetricsWriter publisher; // open while publishing to shared memory
+static std::chrono::steady_clock::time_point publishingStart;
+
+#pragma region Sampling
+
+// function to fetch the current value of every metric
+static void sampleAllMetrics(std::vector<std::optional<double>>& values) {
+    TraceScope sampleScope("sample");
+    {
+        TraceScope beginScope("beginSample");
+        source.beginSample();
+    }
+
+    // each getter is its own span, named by its metric key
+    const std::vector<MetricName>& names = getMetricNames();
+    values.resize(source.getters.size());
+    for (size_t i = 0; i < source.getters.size(); i++) {
+        TraceScope getterScope(i < names.size() ? names[i].key : "getter");
+        values[i] = source.getters[i]();
+    }
+}
+
+// function to append one sample to the history of every metric
+static void pushHistory(const std::vector<std::optional<double>>& values) {
+    for (size_t i = 0; i < history.size(); i++)
+        history[i].push(values[i].has_value() ? static_cast<float>(values[i].value()) : NAN);
+}
+
+// the sampler thread, samples on a fixed schedule until asked to stop
+static void samplingLoop() {
+    setTraceThreadName("sampler");
+
+    // for adlx this waits for the background start if it is still running
+    if (!source.open()) {
+        std::lock_guard<std::mutex> lock(sampleMutex);
+        stopRequested = true;
+        sampleSignal.notify_all();
+        return;
+    }
+
+    std::vector<std::optional<double>> values;
+    auto nextTick = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(sampleMutex);
+    while (!stopRequested) {
+        // sample without holding the lock, readers only ever wait for the copy below
+        lock.unlock();
+        auto tickStart = std::chrono::steady_clock::now();
+        sampleAllMetrics(values);
+        recordSamplingTick(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - tickStart).count());
+        lock.lock();
+
+        latestValues = values;
+        pushHistory(values);
+        uint64_t count = sampleCount.fetch_add(1, std::memory_order_release) + 1;
+        if (recorder)
+            recorder->append(std::chrono::duration<double>(tickStart - recordingStart).count(), values);
+        if (crashCapture.isOpen())
+            crashCapture.write(std::chrono::duration<double>(tickStart - crashCaptureStart).count(), values);
+        if (publisher.isOpen())
+            publisher.publish(std::chrono::duration<double>(tickStart - publishingStart).count(), values);
+        exporter.publish(values, count);
+        if (pusher.isRunning())
+            pusher.push(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count(), values);
+
+        sampleSignal.notify_all();
+
+        nextTick += std::chrono::milliseconds(samplerOptions.intervalMs);
+        stopSignal.wait_until(lock, nextTick, [] { return stopRequested; });
+    }
+    lock.unlock();
+
+    source.close();
+}
+
+#pragma endregion
+
+#pragma region Functions called from main
+
+void startMetricSampling(MetricSource metricSource, const SamplerOptions& options) {
+    if (samplerThread.joinable())
+        return;
+
+    source = std::move(metricSource);
+    samplerOptions = options;
+    if (samplerOptions.intervalMs < 1)
+        samplerOptions.intervalMs = 1;
+    {
+        std::lock_guard<std::mutex> lock(sampleMutex);
+        stopRequested = false;
+        latestValues.assign(source.getters.size(), std::nullopt);
+        history.assign(samplerOptions.keepHistory ? source.getters.size() : 0, LodSeries(samplerOptions.historySamples));
+    }
+    samplerThread = std::thread(samplingLoop);
+}
+
+void stopMetricSampling() {
+    {
+        std::lock_guard<std::mutex> lock(sampleMutex);
+        stopRequested = true;
+    }
+    stopSignal.notify_all();
+
+    if (samplerThread.joinable())
+        samplerThread.join();
+
+    stopRecording();
+    stopCrashCapture();
+    stopMetricPublishing();
+    stopMetricsEndpoint();
+    stopMetricPush();
+}
+
+bool startRecording(const std::string& path, const std::vector<std::string>& columns, const LogOptions& options) {
+    stopRecording();
+
+    std::unique_ptr<SessionLogger> logger = std::make_unique<SessionLogger>();
+    if (!logger->open(path, columns, options))
+        return false;
+
+    std::lock_guard<std::mutex> lock(sampleMutex);
+    recordingStart = std::chrono::steady_clock::now();
+    recorder = std::move(logger);
+    return true;
+}
+
+void stopRecording() {
+    std::unique_ptr<SessionLogger> logger;
+    {
+        std::lock_guard<std::mutex> lock(sampleMutex);
+        logger = std::move(recorder);
+    }
+
+    // flushes and joins the writer outside the lock, so sampling carries on meanwhile
+    if (logger)
+        logger->close();
+}
+
+bool startCrashCapture(const std::string& path, const std::vector<std::string>& columns, std::size_t slotCount) {
+    std::lock_guard<std::mutex> lock(sampleMutex);
+    crashCapture.close();
+    crashCaptureStart = std::chrono::steady_clock::now();
+    return crashCapture.create(path, columns, slotCount);
+}
+
+void stopCrashCapture() {
+    std::lock_guard<std::mutex> lock(sampleMutex);
+    crashCapture.close();
+}
+
+bool startMetricPublishing(const std::string& name, const std::vector<std::string>& columns, std::size_t historySlots) {
+    std::lock_guard<std::mutex> lock(sampleMutex);
+    publisher.close();
+    publishingStart = std::chrono::steady_clock::now();
+    return publisher.create(name, columns, historySlots);
+}
+
+void stopMetricPublishing() {
+    std::lock_guard<std::mutex> lock(sampleMutex);
+    publisher.close();
+}
+
+bool startMetricsEndpoint(uint16_t port) {
+    if (!exporter.start(port))
+        return false;
+
+    // serve the latest sample straight away rather than waiting for the next one
+    std::lock_guard<std::mutex> lock(sampleMutex);
+    if (!latestValues.empty())
+        exporter.publish(latestValues, sampleCount.load(std::memory_order_relaxed));
+    return true;
+}
+
+void stopMetricsEndpoint() {
+    exporter.stop();
+}
+
+bool startMetricPush(const PushOptions& options) {
+    return pusher.start(options);
+}
+
+void stopMetricPush() {
+    // sends whatever is still queued before returning
+    pusher.stop();
+}
+
+#pragma endregion
+
+#pragma region Readers
+
+uint64_t getSampleCount() {
+    return sampleCount.load(std::memory_order_acquire);
+}
+
+bool isMetricSamplingStopped() {
+    std::lock_guard<std::mutex> lock(sampleMutex);
+    return stopRequested;
+}
+
+uint64_t waitForSample(uint64_t afterCount, int timeoutMs) {
+    std::unique_lock<std::mutex> lock(sampleMutex);
+    sampleSignal.wait_for(lock, std::chrono::milliseconds(timeoutMs), [afterCount] {
+        return stopRequested || sampleCount.load(std::memory_order_relaxed) > afterCount;
+    });
+    return sampleCount.load(std::memory_order_relaxed);
+}
+
+uint64_t copyLatestSample(std::vector<std::optional<double>>& values) {
+    std::lock_guard<std::mutex> lock(sampleMutex);
+    if (latestValues.empty())
+        values.assign(getMetricNames().size(), std::nullopt);
+    else
+        values = latestValues;
+    return sampleCount.load(std::memory_order_relaxed);
+}
+
+void copyMetricHistory(int metricId, std::size_t windowSamples, std::size_t maxPoints, std::vector<float>& points) {
+    std::lock_guard<std::mutex> lock(sampleMutex);
+    if (metricId < 0 || static_cast<std::size_t>(metricId) >= history.size()) {
+        points.clear();
+        return;
+    }
+
+    // the window ending at the newest sample, two points (min and max) per bucket
+    const LodSeries& series = history[metricId];
+    std::size_t end = series.size();
+    series.query(end > windowSamples ? end - windowSamples : 0, end, maxPoints / 2, points);
+}
+
+#pragma endregion
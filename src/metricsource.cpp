@@ -0,0 +1,302 @@
+#include "../include/metricsource.h"
+#include "../include/driverlatency.h"
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+#if !defined(_WIN32)
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// function-local so tables built from it in other files never see it unconstructed
+const std::vector<MetricName>& getMetricNames() {
+    static const std::vector<MetricName> metricNames = {
+        { "gpu_usage", "GPU Usage", "%", 0, 3 },
+        { "gpu_temperature", "GPU Temperature", "\xC2\xB0" "C", 0, 3 },
+        { "gpu_hotspot_temperature", "GPU Hotspot Temperature", "\xC2\xB0" "C", 0, 3 },
+        { "gpu_power", "GPU Power", "W", 0, 3 },
+        { "gpu_voltage", "GPU Voltage", "mV", 0, 4 },
+        { "gpu_clock_speed", "GPU Clock Speed", "MHz", 0, 4 },
+        { "gpu_fan_speed", "GPU Fan Speed", "RPM", 0, 4 },
+        { "gpu_vram", "GPU VRAM", "MB", 0, 5 },
+        { "gpu_vram_clock_speed", "GPU VRAM Clock Speed", "MHz", 0, 5 },
+        { "cpu_usage", "CPU Usage", "%", 0, 3 },
+        { "system_ram", "System RAM", "MB", 0, 6 },
+        { "fps", "FPS", "", 0, 4 },
+        { "average_fps", "Average FPS", "", 0, 4 },
+        { "one_percent_low_fps", "1% Low FPS", "", 0, 4 },
+        { "point_one_percent_low_fps", "0.1% Low FPS", "", 0, 4 },
+        { "frame_time", "Frame Time", "ms", 1, 3 }
+    };
+    return metricNames;
+}
+
+#pragma region Fake
+
+// every value of one fake sample, worked out together so they stay consistent with each other
+struct FakeState {
+    uint64_t seed = 0;
+    uint64_t tick = 0;
+    double averageFPS = 0.0;
+    std::array<double, 16> values = {};
+};
+
+// uniform in [0, 1), the same for the same seed, tick and metric
+static double fakeNoise(uint64_t seed, uint64_t tick, uint64_t metric) {
+    uint64_t x = seed + tick * 0x9E3779B97F4A7C15ull + metric * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return static_cast<double>(x >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void advanceFake(FakeState& state) {
+    uint64_t t = state.tick++;
+
+    // scene load drifts slowly between light and heavy, everything else follows it
+    double load = 0.5 + 0.5 * std::sin(t * 0.02 + static_cast<double>(state.seed % 628) * 0.01);
+    auto noise = [&](uint64_t metric) { return fakeNoise(state.seed, t, metric); };
+
+    double fps = 160.0 - 70.0 * load + 12.0 * (noise(11) - 0.5);
+    state.averageFPS = t == 0 ? fps : state.averageFPS * 0.95 + fps * 0.05;
+
+    std::array<double, 16>& v = state.values;
+    v[0] = std::ceil(80.0 + 19.0 * load + noise(0));
+    v[1] = std::round(55.0 + 20.0 * load + 2.0 * noise(1));
+    v[2] = v[1] + std::round(12.0 + 6.0 * noise(2));
+    v[3] = std::round(140.0 + 130.0 * load + 10.0 * noise(3));
+    v[4] = std::round(850.0 + 250.0 * load + 20.0 * noise(4));
+    v[5] = std::round(2100.0 + 500.0 * load + 40.0 * noise(5));
+    v[6] = std::round(1100.0 + 1100.0 * load + 50.0 * noise(6));
+    v[7] = std::round(5800.0 + 1800.0 * load + 30.0 * noise(7));
+    v[8] = 2500.0;
+    v[9] = std::ceil(20.0 + 25.0 * load + 5.0 * noise(9));
+    v[10] = std::round(11800.0 + 600.0 * load + 40.0 * noise(10));
+    v[11] = std::round(fps);
+    v[12] = std::round(state.averageFPS);
+    v[13] = std::round(state.averageFPS * (0.72 + 0.05 * noise(13)));
+    v[14] = std::round(state.averageFPS * (0.58 + 0.05 * noise(14)));
+    v[15] = 1000.0 / fps;
+}
+
+MetricSource fakeMetricSource(uint64_t seed, uint32_t unsupported) {
+    std::shared_ptr<FakeState> state = std::make_shared<FakeState>();
+    state->seed = seed;
+
+    MetricSource source;
+    source.name = "fake";
+    source.open = [] { return true; };
+    source.beginSample = [state] { advanceFake(*state); };
+    for (std::size_t i = 0; i < getMetricNames().size(); i++) {
+        if (unsupported & (1u << i))
+            source.getters.push_back([]() -> std::optional<double> { return std::nullopt; });
+        else
+            source.getters.push_back([state, i]() -> std::optional<double> { return state->values[i]; });
+    }
+    source.close = [] {};
+    return source;
+}
+
+void readMetricSample(MetricSource& source, std::vector<std::optional<double>>& values) {
+    source.beginSample();
+    values.resize(source.getters.size());
+    for (std::size_t i = 0; i < source.getters.size(); i++)
+        values[i] = source.getters[i]();
+}
+
+#pragma endregion
+
+#if !defined(_WIN32)
+#pragma region Sysfs
+
+// every file is opened once and re-read from offset 0 each sample, so a sample is a fixed set of preads
+struct SysfsState {
+    int gpu = 0;
+    std::array<int, 16> files; // per metric id, -1 where there is no file
+    std::array<int, 16> calls; // driver latency histogram of each file's reads
+    std::array<double, 16> scales = {}; // multiplies the raw value into the metric's unit
+    int statFile = -1;
+    int meminfoFile = -1;
+    uint64_t lastBusy = 0;
+    uint64_t lastTotal = 0;
+    std::optional<double> cpuUsage;
+    std::optional<double> systemRAM;
+
+    SysfsState() {
+        files.fill(-1);
+        calls.fill(-1);
+    }
+};
+
+// read a small file from the start, empty on failure
+static std::size_t readFile(int file, char* buffer, std::size_t size) {
+    if (file < 0)
+        return 0;
+    ssize_t bytes = pread(file, buffer, size - 1, 0);
+    if (bytes <= 0)
+        return 0;
+    buffer[bytes] = '\0';
+    return static_cast<std::size_t>(bytes);
+}
+
+static std::optional<double> readSysfsValue(const SysfsState& state, std::size_t metric) {
+    char buffer[64];
+    if (timeDriverCall(state.calls[metric], [&] { return readFile(state.files[metric], buffer, sizeof(buffer)); }) == 0)
+        return std::nullopt;
+    char* end = nullptr;
+    double value = std::strtod(buffer, &end);
+    if (end == buffer)
+        return std::nullopt;
+    return value * state.scales[metric];
+}
+
+// the first hwmon directory of a device, empty if it has none
+static std::string findHwmon(const std::string& device) {
+    std::string found;
+    if (DIR* dir = opendir((device + "/hwmon").c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            if (std::strncmp(entry->d_name, "hwmon", 5) == 0) {
+                found = device + "/hwmon/" + entry->d_name;
+                break;
+            }
+        }
+        closedir(dir);
+    }
+    return found;
+}
+
+// busy share of all cpu time since the previous sample, from the first line of /proc/stat
+static void sampleCPU(SysfsState& state) {
+    char buffer[512];
+    uint64_t fields[8] = {};
+    state.cpuUsage = std::nullopt;
+    if (timeDriverCall(state.calls[9], [&] { return readFile(state.statFile, buffer, sizeof(buffer)); }) == 0 || std::strncmp(buffer, "cpu ", 4) != 0)
+        return;
+
+    char* at = buffer + 4;
+    for (uint64_t& field : fields)
+        field = std::strtoull(at, &at, 10);
+    uint64_t total = 0;
+    for (uint64_t field : fields)
+        total += field;
+    uint64_t busy = total - fields[3] - fields[4]; // less idle and iowait
+
+    if (state.lastTotal != 0 && total > state.lastTotal)
+        state.cpuUsage = std::ceil(100.0 * static_cast<double>(busy - state.lastBusy) / static_cast<double>(total - state.lastTotal));
+    state.lastBusy = busy;
+    state.lastTotal = total;
+}
+
+// memory in use, total less available, from /proc/meminfo
+static void sampleMemory(SysfsState& state) {
+    char buffer[512];
+    state.systemRAM = std::nullopt;
+    if (timeDriverCall(state.calls[10], [&] { return readFile(state.meminfoFile, buffer, sizeof(buffer)); }) == 0)
+        return;
+
+    const char* total = std::strstr(buffer, "MemTotal:");
+    const char* available = std::strstr(buffer, "MemAvailable:");
+    if (!total || !available)
+        return;
+    uint64_t totalKB = std::strtoull(total + 9, nullptr, 10);
+    uint64_t availableKB = std::strtoull(available + 13, nullptr, 10);
+    state.systemRAM = static_cast<double>((totalKB - availableKB) / 1024);
+}
+
+static bool openSysfs(SysfsState& state) {
+    state.statFile = ::open("/proc/stat", O_RDONLY | O_CLOEXEC);
+    state.meminfoFile = ::open("/proc/meminfo", O_RDONLY | O_CLOEXEC);
+    if (state.statFile < 0 || state.meminfoFile < 0) {
+        std::cout << "Failure: could not read /proc/stat and /proc/meminfo" << std::endl;
+        return false;
+    }
+    state.calls[9] = registerDriverCall("/proc/stat", 9);
+    state.calls[10] = registerDriverCall("/proc/meminfo", 10);
+
+    std::string device = "/sys/class/drm/card" + std::to_string(state.gpu) + "/device";
+    std::string hwmon = findHwmon(device);
+    struct GPUFile {
+        std::size_t metric;
+        std::string path;
+        double scale;
+    };
+    const GPUFile gpuFiles[] = {
+        { 0, device + "/gpu_busy_percent", 1.0 },
+        { 1, hwmon + "/temp1_input", 0.001 }, // edge, millidegrees
+        { 2, hwmon + "/temp2_input", 0.001 }, // junction
+        { 3, hwmon + "/power1_average", 0.000001 }, // microwatts
+        { 4, hwmon + "/in0_input", 1.0 }, // vddgfx, millivolts
+        { 5, hwmon + "/freq1_input", 0.000001 }, // sclk, hertz
+        { 6, hwmon + "/fan1_input", 1.0 },
+        { 7, device + "/mem_info_vram_used", 1.0 / (1024.0 * 1024.0) }, // bytes
+        { 8, hwmon + "/freq2_input", 0.000001 } // mclk
+    };
+
+    int opened = 0;
+    for (const GPUFile& file : gpuFiles) {
+        if (hwmon.empty() && file.path.compare(0, device.size(), device) != 0)
+            continue;
+        state.files[file.metric] = ::open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+        state.scales[file.metric] = file.scale;
+        if (state.files[file.metric] >= 0) {
+            state.calls[file.metric] = registerDriverCall(file.path.substr(file.path.rfind('/') + 1).c_str(), static_cast<int>(file.metric));
+            opened++;
+        }
+    }
+    // newer kernels report the average as power1_input only
+    if (state.files[3] < 0 && !hwmon.empty()) {
+        state.files[3] = ::open((hwmon + "/power1_input").c_str(), O_RDONLY | O_CLOEXEC);
+        state.calls[3] = registerDriverCall("power1_input", 3);
+    }
+
+    if (opened == 0)
+        std::cout << "Failure: no amdgpu metrics under " << device << ", only cpu and memory are read" << std::endl;
+
+    return true;
+}
+
+static void closeSysfs(SysfsState& state) {
+    for (int& file : state.files) {
+        if (file >= 0)
+            ::close(file);
+        file = -1;
+    }
+    if (state.statFile >= 0)
+        ::close(state.statFile);
+    if (state.meminfoFile >= 0)
+        ::close(state.meminfoFile);
+    state.statFile = state.meminfoFile = -1;
+}
+
+MetricSource sysfsMetricSource(int gpu) {
+    std::shared_ptr<SysfsState> state = std::make_shared<SysfsState>();
+    state->gpu = gpu;
+
+    MetricSource source;
+    source.name = "sysfs";
+    source.open = [state] { return openSysfs(*state); };
+    source.beginSample = [state] {
+        sampleCPU(*state);
+        sampleMemory(*state);
+    };
+    for (std::size_t i = 0; i < getMetricNames().size(); i++) {
+        if (i == 9)
+            source.getters.push_back([state] { return state->cpuUsage; });
+        else if (i == 10)
+            source.getters.push_back([state] { return state->systemRAM; });
+        else if (i < 9)
+            source.getters.push_back([state, i] { return readSysfsValue(*state, i); });
+        else
+            source.getters.push_back([]() -> std::optional<double> { return std::nullopt; });
+    }
+    source.close = [state] { closeSysfs(*state); };
+    return source;
+}
+
+#pragma endregion
+#endif
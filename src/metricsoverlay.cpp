@@ -1,53 +1,19 @@
 #include "../include/metricsoverlay.h"
-#include <functional>
-
-// global vars
-std::atomic<bool> isOverlayOpen = false;
-std::atomic<bool> terminateOverlay = false;
-
-// local vars
-int numOfMetricsSelected = 0; // actual number of selected
-unsigned int selectedMetrics = 0; // binary representation
-sf::Color overlayColor;
-sf::Color labelColor;
-sf::Color valueColor;
-int textSize;
-int alpha;
-
-// for metric updates
-sf::Clock updateClock;
-const sf::Time updateInterval = sf::seconds(1);
-
-// struct to hold metric info
-struct MetricInfo {
-    int id;
-    sf::String label;
-    sf::String unit;
-    std::function<std::optional<adlx_double>()> getValue;
-};
-
-// vector to hold metric IDs and functions
-std::vector<MetricInfo> metrics = {
-    {0, "GPU Usage", "%", getGPUUsage},
-    {1, "GPU Temperature" , "C", getGPUTemperature},
-    {2, "GPU Hotspot Temperature", "C", getGPUHotspotTemperature},
-    {3, "GPU Power", " W", getGPUPower},
-    {4, "GPU Voltage", " mV", getGPUVoltage},
-    {5, "GPU Clock Speed", " MHz", getGPUClockSpeed},
-    {6, "GPU Fan Speed", " RPM", getGPUFanSpeed},
-    {7, "GPU VRAM", " MB", getGPUVRAM},
-    {8, "GPU VRAM Clock Speed",  " MHz", getGPUVRAMClockSpeed},
-    {9, "CPU Usage", "%", getCPUUsage},
-    {10, "System RAM", " MB", getSystemRAM}
-};
+#include <memory>
+#include "../include/metricsampler.h"
+#include "../include/overlayscene.h"
+#include "../include/selfcost.h"
+#include "../include/tracing.h"
 
 #pragma region Overlay Window Creation
 
-// function to create the overlay window
-void createOverlayWindow() {
-    // set global bools
-    isOverlayOpen = true;
-    terminateOverlay = false;
+// function to create the overlay window, runs on the controller's thread until it is asked to stop
+void createOverlayWindow(OverlayController& controller) {
+    setTraceThreadName("overlay");
+
+    // open to first frame, shown in the self-cost panel
+    sf::Clock openClock;
+    bool firstFrame = true;
 
     // get current screen resolution
     sf::VideoMode desktopMode = sf::VideoMode::getDesktopMode();
@@ -57,37 +23,20 @@ void createOverlayWindow() {
     // base resolution
     const float baseResolution = 1080.0f;
 
-    // dynamically scaled font size based on screen height
+    // everything scales with screen height
     float scaleFactor = static_cast<float>(screenHeight) / baseResolution;
-    int fontSize = static_cast<int>(textSize * scaleFactor); // 24 is base font size for 1080p
-
-    // vertical space between lines
-    int lineSpacing = static_cast<int>(fontSize * 0.4f);
-    // height of each line of text
-    int lineHeight = fontSize + lineSpacing;
-
-    // margins
-    const int marginTop = static_cast<int>(20 * scaleFactor);
-    const int marginBottom = marginTop;
-    const int marginLeft = static_cast<int>(20 * scaleFactor);
-    const int marginRight = marginLeft;
-
-    // load font
-    sf::Font font;
 
-    if (!font.openFromMemory(Inter_UI_Regular_otf, Inter_UI_Regular_otf_len)) {
-        std::cerr << "Failed to load font" << std::endl;
-    }   
+    // values come from the sampling loop shared with the main window, the overlay never calls adlx itself
+    std::vector<std::optional<adlx_double>> values;
+    uint64_t drawnSample = copyLatestSample(values);
+    std::string debugString;
 
-    // compute height of window (margins + total vertical space needed for text lines)
-    int windowHeight = marginTop + (lineHeight * numOfMetricsSelected) + marginBottom;
-
-    // estimate window width based on longest possible string
-    sf::Text sample(font, "GPU VRAM Clock Speed: 20000 MHz", fontSize);
-    int windowWidth = static_cast<int>(sample.getLocalBounds().size.x + marginLeft + marginRight);
+    // newest config published by the main window
+    std::shared_ptr<const OverlayConfig> config = controller.loadConfig();
+    std::unique_ptr<OverlayScene> scene = buildOverlayScene(*config, scaleFactor, values, debugString);
 
     // create window, set position and framerate
-    sf::RenderWindow window(sf::VideoMode(sf::Vector2u(windowWidth, windowHeight)), "Overlay", sf::Style::None);
+    sf::RenderWindow window(sf::VideoMode(sf::Vector2u(scene->layout.width, scene->layout.height)), "Overlay", sf::Style::None);
     window.setPosition(sf::Vector2i(0, 0));
     window.setFramerateLimit(60);
 
@@ -104,12 +53,7 @@ void createOverlayWindow() {
     // make window on top layer of screen and transparent
     makeWindowAlwaysOnTopAndTransparent(window, 164);
 
-    // create text lines
-    initializeHelper(); // initialize adlx
-    std::vector<sf::Text> metricLabels;
-    std::vector<sf::Text> metricValues;
-    drawLabels(metricLabels, font, fontSize, marginLeft, marginTop, lineHeight);
-    drawValues(metricValues, font, fontSize, marginLeft, marginTop, lineHeight, windowWidth);
+    sf::Clock frameClock;
 
     while (window.isOpen())
     {
@@ -117,97 +61,59 @@ void createOverlayWindow() {
         while (const std::optional event = window.pollEvent())
         {
             if (event->is<sf::Event::Closed>()) {
-                releaseAndTerminate();
                 window.close();
             } 
         }
 
         // if window is terminated from the main window
-        if (terminateOverlay) {
-            releaseAndTerminate();
+        if (controller.stopRequested()) {
             window.close();
         }
 
-        // update metrics every second
-        if (updateClock.getElapsedTime() >= updateInterval) {
-            // clear the current lines
-            metricValues.clear();
+        // the main window published a new config, apply it before drawing this frame
+        std::shared_ptr<const OverlayConfig> latest = controller.loadConfig();
+        if (latest->version != config->version) {
+            // a rebuilt scene may be a different size, resize the existing window in place
+            if (reconfigureOverlayScene(scene, *config, *latest, scaleFactor, values, debugString)) {
+                window.setSize(sf::Vector2u(scene->layout.width, scene->layout.height));
+                window.setView(sf::View(sf::FloatRect(sf::Vector2f(0.f, 0.f), sf::Vector2f(static_cast<float>(scene->layout.width), static_cast<float>(scene->layout.height)))));
+            }
+            makeWindowAlwaysOnTopAndTransparent(window, overlayWindowAlpha(*latest));
+            config = latest;
+        }
 
+        // new sample from the sampling loop, once per interval
+        if (getSampleCount() != drawnSample) {
             // recall in case new fullscreen app was opened
-            makeWindowAlwaysOnTopAndTransparent(window, alpha);
+            makeWindowAlwaysOnTopAndTransparent(window, overlayWindowAlpha(*config));
  
-            drawValues(metricValues, font, fontSize, marginLeft, marginTop, lineHeight, windowWidth);
-            updateClock.restart();
+            drawnSample = copyLatestSample(values);
+            updateOverlayScene(*scene, *config, values, debugString);
         }
 
         // draw here
-        window.clear(overlayColor);
-        for (const auto& t : metricLabels)
-            window.draw(t);
-        for (const auto& t : metricValues)
-            window.draw(t);
-        window.display();
-    }
-
-    releaseAndTerminate();
-    isOverlayOpen = false;
-}
+        frameClock.restart();
+        renderOverlayFrame(window, scene->labels, scene->values, scene->sparklines, config->showSelfCost ? &scene->debugText : nullptr);
 
-// function to create vector of metric labels
-void drawLabels(std::vector<sf::Text>& lines, sf::Font& font, int fontSize, const int marginLeft, const int marginTop, int lineHeight) {
-    int verticalOffset = 0;
-
-    // populate text vector
-    for (size_t i = 0; i < metrics.size(); i++) {\
-        // only use selected metrics
-        if (selectedMetrics & (1 << i)) {
-            sf::Text text(font);
-            text.setCharacterSize(fontSize);
-            text.setFillColor(labelColor);
-            text.setPosition(sf::Vector2f(static_cast<float>(marginLeft), static_cast<float>(marginTop + verticalOffset * lineHeight)));
-            text.setString(metrics[i].label + ": ");
-            lines.push_back(text);
-            verticalOffset++;
+        // cpu cost of the frame, measured before display() sleeps for the framerate limit
+        recordRenderFrame(frameClock.getElapsedTime().asMicroseconds());
+        {
+            // waits for the framerate limit and the swap, a long one here is the compositor or the driver
+            TraceScope displayScope("display");
+            window.display();
         }
-    }    
-}
-
-// function to create the vector of metric values
-void drawValues(std::vector<sf::Text>& lines, sf::Font& font, int fontSize, const int marginLeft, const int marginTop, int lineHeight, int windowWidth) {
 
-    // setup adlx services 
-    setupServices();
-
-    int verticalOffset = 0;
-
-    // populate text vector
-    for (size_t i = 0; i < metrics.size(); i++) {
-        if (selectedMetrics & (1 << i)) {
-            sf::Text text(font);
-            text.setCharacterSize(fontSize);
-            text.setFillColor(valueColor);
-
-            // get the width of the value text
-            auto value = metrics[i].getValue();
-            std::string valueStr = value.has_value() ? std::to_string(std::lround(value.value())) + metrics[i].unit : "N/A";
-            text.setString(valueStr);
-            float textWidth = text.getLocalBounds().size.x; 
-
-            // position on the right side of the window
-            float x = static_cast<float>(windowWidth - marginLeft - textWidth);
-
-            // set position based on the margin and vertical offset
-            float y = static_cast<float>(marginTop + verticalOffset * lineHeight);
-            text.setPosition(sf::Vector2f(x, y));
-
-            lines.push_back(text);
-            verticalOffset++;
+        if (firstFrame) {
+            recordOverlayOpen(openClock.getElapsedTime().asMicroseconds());
+            firstFrame = false;
         }
     }
 }
 
 // function to make window always on top
 void makeWindowAlwaysOnTopAndTransparent(sf::RenderWindow& window, int alpha) {
+    TraceScope scope("makeWindowAlwaysOnTopAndTransparent");
+
     HWND hwnd = window.getNativeHandle();
 
     // get existing style
@@ -227,39 +133,3 @@ void makeWindowAlwaysOnTopAndTransparent(sf::RenderWindow& window, int alpha) {
 
 #pragma endregion
 
-#pragma region Functions called from main
-
-// function to set the selected metrics for display
-void setSelectedMetrics (unsigned int selectedMetricsBinary) {
-    selectedMetrics = selectedMetricsBinary;
-
-    // reset number selected
-    numOfMetricsSelected = 0;
-
-    // determine number of selected metrics
-    for (int i = 0; i < 11; i++) {
-        if (selectedMetricsBinary & (1 << i)) {
-            numOfMetricsSelected++;
-        }
-    }
-}
-
-// function for setting overlay prefs
-void setPreferences(float overlayCol[3], float labelCol[3], float valueCol[3], float alph, int txtSize) {
-    // set colors
-    overlayColor.r = static_cast<int>(overlayCol[0] * 255);
-    overlayColor.g = static_cast<int>(overlayCol[1] * 255);
-    overlayColor.b = static_cast<int>(overlayCol[2] * 255);
-    labelColor.r = static_cast<int>(labelCol[0] * 255);
-    labelColor.g = static_cast<int>(labelCol[1] * 255);
-    labelColor.b = static_cast<int>(labelCol[2] * 255);
-    valueColor.r = static_cast<int>(valueCol[0] * 255);
-    valueColor.g = static_cast<int>(valueCol[1] * 255);
-    valueColor.b = static_cast<int>(valueCol[2] * 255);
-
-    // set transparency and text size
-    alpha = static_cast<int>(alph * 255 + 0.5f);
-    textSize = txtSize;
-}
-
-#pragma endregion
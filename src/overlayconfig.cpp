@@ -0,0 +1,33 @@
+#include "../include/overlayconfig.h"
+
+bool operator==(const OverlayConfig& a, const OverlayConfig& b) {
+    return a.selectedMetrics == b.selectedMetrics
+        && a.overlayColor == b.overlayColor
+        && a.labelColor == b.labelColor
+        && a.valueColor == b.valueColor
+        && a.transparency == b.transparency
+        && a.textSize == b.textSize
+        && a.showSparklines == b.showSparklines
+        && a.sparklineSeconds == b.sparklineSeconds
+        && a.showSelfCost == b.showSelfCost
+        && a.columns == b.columns
+        && a.layoutMode == b.layoutMode;
+}
+
+bool operator!=(const OverlayConfig& a, const OverlayConfig& b) {
+    return !(a == b);
+}
+
+bool sameOverlayLayout(const OverlayConfig& a, const OverlayConfig& b) {
+    return a.selectedMetrics == b.selectedMetrics
+        && a.textSize == b.textSize
+        && a.showSparklines == b.showSparklines
+        && a.sparklineSeconds == b.sparklineSeconds
+        && a.showSelfCost == b.showSelfCost
+        && a.columns == b.columns
+        && a.layoutMode == b.layoutMode;
+}
+
+int overlayWindowAlpha(const OverlayConfig& config) {
+    return static_cast<int>(config.transparency * 255 + 0.5f);
+}
@@ -0,0 +1,50 @@
+#include "../include/overlaycontroller.h"
+
+OverlayController::~OverlayController() {
+    stop();
+}
+
+bool OverlayController::start(std::function<void(OverlayController&)> run) {
+    if (running.load(std::memory_order_acquire))
+        return false;
+
+    // the previous overlay has already returned, this only reclaims its thread
+    if (thread.joinable())
+        thread.join();
+
+    stopping.store(false, std::memory_order_release);
+    running.store(true, std::memory_order_release);
+    thread = std::thread([this, run] {
+        run(*this);
+        running.store(false, std::memory_order_release);
+    });
+    return true;
+}
+
+void OverlayController::requestStop() {
+    stopping.store(true, std::memory_order_release);
+}
+
+void OverlayController::stop() {
+    requestStop();
+    if (thread.joinable())
+        thread.join();
+}
+
+bool OverlayController::isRunning() const {
+    return running.load(std::memory_order_acquire);
+}
+
+bool OverlayController::stopRequested() const {
+    return stopping.load(std::memory_order_acquire);
+}
+
+void OverlayController::publishConfig(const OverlayConfig& next) {
+    std::shared_ptr<OverlayConfig> snapshot = std::make_shared<OverlayConfig>(next);
+    snapshot->version = ++lastVersion;
+    std::atomic_store(&config, std::shared_ptr<const OverlayConfig>(std::move(snapshot)));
+}
+
+std::shared_ptr<const OverlayConfig> OverlayController::loadConfig() const {
+    return std::atomic_load(&config);
+}
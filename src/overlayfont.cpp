@@ -0,0 +1,95 @@
+#include "../include/overlayfont.h"
+#include "../include/fontcache.h"
+#include <algorithm>
+#include <iostream>
+
+#pragma region OverlayFont
+
+bool OverlayFont::load(int size) {
+    characterSize = size;
+    atlas = acquireGlyphAtlas(size);
+    if (!atlas)
+        return false;
+
+    // white glyphs with the coverage in alpha, the same as sf::Font's pages
+    std::vector<std::uint8_t> rgba(atlas->pixels.size() * 4, 255);
+    for (size_t i = 0; i < atlas->pixels.size(); i++)
+        rgba[i * 4 + 3] = atlas->pixels[i];
+
+    if (!texture.resize(sf::Vector2u(atlas->width, atlas->height))) {
+        std::cout << "Failure: could not create the glyph atlas texture" << std::endl;
+        return false;
+    }
+    texture.update(rgba.data());
+    texture.setSmooth(true);
+
+    // anything outside the atlas draws as '?'
+    for (int c = 0; c < 256; c++) {
+        const AtlasGlyph& g = atlas->glyphs[c].advance > 0.f ? atlas->glyphs[c] : atlas->glyphs['?'];
+        sf::Glyph& glyph = glyphs[c];
+        glyph.advance = g.advance;
+        glyph.bounds = sf::FloatRect(sf::Vector2f(static_cast<float>(g.left), static_cast<float>(g.top)), sf::Vector2f(static_cast<float>(g.width), static_cast<float>(g.height)));
+        glyph.textureRect = sf::IntRect(sf::Vector2i(g.x, g.y), sf::Vector2i(g.width, g.height));
+    }
+    return true;
+}
+
+#pragma endregion
+
+#pragma region TextBatch
+
+// two triangles per glyph, laid out like sf::Text (baseline one character size below the position)
+void TextBatch::add(const std::string& text, sf::Vector2f position, sf::Color color) {
+    const float padding = 1.f;
+    float x = position.x;
+    float y = position.y + font->getCharacterSize();
+
+    for (unsigned char c : text) {
+        if (c == '\n') {
+            x = position.x;
+            y += font->getLineSpacing();
+            continue;
+        }
+
+        const sf::Glyph& glyph = font->getGlyph(c);
+        if (c != ' ' && glyph.textureRect.size.x > 0) {
+            float left = x + glyph.bounds.position.x - padding;
+            float top = y + glyph.bounds.position.y - padding;
+            float right = x + glyph.bounds.position.x + glyph.bounds.size.x + padding;
+            float bottom = y + glyph.bounds.position.y + glyph.bounds.size.y + padding;
+
+            float u1 = glyph.textureRect.position.x - padding;
+            float v1 = glyph.textureRect.position.y - padding;
+            float u2 = glyph.textureRect.position.x + glyph.textureRect.size.x + padding;
+            float v2 = glyph.textureRect.position.y + glyph.textureRect.size.y + padding;
+
+            vertices.push_back({ { left, top }, color, { u1, v1 } });
+            vertices.push_back({ { right, top }, color, { u2, v1 } });
+            vertices.push_back({ { left, bottom }, color, { u1, v2 } });
+            vertices.push_back({ { left, bottom }, color, { u1, v2 } });
+            vertices.push_back({ { right, top }, color, { u2, v1 } });
+            vertices.push_back({ { right, bottom }, color, { u2, v2 } });
+        }
+        x += glyph.advance;
+    }
+}
+
+float TextBatch::measure(const std::string& text) const {
+    float width = 0.f;
+    float lineWidth = 0.f;
+    for (unsigned char c : text) {
+        lineWidth = c == '\n' ? 0.f : lineWidth + font->getGlyph(c).advance;
+        width = std::max(width, lineWidth);
+    }
+    return width;
+}
+
+void TextBatch::draw(sf::RenderTarget& target, sf::RenderStates states) const {
+    if (vertices.empty())
+        return;
+
+    states.texture = &font->getTexture();
+    target.draw(vertices.data(), vertices.size(), sf::PrimitiveType::Triangles, states);
+}
+
+#pragma endregion
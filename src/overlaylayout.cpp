@@ -0,0 +1,91 @@
+#include "../include/overlaylayout.h"
+#include <algorithm>
+
+// sum of the advances of every character, kerning is small enough to be covered by the gaps
+float GlyphMetrics::measure(const std::string& text) const {
+    float width = 0.f;
+    for (unsigned char c : text)
+        width += advances[c];
+    return width;
+}
+
+OverlayLayout computeOverlayLayout(const std::vector<LayoutItem>& items, const GlyphMetrics& glyphs, const LayoutParams& params) {
+    OverlayLayout layout;
+    layout.lineHeight = params.fontSize + params.lineSpacing;
+
+    size_t count = items.size();
+    size_t columns = std::clamp<size_t>(static_cast<size_t>(std::max(params.columns, 1)), 1, std::max<size_t>(count, 1));
+    size_t rows = count > 0 ? (count + columns - 1) / columns : 0;
+
+    // filling column by column can leave trailing columns empty (e.g. 4 items in 3 columns), drop them
+    if (params.mode == LayoutMode::MultiColumn && rows > 0)
+        columns = (count + rows - 1) / rows;
+
+    // measure every label and worst case value once
+    std::vector<float> labelWidths(count);
+    std::vector<float> valueWidths(count);
+    for (size_t i = 0; i < count; i++) {
+        labelWidths[i] = glyphs.measure(items[i].label);
+        valueWidths[i] = glyphs.measure(items[i].widestValue);
+    }
+
+    // which column and row each item lands in
+    std::vector<size_t> itemColumn(count);
+    std::vector<size_t> itemRow(count);
+    for (size_t i = 0; i < count; i++) {
+        if (params.mode == LayoutMode::Grid) {
+            itemColumn[i] = i % columns;
+            itemRow[i] = i / columns;
+        }
+        else {
+            itemColumn[i] = i / rows;
+            itemRow[i] = i % rows;
+        }
+    }
+
+    // widest label and value per column, grid cells all share the overall widest
+    std::vector<float> labelColumnWidth(columns, 0.f);
+    std::vector<float> valueColumnWidth(columns, 0.f);
+    for (size_t i = 0; i < count; i++) {
+        size_t c = params.mode == LayoutMode::Grid ? 0 : itemColumn[i];
+        labelColumnWidth[c] = std::max(labelColumnWidth[c], labelWidths[i]);
+        valueColumnWidth[c] = std::max(valueColumnWidth[c], valueWidths[i]);
+    }
+    if (params.mode == LayoutMode::Grid) {
+        std::fill(labelColumnWidth.begin(), labelColumnWidth.end(), labelColumnWidth[0]);
+        std::fill(valueColumnWidth.begin(), valueColumnWidth.end(), valueColumnWidth[0]);
+    }
+
+    // spacing between label and value, before the graph and between columns
+    float valueGap = params.fontSize * 0.5f;
+    float graphGap = params.graphWidth > 0 ? static_cast<float>(params.marginLeft) : 0.f;
+    float columnGap = static_cast<float>(params.marginLeft * 2);
+
+    // x of each column
+    std::vector<float> columnX(columns);
+    float x = static_cast<float>(params.marginLeft);
+    for (size_t c = 0; c < columns; c++) {
+        columnX[c] = x;
+        x += labelColumnWidth[c] + valueGap + valueColumnWidth[c] + graphGap + params.graphWidth + columnGap;
+    }
+    float contentRight = x - columnGap;
+
+    layout.cells.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        size_t c = itemColumn[i];
+        CellLayout& cell = layout.cells[i];
+        cell.labelX = columnX[c];
+        cell.valueRight = columnX[c] + labelColumnWidth[c] + valueGap + valueColumnWidth[c];
+        cell.graphX = cell.valueRight + graphGap;
+        cell.y = static_cast<float>(params.marginTop + itemRow[i] * layout.lineHeight);
+    }
+
+    // footer goes under the last row
+    layout.footerY = static_cast<float>(params.marginTop + rows * layout.lineHeight);
+
+    float width = std::max(contentRight, static_cast<float>(params.marginLeft + params.footerWidth)) + params.marginLeft;
+    int footer = params.footerHeight > 0 ? params.footerHeight + params.lineSpacing : 0;
+    layout.width = static_cast<int>(width + 0.5f);
+    layout.height = params.marginTop + static_cast<int>(rows) * layout.lineHeight + footer + params.marginTop;
+    return layout;
+}
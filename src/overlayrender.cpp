@@ -0,0 +1,191 @@
+#include "../include/overlayrender.h"
+#include "../include/metricsource.h"
+#include "../include/tracing.h"
+#include <cmath>
+#include <cstdio>
+
+// overlay state shared with the benchmarks
+int numOfMetricsSelected = 0; // actual number of selected
+unsigned int selectedMetrics = 0; // binary representation
+sf::Color overlayColor;
+sf::Color labelColor;
+sf::Color valueColor;
+int textSize;
+int alpha;
+
+// display info for every metric, converted once from the core table (metricsource.h)
+static std::vector<MetricInfo> buildMetricInfo() {
+    std::vector<MetricInfo> info;
+    const std::vector<MetricName>& names = getMetricNames();
+    for (std::size_t i = 0; i < names.size(); i++) {
+        std::string unit = displayUnit(static_cast<int>(i));
+        info.push_back({ static_cast<int>(i), names[i].label, sf::String::fromUtf8(unit.begin(), unit.end()), names[i].precision, names[i].maxDigits });
+    }
+    return info;
+}
+
+const std::vector<MetricInfo> metrics = buildMetricInfo();
+
+#pragma region Overlay Rendering
+
+// function to measure the advance of every character the overlay can show, done once per font size
+GlyphMetrics measureGlyphs(const OverlayFont& font) {
+    GlyphMetrics glyphs;
+    std::string chars = "0123456789.:N/A ";
+    for (const auto& metric : metrics)
+        chars += metric.label.toAnsiString() + metric.unit.toAnsiString();
+
+    for (unsigned char c : chars) {
+        if (glyphs.advances[c] == 0.f)
+            glyphs.advances[c] = font.getGlyph(c).advance;
+    }
+    return glyphs;
+}
+
+// function to build the layout items for the selected metrics
+std::vector<LayoutItem> buildLayoutItems(const GlyphMetrics& glyphs) {
+    // worst case values are written with the widest digit
+    char widestDigit = '0';
+    for (char d = '1'; d <= '9'; d++) {
+        if (glyphs.advances[static_cast<unsigned char>(d)] > glyphs.advances[static_cast<unsigned char>(widestDigit)])
+            widestDigit = d;
+    }
+
+    std::vector<LayoutItem> items;
+    for (size_t i = 0; i < metrics.size(); i++) {
+        if (selectedMetrics & (1 << i)) {
+            LayoutItem item;
+            item.label = metrics[i].label.toAnsiString() + ": ";
+
+            std::string value(metrics[i].maxDigits, widestDigit);
+            if (metrics[i].precision > 0)
+                value += "." + std::string(metrics[i].precision, widestDigit);
+            value += metrics[i].unit.toAnsiString();
+            item.widestValue = glyphs.measure(value) >= glyphs.measure("N/A") ? value : "N/A";
+
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+// function to fill the batch with the metric labels
+void drawLabels(TextBatch& lines, const OverlayLayout& layout) {
+    TraceScope scope("drawLabels");
+    int verticalOffset = 0;
+    lines.clear();
+
+    // populate text batch
+    for (size_t i = 0; i < metrics.size(); i++) {
+        // only use selected metrics
+        if (selectedMetrics & (1 << i)) {
+            const CellLayout& cell = layout.cells[verticalOffset];
+            lines.add(metrics[i].label.toAnsiString() + ": ", sf::Vector2f(cell.labelX, cell.y), labelColor);
+            verticalOffset++;
+        }
+    }    
+}
+
+// function to fill the batch with the metric values
+void drawValues(TextBatch& lines, const OverlayLayout& layout, const std::vector<std::optional<double>>& values) {
+    TraceScope scope("drawValues");
+    int verticalOffset = 0;
+    lines.clear();
+
+    // populate text batch
+    for (size_t i = 0; i < metrics.size(); i++) {
+        if (selectedMetrics & (1 << i)) {
+            const CellLayout& cell = layout.cells[verticalOffset];
+
+            // get the width of the value text
+            const auto& value = values[i];
+            std::string valueStr = value.has_value() ? formatValue(value.value(), metrics[i].precision) + metrics[i].unit.toAnsiString() : "N/A";
+            float textWidth = lines.measure(valueStr);
+
+            // right align to the value column of the cell
+            lines.add(valueStr, sf::Vector2f(cell.valueRight - textWidth, cell.y), valueColor);
+            verticalOffset++;
+        }
+    }
+}
+
+// function to append the latest values to the sparklines (one per selected metric)
+void pushSparklines(std::vector<Sparkline>& sparklines, const std::vector<std::optional<double>>& values) {
+    if (sparklines.empty())
+        return;
+
+    int verticalOffset = 0;
+    for (size_t i = 0; i < metrics.size(); i++) {
+        if (selectedMetrics & (1 << i)) {
+            // unsupported metrics just keep an empty graph
+            if (values[i].has_value())
+                sparklines[verticalOffset].push(static_cast<float>(values[i].value()));
+            verticalOffset++;
+        }
+    }
+}
+
+// function to move the sparklines to the graph column of their cells
+void positionSparklines(std::vector<Sparkline>& sparklines, const OverlayLayout& layout, float offsetY) {
+    for (size_t i = 0; i < sparklines.size() && i < layout.cells.size(); i++)
+        sparklines[i].setPosition(sf::Vector2f(layout.cells[i].graphX, layout.cells[i].y + offsetY));
+}
+
+// function to draw one overlay frame, returns the number of draw calls issued
+int renderOverlayFrame(sf::RenderTarget& target, const TextBatch& labels, const TextBatch& values, const std::vector<Sparkline>& sparklines, const TextBatch* debugText) {
+    TraceScope scope("renderOverlayFrame");
+    int drawCalls = 2;
+
+    target.clear(overlayColor);
+    target.draw(labels);
+    target.draw(values);
+    for (const auto& s : sparklines) {
+        target.draw(s);
+        drawCalls++;
+    }
+    if (debugText) {
+        target.draw(*debugText);
+        drawCalls++;
+    }
+
+    return drawCalls;
+}
+
+#pragma endregion
+
+#pragma region Functions called from main
+
+// function to set the selected metrics for display
+void setSelectedMetrics (unsigned int selectedMetricsBinary) {
+    selectedMetrics = selectedMetricsBinary;
+
+    // reset number selected
+    numOfMetricsSelected = 0;
+
+    // determine number of selected metrics
+    for (size_t i = 0; i < metrics.size(); i++) {
+        if (selectedMetricsBinary & (1 << i)) {
+            numOfMetricsSelected++;
+        }
+    }
+}
+
+// function for setting overlay prefs
+void setPreferences(const float overlayCol[3], const float labelCol[3], const float valueCol[3], float alph, int txtSize) {
+    // set colors
+    overlayColor.r = static_cast<int>(overlayCol[0] * 255);
+    overlayColor.g = static_cast<int>(overlayCol[1] * 255);
+    overlayColor.b = static_cast<int>(overlayCol[2] * 255);
+    labelColor.r = static_cast<int>(labelCol[0] * 255);
+    labelColor.g = static_cast<int>(labelCol[1] * 255);
+    labelColor.b = static_cast<int>(labelCol[2] * 255);
+    valueColor.r = static_cast<int>(valueCol[0] * 255);
+    valueColor.g = static_cast<int>(valueCol[1] * 255);
+    valueColor.b = static_cast<int>(valueCol[2] * 255);
+
+    // set transparency and text size
+    alpha = static_cast<int>(alph * 255 + 0.5f);
+    textSize = txtSize;
+}
+
+#pragma endregion
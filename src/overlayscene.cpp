@@ -0,0 +1,130 @@
+#include "../include/overlayscene.h"
+#include <algorithm>
+#include <iostream>
+#include "../include/metricsampler.h"
+#include "../include/selfcost.h"
+
+// function to copy a config snapshot into the render globals, only ever called from the overlay thread
+static void applyOverlayConfig(const OverlayConfig& config) {
+    setSelectedMetrics(config.selectedMetrics);
+    setPreferences(config.overlayColor.data(), config.labelColor.data(), config.valueColor.data(), config.transparency, config.textSize);
+}
+
+// function to load the fonts, lay out the applied config and draw the labels
+static void layoutOverlayScene(OverlayScene& scene, const OverlayConfig& config, float scaleFactor) {
+    // dynamically scaled font size based on screen height
+    int fontSize = static_cast<int>(config.textSize * scaleFactor); // 24 is base font size for 1080p
+
+    // load font from the shared glyph cache, reopening the overlay reuses the same atlas
+    if (!scene.font.load(fontSize)) {
+        std::cerr << "Failed to load font" << std::endl;
+    }
+
+    // measure the glyphs once, the labels and worst case values are laid out from these
+    scene.glyphs = measureGlyphs(scene.font);
+
+    LayoutParams& layoutParams = scene.layoutParams;
+    layoutParams.fontSize = fontSize;
+    layoutParams.lineSpacing = static_cast<int>(fontSize * 0.4f); // vertical space between lines
+    layoutParams.marginTop = static_cast<int>(20 * scaleFactor);
+    layoutParams.marginLeft = static_cast<int>(20 * scaleFactor);
+    layoutParams.columns = config.columns;
+    layoutParams.mode = config.layoutMode;
+    layoutParams.graphWidth = config.showSparklines ? fontSize * 4 : 0; // extra column in each cell for the sparklines
+
+    // optional self-cost panel below the metrics in a smaller font
+    if (config.showSelfCost) {
+        if (!scene.debugFont.load(std::max(10, fontSize / 2))) {
+            std::cerr << "Failed to load font" << std::endl;
+        }
+
+        // size for a worst case report
+        SelfCostReport worstCase{ 999.99, 999.99, 999, 999.99, 999, 99999, 9999ull << 20, 9999.9, 9999.9, 9999.9, 9999.9, 9999.9, 999.9, 999.99 };
+        layoutParams.footerWidth = static_cast<int>(scene.debugText.measure(formatSelfCostReport(worstCase)));
+        layoutParams.footerHeight = static_cast<int>(scene.debugFont.getLineSpacing()) * 2 + scene.debugFont.getCharacterSize();
+    }
+
+    scene.layout = computeOverlayLayout(buildLayoutItems(scene.glyphs), scene.glyphs, layoutParams);
+    drawLabels(scene.labels, scene.layout);
+}
+
+// function to create one sparkline per selected metric, sized to hold the chosen history
+static void createSparklines(OverlayScene& scene, const OverlayConfig& config) {
+    if (!config.showSparklines)
+        return;
+
+    std::size_t capacity = static_cast<std::size_t>(config.sparklineSeconds * 1000 / sampleIntervalMs);
+    sf::Vector2f graphSize(static_cast<float>(scene.layoutParams.graphWidth), static_cast<float>(scene.layoutParams.fontSize));
+    for (int i = 0; i < numOfMetricsSelected; i++)
+        scene.sparklines.emplace_back(capacity, sf::Vector2f(), graphSize, valueColor);
+}
+
+// the sparkline history survives a new config as long as the graphs still mean and measure the same
+static bool keepsSparklines(const OverlayConfig& previous, const OverlayConfig& next) {
+    return previous.showSparklines && next.showSparklines
+        && previous.selectedMetrics == next.selectedMetrics
+        && previous.sparklineSeconds == next.sparklineSeconds
+        && previous.textSize == next.textSize;
+}
+
+// function to redraw the self-cost panel at the current footer
+static void drawDebugText(OverlayScene& scene, const std::string& debugString) {
+    scene.debugText.clear();
+    scene.debugText.add(debugString, sf::Vector2f(static_cast<float>(scene.layoutParams.marginLeft), scene.layout.footerY), labelColor);
+}
+
+std::unique_ptr<OverlayScene> buildOverlayScene(const OverlayConfig& config, float scaleFactor, const std::vector<std::optional<double>>& values,
+    const std::string& debugString, OverlayScene* previous, const OverlayConfig* previousConfig) {
+    applyOverlayConfig(config);
+
+    std::unique_ptr<OverlayScene> scene = std::make_unique<OverlayScene>();
+    layoutOverlayScene(*scene, config, scaleFactor);
+
+    drawValues(scene->values, scene->layout, values);
+
+    // carry the history over when the graphs are unchanged apart from their colour
+    if (previous && previousConfig && keepsSparklines(*previousConfig, config)) {
+        scene->sparklines = std::move(previous->sparklines);
+        for (Sparkline& sparkline : scene->sparklines)
+            sparkline.setColor(valueColor);
+    }
+    else {
+        createSparklines(*scene, config);
+        pushSparklines(scene->sparklines, values);
+    }
+    positionSparklines(scene->sparklines, scene->layout, scene->layoutParams.lineSpacing * 0.5f);
+
+    if (config.showSelfCost)
+        drawDebugText(*scene, debugString);
+
+    return scene;
+}
+
+bool reconfigureOverlayScene(std::unique_ptr<OverlayScene>& scene, const OverlayConfig& previous, const OverlayConfig& next, float scaleFactor,
+    const std::vector<std::optional<double>>& values, const std::string& debugString) {
+    if (!sameOverlayLayout(previous, next)) {
+        scene = buildOverlayScene(next, scaleFactor, values, debugString, scene.get(), &previous);
+        return true;
+    }
+
+    // colours or transparency only: keep the fonts, layout and sparkline history, redraw the text in the new colours
+    applyOverlayConfig(next);
+    drawLabels(scene->labels, scene->layout);
+    drawValues(scene->values, scene->layout, values);
+    for (Sparkline& sparkline : scene->sparklines)
+        sparkline.setColor(valueColor);
+    if (next.showSelfCost)
+        drawDebugText(*scene, debugString);
+    return false;
+}
+
+void updateOverlayScene(OverlayScene& scene, const OverlayConfig& config, const std::vector<std::optional<double>>& values, std::string& debugString) {
+    drawValues(scene.values, scene.layout, values);
+    pushSparklines(scene.sparklines, values);
+
+    // refresh the self-cost panel with the last second of counters
+    if (config.showSelfCost) {
+        debugString = formatSelfCostReport(updateSelfCostReport());
+        drawDebugText(scene, debugString);
+    }
+}
@@ -1,4 +1,13 @@
 #include "../include/performancemonitor.h"
+#include "../include/framestats.h"
+#include "../include/driverlatency.h"
+#include "../include/selfcost.h"
+#include "../include/tracing.h"
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 // local pointers
 adlx::IADLXSystemMetricsPtr systemMetrics;
@@ -11,44 +20,139 @@ adlx::IADLXGPUPtr oneGPU;
 
 ADLXHelper helper;
 
-// function to intialize ADLX helper
-void initializeHelper() {
-	ADLX_RESULT res = ADLX_FAIL;
+// rolling frame time stats fed from the adlx fps history
+FrameTimeStats frameStats;
+adlx_int64 lastFPSTimestamp = 0;
+bool fpsTracking = false;
 
-	// initialize ADLX
-	res = helper.Initialize();
+// current fps read once per sample, the fps and frame time getters both report it
+std::optional<adlx_double> currentFPS;
 
-	if (ADLX_SUCCEEDED(res))
-	{
-		//std::cout << "ADLX init successful." << std::endl;
-	}
-	else
-		std::cout << "ADLX init failed." << std::endl;
+// adlx is brought up once, in the background at app start (or by the first caller if that has not run),
+// and stays initialized until the app exits
+bool helperInitialized = false;
+std::once_flag helperInitOnce;
+std::thread startupThread;
+adlx_handle preloadedDLL = nullptr;
+
+// how far back each history request looks (a few sampling intervals)
+const adlx_int fpsHistoryLookbackMs = 5000;
+
+// driver latency histogram of every call made per sample, the accessors tagged with the metric they read
+static const int gpuUsageCall = registerDriverCall("GPUUsage", 0);
+static const int gpuTemperatureCall = registerDriverCall("GPUTemperature", 1);
+static const int gpuHotspotTemperatureCall = registerDriverCall("GPUHotspotTemperature", 2);
+static const int gpuPowerCall = registerDriverCall("GPUPower", 3);
+static const int gpuVoltageCall = registerDriverCall("GPUVoltage", 4);
+static const int gpuClockSpeedCall = registerDriverCall("GPUClockSpeed", 5);
+static const int gpuFanSpeedCall = registerDriverCall("GPUFanSpeed", 6);
+static const int gpuVRAMCall = registerDriverCall("GPUVRAM", 7);
+static const int gpuVRAMClockSpeedCall = registerDriverCall("GPUVRAMClockSpeed", 8);
+static const int cpuUsageCall = registerDriverCall("CPUUsage", 9);
+static const int systemRAMCall = registerDriverCall("SystemRAM", 10);
+static const int currentFPSCall = registerDriverCall("GetCurrentFPS", 11);
+static const int fpsHistoryCall = registerDriverCall("GetFPSHistory");
+static const int performanceServicesCall = registerDriverCall("GetPerformanceMonitoringServices");
+static const int gpusCall = registerDriverCall("GetGPUs");
+static const int systemMetricsSupportCall = registerDriverCall("GetSupportedSystemMetrics");
+static const int gpuMetricsSupportCall = registerDriverCall("GetSupportedGPUMetrics");
+static const int allMetricsCall = registerDriverCall("GetCurrentAllMetrics");
+static const int gpuMetricsCall = registerDriverCall("GetGPUMetrics");
+static const int systemMetricsCall = registerDriverCall("GetSystemMetrics");
+
+// microseconds since a startup phase began
+static int64_t elapsedUs(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// function to intialize ADLX helper, other callers block until the first one has finished
+bool initializeHelper() {
+	std::call_once(helperInitOnce, [] {
+		// load the dll first so its cost is timed apart from the driver init,
+		// the helper's own load below then only bumps the reference count
+		auto phaseStart = std::chrono::steady_clock::now();
+		preloadedDLL = adlx_load_library(ADLX_DLL_NAME);
+		int64_t dllLoadUs = elapsedUs(phaseStart);
+
+		// initialize ADLX
+		phaseStart = std::chrono::steady_clock::now();
+		ADLX_RESULT res = helper.Initialize();
+		int64_t initUs = elapsedUs(phaseStart);
+
+		if (ADLX_SUCCEEDED(res))
+		{
+			//std::cout << "ADLX init successful." << std::endl;
+			helperInitialized = true;
+		}
+		else {
+			std::cout << "ADLX init failed." << std::endl;
+			recordADLXStartup(dllLoadUs, initUs, 0, 0);
+			return;
+		}
+
+		// enumerate the gpus
+		phaseStart = std::chrono::steady_clock::now();
+		adlx::IADLXGPUListPtr gpus;
+		countADLXCall();
+		res = helper.GetSystemServices()->GetGPUs(&gpus);
+		if (ADLX_FAILED(res))
+			std::cout << "Get GPU list failed." << std::endl;
+		int64_t gpuEnumerationUs = elapsedUs(phaseStart);
+
+		// take one sample so the metric support is known and the overlay's first tick is warm
+		phaseStart = std::chrono::steady_clock::now();
+		setupServices();
+		int64_t firstSampleUs = elapsedUs(phaseStart);
+
+		recordADLXStartup(dllLoadUs, initUs, gpuEnumerationUs, firstSampleUs);
+	});
+
+	return helperInitialized;
+}
 
+// function to start initializing ADLX in the background, called once when the app starts
+void startADLXInitialization() {
+	startupThread = std::thread([] { initializeHelper(); });
 }
 
 // function to terminate the helper
 void terminateHelper() {
-	ADLX_RESULT res = ADLX_FAIL;
+	// the background start may still be running if the app is closed right away
+	if (startupThread.joinable())
+		startupThread.join();
 
-	// destroy ADLX
-	res = helper.Terminate();
-	//std::cout << "Destroy ADLX result: " << res << std::endl;
+	if (helperInitialized) {
+		ADLX_RESULT res = ADLX_FAIL;
+
+		// destroy ADLX
+		res = helper.Terminate();
+		helperInitialized = false;
+		//std::cout << "Destroy ADLX result: " << res << std::endl;
+	}
+
+	if (preloadedDLL) {
+		adlx_free_library(preloadedDLL);
+		preloadedDLL = nullptr;
+	}
 }
 
 // function to init and setup adlx services for getting performance metrics
 void setupServices() {
+	TraceScope scope("setupServices");
 
 	// get performance monitoring services
-	ADLX_RESULT res = helper.GetSystemServices()->GetPerformanceMonitoringServices(&perfMonitoringService);
+	countADLXCall();
+	ADLX_RESULT res = timeDriverCall(performanceServicesCall, [&] { return helper.GetSystemServices()->GetPerformanceMonitoringServices(&perfMonitoringService); });
 	if (ADLX_SUCCEEDED(res))
 	{
 		adlx::IADLXGPUListPtr gpus;
 		// get GPU list
-		res = helper.GetSystemServices()->GetGPUs(&gpus);
+		countADLXCall();
+		res = timeDriverCall(gpusCall, [&] { return helper.GetSystemServices()->GetGPUs(&gpus); });
 		if (ADLX_SUCCEEDED(res))
 		{
 			// use the first GPU in the list
+			countADLXCall();
 			res = gpus->At(gpus->Begin(), &oneGPU);
 			if (ADLX_SUCCEEDED(res))
 			{
@@ -64,7 +168,8 @@ void setupServices() {
 		std::cout << "Get performance monitoring services failed." << std::endl;
 
 	// get system metrics support
-	res = perfMonitoringService->GetSupportedSystemMetrics(&systemMetricsSupport);
+	countADLXCall();
+	res = timeDriverCall(systemMetricsSupportCall, [&] { return perfMonitoringService->GetSupportedSystemMetrics(&systemMetricsSupport); });
 	if (ADLX_SUCCEEDED(res)) {
 		//std::cout << "CPU/System metrics supported." << std::endl;
 	}
@@ -73,7 +178,8 @@ void setupServices() {
 	}
 
 	// get GPU metrics support
-	res = perfMonitoringService->GetSupportedGPUMetrics(oneGPU, &gpuMetricsSupport);
+	countADLXCall();
+	res = timeDriverCall(gpuMetricsSupportCall, [&] { return perfMonitoringService->GetSupportedGPUMetrics(oneGPU, &gpuMetricsSupport); });
 	if (ADLX_SUCCEEDED(res)) {
 		//std::cout << "GPU metrics supported." << std::endl;
 	}
@@ -82,11 +188,13 @@ void setupServices() {
 	}
 
 	// get current all metrics
-	ADLX_RESULT res1 = perfMonitoringService->GetCurrentAllMetrics(&allMetrics);
+	countADLXCall();
+	ADLX_RESULT res1 = timeDriverCall(allMetricsCall, [&] { return perfMonitoringService->GetCurrentAllMetrics(&allMetrics); });
 	if (ADLX_SUCCEEDED(res1))
 	{
 		// get current GPU metrics
-		res1 = allMetrics->GetGPUMetrics(oneGPU, &gpuMetrics);
+		countADLXCall();
+		res1 = timeDriverCall(gpuMetricsCall, [&] { return allMetrics->GetGPUMetrics(oneGPU, &gpuMetrics); });
 		if (ADLX_SUCCEEDED(res) && ADLX_SUCCEEDED(res1))
 		{
 			//std::cout << "GPU metrics ready to be called." << std::endl;
@@ -96,7 +204,8 @@ void setupServices() {
 		}
 
 		// get current CPU/system metrics
-		ADLX_RESULT res1 = allMetrics->GetSystemMetrics(&systemMetrics);
+		countADLXCall();
+		ADLX_RESULT res1 = timeDriverCall(systemMetricsCall, [&] { return allMetrics->GetSystemMetrics(&systemMetrics); });
 		if (ADLX_SUCCEEDED(res1))
 		{
 			//std::cout << "CPU/System metrics ready to be called." << std::endl;
@@ -107,8 +216,20 @@ void setupServices() {
 	}
 }
 
+// function to stop the fps history tracking started by updateFPSHistory, adlx itself stays up
+void stopFPSTracking() {
+	if (fpsTracking && perfMonitoringService) {
+		perfMonitoringService->StopPerformanceMetricsTracking();
+	}
+	fpsTracking = false;
+	lastFPSTimestamp = 0;
+	frameStats.clear();
+}
+
 // function to release all pointers and terminate adlx helper object
 void releaseAndTerminate() {
+	stopFPSTracking();
+
 	// release pointers before terminating
 	perfMonitoringService = nullptr;
 	oneGPU = nullptr;
@@ -126,13 +247,15 @@ std::optional<adlx_double> getGPUUsage()
 {
 	adlx_bool supported = false;
 	// get GPU usage if supported
+	countADLXCall();
 	ADLX_RESULT res = gpuMetricsSupport->IsSupportedGPUUsage(&supported);
 	if (ADLX_SUCCEEDED(res))
 	{
 		if (supported)
 		{
 			adlx_double usage = 0;
-			res = gpuMetrics->GPUUsage(&usage);
+			countADLXCall();
+			res = timeDriverCall(gpuUsageCall, [&] { return gpuMetrics->GPUUsage(&usage); });
 			if (ADLX_SUCCEEDED(res)) {
 				//std::cout << "Success: fetched GPU usage." << std::endl;
 				return std::ceil(usage);
@@ -152,13 +275,15 @@ std::optional<adlx_double> getGPUTemperature()
 {
 	adlx_bool supported = false;
 	// get the GPU temperature if supported
+	countADLXCall();
 	ADLX_RESULT res = gpuMetricsSupport->IsSupportedGPUTemperature(&supported);
 	if (ADLX_SUCCEEDED(res))
 	{
 		if (supported)
 		{
 			adlx_double temperature = 0;
-			res = gpuMetrics->GPUTemperature(&temperature);
+			countADLXCall();
+			res = timeDriverCall(gpuTemperatureCall, [&] { return gpuMetrics->GPUTemperature(&temperature); });
 			if (ADLX_SUCCEEDED(res)) {
 				//std::cout << "Success: fetched GPU temperature." << temperature << std::endl;
 				return temperature;
@@ -178,13 +303,15 @@ std::optional<adlx_double> getGPUHotspotTemperature()
 {
 	adlx_bool supported = false;
 	// get the GPU hotspot temperature if supported
+	countADLXCall();
 	ADLX_RESULT res = gpuMetricsSupport->IsSupportedGPUHotspotTemperature(&supported);
 	if (ADLX_SUCCEEDED(res))
 	{
 		if (supported)
 		{
 			adlx_double hotspotTemperature = 0;
-			res = gpuMetrics->GPUHotspotTemperature(&hotspotTemperature);
+			countADLXCall();
+			res = timeDriverCall(gpuHotspotTemperatureCall, [&] { return gpuMetrics->GPUHotspotTemperature(&hotspotTemperature); });
 			if (ADLX_SUCCEEDED(res)) {
 				//std::cout << "Success: fetched GPU hotspot temperature." << std::endl;
 				return hotspotTemperature;
@@ -204,13 +331,15 @@ std::optional<adlx_double> getGPUPower()
 {
 	adlx_bool supported = false;
 	// get GPU power if supported
+	countADLXCall();
 	ADLX_RESULT res = gpuMetricsSupport->IsSupportedGPUPower(&supported);
 	if (ADLX_SUCCEEDED(res))
 	{
 		if (supported)
 		{
 			adlx_double power = 0;
-			res = gpuMetrics->GPUPower(&power);
+			countADLXCall();
+			res = timeDriverCall(gpuPowerCall, [&] { return gpuMetrics->GPUPower(&power); });
 			if (ADLX_SUCCEEDED(res)) {
 				//std::cout << "Success: fetched GPU power." << std::endl;
 				return power;
@@ -229,13 +358,15 @@ std::optional<adlx_double> getGPUPower()
 std::optional<adlx_double> getGPUVoltage() {
 	adlx_bool supported = false;
 	// get GPU voltage if supported
+	countADLXCall();
 	ADLX_RESULT res = gpuMetricsSupport->IsSupportedGPUVoltage(&supported);
 	if (ADLX_SUCCEEDED(res))
 	{
 		if (supported)
 		{
 			adlx_int voltage = 0;
-			res = gpuMetrics->GPUVoltage(&voltage);
+			countADLXCall();
+			res = timeDriverCall(gpuVoltageCall, [&] { return gpuMetrics->GPUVoltage(&voltage); });
 			if (ADLX_SUCCEEDED(res)) {
 				//std::cout << "Success: fetched GPU volage." << std::endl;
 				return static_cast<adlx_double>(voltage);
@@ -255,13 +386,15 @@ std::optional<adlx_double> getGPUClockSpeed()
 {
 	adlx_bool supported = false;
 	// display GPU clock speed if supported
+	countADLXCall();
 	ADLX_RESULT res = gpuMetricsSupport->IsSupportedGPUClockSpeed(&supported);
 	if (ADLX_SUCCEEDED(res))
 	{
 		if (supported)
 		{
 			adlx_int gpuClock = 0;
-			res = gpuMetrics->GPUClockSpeed(&gpuClock);
+			countADLXCall();
+			res = timeDriverCall(gpuClockSpeedCall, [&] { return gpuMetrics->GPUClockSpeed(&gpuClock); });
 			if (ADLX_SUCCEEDED(res)) {
 				return gpuClock;
 			}
@@ -280,13 +413,15 @@ std::optional<adlx_double> getGPUFanSpeed()
 {
 	adlx_bool supported = false;
 	// get the GPU fan speed if supported
+	countADLXCall();
 	ADLX_RESULT res = gpuMetricsSupport->IsSupportedGPUFanSpeed(&supported);
 	if (ADLX_SUCCEEDED(res))
 	{
 		if (supported)
 		{
 			adlx_int fanSpeed = 0;
-			res = gpuMetrics->GPUFanSpeed(&fanSpeed);
+			countADLXCall();
+			res = timeDriverCall(gpuFanSpeedCall, [&] { return gpuMetrics->GPUFanSpeed(&fanSpeed); });
 			if (ADLX_SUCCEEDED(res)) {
 				//std::cout << "Success: fetched GPU fan speed." << std::endl;
 				return fanSpeed;
@@ -306,13 +441,15 @@ std::optional<adlx_double> getGPUVRAM()
 {
 	adlx_bool supported = false;
 	// get the GPU VRAM if supported
+	countADLXCall();
 	ADLX_RESULT res = gpuMetricsSupport->IsSupportedGPUVRAM(&supported);
 	if (ADLX_SUCCEEDED(res))
 	{
 		if (supported)
 		{
 			adlx_int VRAM = 0;
-			res = gpuMetrics->GPUVRAM(&VRAM);
+			countADLXCall();
+			res = timeDriverCall(gpuVRAMCall, [&] { return gpuMetrics->GPUVRAM(&VRAM); });
 			if (ADLX_SUCCEEDED(res)) {
 				//std::cout << "Success: fetched GPU VRAM." << std::endl;
 				return VRAM;
@@ -332,13 +469,15 @@ std::optional<adlx_double> getGPUVRAMClockSpeed()
 {
 	adlx_bool supported = false;
 	// get the GPU VRAM clock speed if supported
+	countADLXCall();
 	ADLX_RESULT res = gpuMetricsSupport->IsSupportedGPUVRAMClockSpeed(&supported);
 	if (ADLX_SUCCEEDED(res))
 	{
 		if (supported)
 		{
 			adlx_int memoryClock = 0;
-			res = gpuMetrics->GPUVRAMClockSpeed(&memoryClock);
+			countADLXCall();
+			res = timeDriverCall(gpuVRAMClockSpeedCall, [&] { return gpuMetrics->GPUVRAMClockSpeed(&memoryClock); });
 			if (ADLX_SUCCEEDED(res)) {
 				//std::cout << "Success: fetched GPU VRAM clock speed." << std::endl;
 				return memoryClock;
@@ -358,13 +497,15 @@ std::optional<adlx_double> getCPUUsage()
 {
 	adlx_bool supported = false;
 	// get CPU usage if supported
+	countADLXCall();
 	ADLX_RESULT res = systemMetricsSupport->IsSupportedCPUUsage(&supported);
 	if (ADLX_SUCCEEDED(res))
 	{
 		if (supported)
 		{
 			adlx_double cpuUsage = 0;
-			res = systemMetrics->CPUUsage(&cpuUsage);
+			countADLXCall();
+			res = timeDriverCall(cpuUsageCall, [&] { return systemMetrics->CPUUsage(&cpuUsage); });
 			if (ADLX_SUCCEEDED(res)) {
 				//std::cout << "Success: fetched CPU usage." << std::endl;
 				return cpuUsage;
@@ -381,13 +522,15 @@ std::optional<adlx_double> getSystemRAM()
 {
 	adlx_bool supported = false;
 	// get system RAM if supported
+	countADLXCall();
 	ADLX_RESULT res = systemMetricsSupport->IsSupportedSystemRAM(&supported);
 	if (ADLX_SUCCEEDED(res))
 	{
 		if (supported)
 		{
 			adlx_int systemRAM = 0;
-			res = systemMetrics->SystemRAM(&systemRAM);
+			countADLXCall();
+			res = timeDriverCall(systemRAMCall, [&] { return systemMetrics->SystemRAM(&systemRAM); });
 			if (ADLX_SUCCEEDED(res)) {
 				//std::cout << "Success: fetched system RAM." << std::endl;
 				return systemRAM;
@@ -397,4 +540,150 @@ std::optional<adlx_double> getSystemRAM()
 		}
 	}
 	return std::nullopt;
-}
\ No newline at end of file
+}
+
+// function to pull new fps samples since the last update into the frame time stats
+void updateFPSHistory()
+{
+	if (!perfMonitoringService)
+		return;
+
+	// history is only recorded while tracking is running
+	if (!fpsTracking) {
+		countADLXCall();
+		ADLX_RESULT res = perfMonitoringService->StartPerformanceMetricsTracking();
+		if (ADLX_FAILED(res)) {
+			std::cout << "Failure: could not start FPS tracking." << std::endl;
+			return;
+		}
+		fpsTracking = true;
+	}
+
+	adlx::IADLXFPSListPtr fpsList;
+	countADLXCall();
+	ADLX_RESULT res = timeDriverCall(fpsHistoryCall, [&] { return perfMonitoringService->GetFPSHistory(fpsHistoryLookbackMs, 0, &fpsList); });
+	if (ADLX_FAILED(res) || !fpsList)
+		return;
+
+	// collect samples newer than the last one seen, the list order is not guaranteed
+	std::vector<std::pair<adlx_int64, adlx_int>> samples;
+	for (adlx_uint i = fpsList->Begin(); i != fpsList->End(); i++) {
+		adlx::IADLXFPSPtr fps;
+		adlx_int64 timestamp = 0;
+		adlx_int value = 0;
+		countADLXCall();
+		if (ADLX_SUCCEEDED(fpsList->At(i, &fps)) && ADLX_SUCCEEDED(fps->TimeStamp(&timestamp)) && ADLX_SUCCEEDED(fps->FPS(&value))) {
+			if (timestamp > lastFPSTimestamp && value > 0)
+				samples.emplace_back(timestamp, value);
+		}
+	}
+	std::sort(samples.begin(), samples.end());
+
+	adlx_int samplingIntervalMs = 1000;
+	countADLXCall();
+	perfMonitoringService->GetSamplingInterval(&samplingIntervalMs);
+
+	// each sample is the fps over one sampling interval, weight it by the frames it covers
+	for (const auto& [timestamp, value] : samples) {
+		double intervalMs = lastFPSTimestamp > 0 ? static_cast<double>(timestamp - lastFPSTimestamp) : samplingIntervalMs;
+		uint32_t frames = std::max<uint32_t>(1, static_cast<uint32_t>(std::lround(value * intervalMs / 1000.0)));
+		frameStats.addSample(timestamp, 1000.0 / value, frames);
+		lastFPSTimestamp = timestamp;
+	}
+}
+
+// function to read the current fps once per sample
+void updateCurrentFPS()
+{
+	currentFPS = std::nullopt;
+	if (!perfMonitoringService)
+		return;
+
+	adlx::IADLXFPSPtr fps;
+	countADLXCall();
+	ADLX_RESULT res = timeDriverCall(currentFPSCall, [&] { return perfMonitoringService->GetCurrentFPS(&fps); });
+	if (ADLX_SUCCEEDED(res))
+	{
+		adlx_int value = 0;
+		countADLXCall();
+		res = fps->FPS(&value);
+		// negative values mean no 3D application is running
+		if (ADLX_SUCCEEDED(res) && value >= 0) {
+			currentFPS = value;
+		}
+	}
+	else
+		std::cout << "Failure: could not fetch FPS." << std::endl;
+}
+
+// get current FPS
+std::optional<adlx_double> getFPS()
+{
+	return currentFPS;
+}
+
+// get rolling average FPS
+std::optional<adlx_double> getAverageFPS()
+{
+	if (frameStats.getFrameCount() == 0)
+		return std::nullopt;
+	return frameStats.getAverageFPS();
+}
+
+// get 1% low FPS
+std::optional<adlx_double> getOnePercentLowFPS()
+{
+	if (frameStats.getFrameCount() == 0)
+		return std::nullopt;
+	return frameStats.getOnePercentLowFPS();
+}
+
+// get 0.1% low FPS
+std::optional<adlx_double> getPointOnePercentLowFPS()
+{
+	if (frameStats.getFrameCount() == 0)
+		return std::nullopt;
+	return frameStats.getPointOnePercentLowFPS();
+}
+
+// get current frame time (ms), from the fps already read this sample
+std::optional<adlx_double> getFrameTime()
+{
+	if (currentFPS.has_value() && currentFPS.value() > 0)
+		return 1000.0 / currentFPS.value();
+	return std::nullopt;
+}
+
+// function to wrap the getters above as the sampler's metric source
+MetricSource adlxMetricSource()
+{
+	MetricSource source;
+	source.name = "adlx";
+	source.open = initializeHelper;
+	source.beginSample = [] {
+		// setup adlx services
+		setupServices();
+		updateFPSHistory();
+		updateCurrentFPS();
+	};
+	source.getters = {
+		getGPUUsage,
+		getGPUTemperature,
+		getGPUHotspotTemperature,
+		getGPUPower,
+		getGPUVoltage,
+		getGPUClockSpeed,
+		getGPUFanSpeed,
+		getGPUVRAM,
+		getGPUVRAMClockSpeed,
+		getCPUUsage,
+		getSystemRAM,
+		getFPS,
+		getAverageFPS,
+		getOnePercentLowFPS,
+		getPointOnePercentLowFPS,
+		getFrameTime
+	};
+	source.close = stopFPSTracking;
+	return source;
+}
@@ -0,0 +1,424 @@
+#include "../include/prometheusexporter.h"
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+typedef SOCKET SocketHandle;
+typedef WSAPOLLFD PollEntry;
+const SocketHandle invalidSocket = INVALID_SOCKET;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int SocketHandle;
+typedef pollfd PollEntry;
+const SocketHandle invalidSocket = -1;
+#endif
+
+// name and help text of each metric, indexed by metric id. gpu metrics carry the adapter index as a label
+struct PrometheusMetric {
+    const char* name;
+    const char* help;
+    bool perGPU;
+};
+
+static const std::vector<PrometheusMetric> prometheusMetrics = {
+    { "easymetrics_gpu_usage_percent", "GPU usage.", true },
+    { "easymetrics_gpu_temperature_celsius", "GPU temperature.", true },
+    { "easymetrics_gpu_hotspot_temperature_celsius", "GPU hotspot temperature.", true },
+    { "easymetrics_gpu_power_watts", "GPU board power.", true },
+    { "easymetrics_gpu_voltage_millivolts", "GPU voltage.", true },
+    { "easymetrics_gpu_clock_megahertz", "GPU clock speed.", true },
+    { "easymetrics_gpu_fan_speed_rpm", "GPU fan speed.", true },
+    { "easymetrics_gpu_vram_used_megabytes", "GPU memory in use.", true },
+    { "easymetrics_gpu_vram_clock_megahertz", "GPU memory clock speed.", true },
+    { "easymetrics_cpu_usage_percent", "CPU usage.", false },
+    { "easymetrics_system_ram_used_megabytes", "System memory in use.", false },
+    { "easymetrics_fps", "Frames per second of the foreground game.", false },
+    { "easymetrics_fps_average", "Average frames per second.", false },
+    { "easymetrics_fps_1_percent_low", "1% low frames per second.", false },
+    { "easymetrics_fps_0_1_percent_low", "0.1% low frames per second.", false },
+    { "easymetrics_frame_time_milliseconds", "Frame time.", false }
+};
+
+// the sampler only reads the first adapter
+static const char gpuLabel[] = "{gpu=\"0\"}";
+
+// limits for the poll loop
+const std::size_t maxConnections = 64;
+const std::size_t maxRequestBytes = 8192;
+const int pollTimeoutMs = 250; // how quickly stop() is noticed
+const int64_t idleTimeoutMs = 30000;
+
+static int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#pragma region Rendering
+
+std::string renderPrometheusBody(const std::vector<std::optional<double>>& values, uint64_t sampleCount) {
+    std::string out;
+    out.reserve(4096);
+    char number[32];
+
+    for (std::size_t i = 0; i < prometheusMetrics.size() && i < values.size(); i++) {
+        if (!values[i].has_value())
+            continue;
+
+        const PrometheusMetric& metric = prometheusMetrics[i];
+        out += "# HELP ";
+        out += metric.name;
+        out += ' ';
+        out += metric.help;
+        out += "\n# TYPE ";
+        out += metric.name;
+        out += " gauge\n";
+        out += metric.name;
+        if (metric.perGPU)
+            out += gpuLabel;
+        out += ' ';
+        out.append(number, std::to_chars(number, number + sizeof(number), values[i].value()).ptr);
+        out += '\n';
+    }
+
+    out += "# HELP easymetrics_samples_total Samples taken since the app started.\n# TYPE easymetrics_samples_total counter\neasymetrics_samples_total ";
+    out.append(number, std::to_chars(number, number + sizeof(number), sampleCount).ptr);
+    out += '\n';
+    return out;
+}
+
+#pragma endregion
+
+#pragma region Sockets
+
+static void closeSocket(SocketHandle socket) {
+#if defined(_WIN32)
+    closesocket(socket);
+#else
+    ::close(socket);
+#endif
+}
+
+static bool setNonBlocking(SocketHandle socket) {
+#if defined(_WIN32)
+    u_long enabled = 1;
+    return ioctlsocket(socket, FIONBIO, &enabled) == 0;
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+    return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+static int pollSockets(PollEntry* entries, std::size_t count, int timeoutMs) {
+#if defined(_WIN32)
+    return WSAPoll(entries, static_cast<ULONG>(count), timeoutMs);
+#else
+    return poll(entries, static_cast<nfds_t>(count), timeoutMs);
+#endif
+}
+
+// send the rest of the headers and the body in one call, straight from the shared body.
+// bytes sent, 0 if the socket would block, -1 on error
+static long long sendSome(SocketHandle socket, const char* header, std::size_t headerBytes, const char* body, std::size_t bodyBytes) {
+#if defined(_WIN32)
+    WSABUF buffers[2] = { { static_cast<ULONG>(headerBytes), const_cast<char*>(header) }, { static_cast<ULONG>(bodyBytes), const_cast<char*>(body) } };
+    DWORD sent = 0;
+    if (WSASend(socket, headerBytes ? buffers : buffers + 1, headerBytes ? 2 : 1, &sent, 0, nullptr, nullptr) != 0)
+        return WSAGetLastError() == WSAEWOULDBLOCK ? 0 : -1;
+#else
+    iovec buffers[2] = { { const_cast<char*>(header), headerBytes }, { const_cast<char*>(body), bodyBytes } };
+    msghdr message = {};
+    message.msg_iov = headerBytes ? buffers : buffers + 1;
+    message.msg_iovlen = headerBytes ? 2 : 1;
+    ssize_t sent = sendmsg(socket, &message, MSG_NOSIGNAL);
+    if (sent < 0)
+        return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+#endif
+    return static_cast<long long>(sent);
+}
+
+#pragma endregion
+
+#pragma region Server
+
+// one client connection, reading a request or sending a response
+struct Connection {
+    SocketHandle socket;
+    std::string request;
+    std::string header; // response status line and headers
+    std::shared_ptr<const std::string> body; // the snapshot being sent, kept alive until it is out
+    std::size_t sent = 0; // of header then body
+    bool sendBody = false;
+    bool closeAfter = false;
+    int64_t lastActiveMs = 0;
+
+    bool sending() const { return !header.empty(); }
+};
+
+// case insensitive check that a header line (given with its leading \r\n) contains a value
+static bool hasHeaderValue(const std::string& request, const char* header, const char* value) {
+    std::string lower = request;
+    for (char& c : lower)
+        c = static_cast<char>(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+    std::size_t at = lower.find(header);
+    return at != std::string::npos && lower.find(value, at) < lower.find("\r\n", at + 2);
+}
+
+// turn one complete request (up to the blank line) into a response
+static void respond(Connection& connection, const std::string& request, const std::shared_ptr<const std::string>& body, std::atomic<uint64_t>& scrapes) {
+    std::size_t methodEnd = request.find(' ');
+    std::size_t pathEnd = methodEnd == std::string::npos ? std::string::npos : request.find(' ', methodEnd + 1);
+    std::string method = request.substr(0, methodEnd);
+    std::string path = pathEnd == std::string::npos ? "" : request.substr(methodEnd + 1, pathEnd - methodEnd - 1);
+    bool http10 = request.compare(pathEnd + 1, 8, "HTTP/1.0") == 0;
+
+    connection.closeAfter = http10 ? !hasHeaderValue(request, "\r\nconnection:", "keep-alive") : hasHeaderValue(request, "\r\nconnection:", "close");
+    connection.sendBody = false;
+    connection.body.reset();
+
+    const char* status = "200 OK";
+    std::string contentType = "text/plain; version=0.0.4; charset=utf-8";
+    std::size_t length = 0;
+    if (method != "GET" && method != "HEAD")
+        status = "405 Method Not Allowed";
+    else if (path != "/metrics" && path.compare(0, 9, "/metrics?") != 0)
+        status = "404 Not Found";
+    else {
+        connection.body = body;
+        connection.sendBody = method == "GET";
+        length = body ? body->size() : 0;
+        scrapes.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (std::strcmp(status, "200 OK") != 0) {
+        contentType = "text/plain";
+        connection.closeAfter = true;
+    }
+
+    connection.header = std::string("HTTP/1.1 ") + status + "\r\nContent-Type: " + contentType + "\r\nContent-Length: " +
+        std::to_string(length) + (connection.closeAfter ? "\r\nConnection: close\r\n\r\n" : "\r\n\r\n");
+    connection.sent = 0;
+}
+
+// send as much of the response as the socket takes, false if the connection should be closed
+static bool continueSending(Connection& connection) {
+    std::size_t bodyBytes = connection.sendBody && connection.body ? connection.body->size() : 0;
+    std::size_t total = connection.header.size() + bodyBytes;
+    while (connection.sent < total) {
+        std::size_t headerSent = connection.sent < connection.header.size() ? connection.sent : connection.header.size();
+        std::size_t bodySent = connection.sent - headerSent;
+        long long sent = sendSome(connection.socket, connection.header.data() + headerSent, connection.header.size() - headerSent,
+            bodyBytes ? connection.body->data() + bodySent : nullptr, bodyBytes - bodySent);
+        if (sent < 0)
+            return false;
+        if (sent == 0)
+            return true; // wait for the socket to drain
+        connection.sent += static_cast<std::size_t>(sent);
+    }
+
+    // done, ready for the next request on a kept alive connection
+    connection.header.clear();
+    connection.body.reset();
+    connection.sent = 0;
+    return !connection.closeAfter;
+}
+
+// send the current response and answer queued requests one at a time until the socket is full or none are left,
+// false if the connection should be closed
+static bool serviceRequests(Connection& connection, const std::shared_ptr<const std::string>& body, std::atomic<uint64_t>& scrapes) {
+    while (true) {
+        if (connection.sending()) {
+            if (!continueSending(connection))
+                return false;
+            if (connection.sending())
+                return true;
+        }
+
+        std::size_t end = connection.request.find("\r\n\r\n");
+        if (end == std::string::npos)
+            return true;
+        respond(connection, connection.request.substr(0, end + 2), body, scrapes);
+        connection.request.erase(0, end + 4);
+    }
+}
+
+// read what the client sent and answer any complete request, false if the connection should be closed
+static bool receive(Connection& connection, const std::shared_ptr<const std::string>& body, std::atomic<uint64_t>& scrapes) {
+    char buffer[4096];
+    while (true) {
+        int received = static_cast<int>(recv(connection.socket, buffer, sizeof(buffer), 0));
+        if (received == 0)
+            return false;
+        if (received < 0) {
+#if defined(_WIN32)
+            if (WSAGetLastError() == WSAEWOULDBLOCK)
+                break;
+#else
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+#endif
+            return false;
+        }
+        connection.request.append(buffer, received);
+        if (connection.request.size() > maxRequestBytes)
+            return false;
+    }
+
+    return serviceRequests(connection, body, scrapes);
+}
+
+PrometheusExporter::~PrometheusExporter() {
+    stop();
+}
+
+bool PrometheusExporter::start(uint16_t port) {
+    stop();
+
+#if defined(_WIN32)
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+        return false;
+#endif
+
+    SocketHandle listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener == invalidSocket) {
+        std::cout << "Failure: could not create the metrics socket" << std::endl;
+#if defined(_WIN32)
+        WSACleanup();
+#endif
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+    // loopback only, the endpoint is not meant to be reachable from other machines
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 16) != 0 || !setNonBlocking(listener)) {
+        std::cout << "Failure: could not listen on 127.0.0.1:" << port << std::endl;
+        closeSocket(listener);
+#if defined(_WIN32)
+        WSACleanup();
+#endif
+        return false;
+    }
+
+    listenSocket = static_cast<intptr_t>(listener);
+    if (!std::atomic_load(&body))
+        std::atomic_store(&body, std::make_shared<const std::string>(renderPrometheusBody({}, 0)));
+    stopping.store(false, std::memory_order_release);
+    running.store(true, std::memory_order_release);
+    server = std::thread(&PrometheusExporter::serverLoop, this);
+    return true;
+}
+
+void PrometheusExporter::stop() {
+    if (!server.joinable())
+        return;
+
+    stopping.store(true, std::memory_order_release);
+    server.join();
+    closeSocket(static_cast<SocketHandle>(listenSocket));
+    listenSocket = -1;
+    running.store(false, std::memory_order_release);
+
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+}
+
+void PrometheusExporter::publish(const std::vector<std::optional<double>>& values, uint64_t sampleCount) {
+    if (!isRunning())
+        return;
+    std::atomic_store(&body, std::make_shared<const std::string>(renderPrometheusBody(values, sampleCount)));
+}
+
+void PrometheusExporter::serverLoop() {
+    SocketHandle listener = static_cast<SocketHandle>(listenSocket);
+    std::vector<Connection> connections;
+    std::vector<PollEntry> entries;
+
+    while (!stopping.load(std::memory_order_acquire)) {
+        // the listener first, then every connection waiting to read or to send
+        entries.clear();
+        PollEntry listenEntry = {};
+        listenEntry.fd = listener;
+        listenEntry.events = connections.size() < maxConnections ? POLLIN : 0;
+        entries.push_back(listenEntry);
+        for (const Connection& connection : connections) {
+            PollEntry entry = {};
+            entry.fd = connection.socket;
+            entry.events = connection.sending() ? POLLOUT : POLLIN;
+            entries.push_back(entry);
+        }
+
+        if (pollSockets(entries.data(), entries.size(), pollTimeoutMs) < 0)
+            continue;
+
+        std::shared_ptr<const std::string> snapshot = std::atomic_load(&body);
+        int64_t now = nowMs();
+
+        // handle existing connections, closing the ones that are done, broken or idle
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < connections.size(); i++) {
+            Connection& connection = connections[i];
+            short events = entries[i + 1].revents;
+            bool open = true;
+            if (events & (POLLERR | POLLNVAL))
+                open = false;
+            else if (events & (POLLIN | POLLHUP)) {
+                open = receive(connection, snapshot, scrapeCount);
+                connection.lastActiveMs = now;
+            }
+            else if (events & POLLOUT) {
+                open = serviceRequests(connection, snapshot, scrapeCount);
+                connection.lastActiveMs = now;
+            }
+            else if (now - connection.lastActiveMs > idleTimeoutMs)
+                open = false;
+
+            if (open)
+                connections[kept++] = std::move(connection);
+            else
+                closeSocket(connection.socket);
+        }
+        connections.resize(kept);
+
+        // accept everything that is waiting
+        if (entries[0].revents & POLLIN) {
+            while (connections.size() < maxConnections) {
+                SocketHandle client = accept(listener, nullptr, nullptr);
+                if (client == invalidSocket)
+                    break;
+                if (!setNonBlocking(client)) {
+                    closeSocket(client);
+                    continue;
+                }
+                // responses go out in one send, no reason to hold back a partial one
+                int noDelay = 1;
+                setsockopt(client, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+                Connection connection;
+                connection.socket = client;
+                connection.lastActiveMs = now;
+                connections.push_back(std::move(connection));
+            }
+        }
+    }
+
+    for (const Connection& connection : connections)
+        closeSocket(connection.socket);
+}
+
+#pragma endregion
@@ -0,0 +1,342 @@
+#include "../include/pushexporter.h"
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+typedef SOCKET SocketHandle;
+const SocketHandle invalidSocket = INVALID_SOCKET;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int SocketHandle;
+const SocketHandle invalidSocket = -1;
+#endif
+
+// key of each metric, indexed by metric id. gpu metrics lose their gpu_ prefix as influx fields
+struct PushMetric {
+    const char* key;
+    bool perGPU;
+};
+
+static const std::vector<PushMetric> pushMetrics = {
+    { "gpu_usage_percent", true },
+    { "gpu_temperature_celsius", true },
+    { "gpu_hotspot_temperature_celsius", true },
+    { "gpu_power_watts", true },
+    { "gpu_voltage_millivolts", true },
+    { "gpu_clock_megahertz", true },
+    { "gpu_fan_speed_rpm", true },
+    { "gpu_vram_used_megabytes", true },
+    { "gpu_vram_clock_megahertz", true },
+    { "cpu_usage_percent", false },
+    { "system_ram_used_megabytes", false },
+    { "fps", false },
+    { "fps_average", false },
+    { "fps_1_percent_low", false },
+    { "fps_0_1_percent_low", false },
+    { "frame_time_milliseconds", false }
+};
+
+// drained samples kept for reuse, enough for a full queue at 10 hz without growing
+const std::size_t maxSpareSamples = 64;
+
+#pragma region Rendering
+
+static void appendNumber(std::string& out, double value) {
+    char number[32];
+    out.append(number, std::to_chars(number, number + sizeof(number), value).ptr);
+}
+
+static void renderStatsD(const std::vector<std::optional<double>>& values, std::string& out) {
+    for (std::size_t i = 0; i < pushMetrics.size() && i < values.size(); i++) {
+        if (!values[i].has_value() || !std::isfinite(values[i].value()))
+            continue;
+
+        // a signed gauge is a change to the last value, so a negative one is set from zero
+        if (values[i].value() < 0.0) {
+            out += "easymetrics.";
+            out += pushMetrics[i].key;
+            out += ":0|g\n";
+        }
+        out += "easymetrics.";
+        out += pushMetrics[i].key;
+        out += ':';
+        appendNumber(out, values[i].value());
+        out += "|g\n";
+    }
+}
+
+// one line with every present metric of one kind as fields, nothing if none are present
+static void renderInfluxLine(const char* measurement, bool gpu, int64_t unixNs, const std::vector<std::optional<double>>& values, std::string& out) {
+    std::size_t start = out.size();
+    out += measurement;
+    out += gpu ? ",gpu=0 " : " ";
+    std::size_t fields = out.size();
+
+    for (std::size_t i = 0; i < pushMetrics.size() && i < values.size(); i++) {
+        if (pushMetrics[i].perGPU != gpu || !values[i].has_value() || !std::isfinite(values[i].value()))
+            continue;
+
+        if (out.size() != fields)
+            out += ',';
+        out += pushMetrics[i].key + (gpu ? 4 : 0);
+        out += '=';
+        appendNumber(out, values[i].value());
+    }
+
+    if (out.size() == fields) {
+        out.resize(start);
+        return;
+    }
+    out += ' ';
+    char number[24];
+    out.append(number, std::to_chars(number, number + sizeof(number), unixNs).ptr);
+    out += '\n';
+}
+
+void renderPushLines(PushFormat format, int64_t unixNs, const std::vector<std::optional<double>>& values, std::string& out) {
+    if (format == PushFormat::StatsD) {
+        renderStatsD(values, out);
+        return;
+    }
+
+    // the sampler only reads the first adapter
+    renderInfluxLine("easymetrics_gpu", true, unixNs, values, out);
+    renderInfluxLine("easymetrics_system", false, unixNs, values, out);
+}
+
+#pragma endregion
+
+#pragma region PushExporter
+
+static void closeSocket(SocketHandle socket) {
+#if defined(_WIN32)
+    closesocket(socket);
+#else
+    ::close(socket);
+#endif
+}
+
+// connected udp socket, non-blocking so a full send buffer loses a datagram instead of waiting
+static SocketHandle openSocket(const std::string& host, uint16_t port) {
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+        std::cout << "Failure: collector address " << host << " is not an ipv4 address" << std::endl;
+        return invalidSocket;
+    }
+
+    SocketHandle handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (handle == invalidSocket)
+        return invalidSocket;
+
+#if defined(_WIN32)
+    u_long enabled = 1;
+    bool nonBlocking = ioctlsocket(handle, FIONBIO, &enabled) == 0;
+#else
+    int flags = fcntl(handle, F_GETFL, 0);
+    bool nonBlocking = flags >= 0 && fcntl(handle, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+    if (!nonBlocking || connect(handle, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        closeSocket(handle);
+        return invalidSocket;
+    }
+    return handle;
+}
+
+PushExporter::~PushExporter() {
+    stop();
+}
+
+bool PushExporter::start(const PushOptions& pushOptions) {
+    stop();
+    options = pushOptions;
+    if (options.flushIntervalMs < 1)
+        options.flushIntervalMs = 1;
+    if (options.queueSamples < 1)
+        options.queueSamples = 1;
+
+    if (!options.path.empty()) {
+#if defined(_WIN32)
+        if (fopen_s(&file, options.path.c_str(), "ab") != 0)
+            file = nullptr;
+#else
+        file = std::fopen(options.path.c_str(), "ab");
+#endif
+        if (!file) {
+            std::cout << "Failure: could not open " << options.path << std::endl;
+            return false;
+        }
+    }
+    else {
+#if defined(_WIN32)
+        WSADATA data;
+        if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+            return false;
+#endif
+        SocketHandle handle = openSocket(options.host, options.port);
+        if (handle == invalidSocket) {
+#if defined(_WIN32)
+            WSACleanup();
+#endif
+            return false;
+        }
+        socketHandle = static_cast<intptr_t>(handle);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = false;
+        queue.clear();
+        stats = Stats();
+    }
+    running.store(true, std::memory_order_release);
+    flusher = std::thread(&PushExporter::flushLoop, this);
+    return true;
+}
+
+void PushExporter::stop() {
+    if (!flusher.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    flusher.join();
+    running.store(false, std::memory_order_release);
+
+    if (file) {
+        std::fclose(file);
+        file = nullptr;
+    }
+    if (socketHandle != -1) {
+        closeSocket(static_cast<SocketHandle>(socketHandle));
+        socketHandle = -1;
+#if defined(_WIN32)
+        WSACleanup();
+#endif
+    }
+}
+
+void PushExporter::push(int64_t unixNs, const std::vector<std::optional<double>>& values) {
+    if (!running.load(std::memory_order_acquire))
+        return;
+
+    std::lock_guard<std::mutex> lock(queueMutex);
+    if (stopping)
+        return;
+
+    // a full queue means the flusher is stuck, keep the newest samples
+    if (queue.size() >= options.queueSamples) {
+        if (spare.size() < maxSpareSamples)
+            spare.push_back(std::move(queue.front()));
+        queue.pop_front();
+        stats.samplesDropped++;
+    }
+
+    QueuedSample sample;
+    if (!spare.empty()) {
+        sample = std::move(spare.back());
+        spare.pop_back();
+    }
+    sample.unixNs = unixNs;
+    sample.values.assign(values.begin(), values.end());
+    queue.push_back(std::move(sample));
+    stats.samplesQueued++;
+}
+
+PushExporter::Stats PushExporter::getStats() const {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return stats;
+}
+
+// the flusher thread, drains the queue every flush interval and once more when stopped
+void PushExporter::flushLoop() {
+    std::vector<QueuedSample> batch;
+    std::unique_lock<std::mutex> lock(queueMutex);
+    while (true) {
+        wake.wait_for(lock, std::chrono::milliseconds(options.flushIntervalMs), [this] { return stopping; });
+        bool last = stopping;
+
+        while (!queue.empty()) {
+            batch.push_back(std::move(queue.front()));
+            queue.pop_front();
+        }
+
+        if (!batch.empty()) {
+            lock.unlock();
+            flush(batch);
+            lock.lock();
+
+            stats.samplesSent += batch.size();
+            for (QueuedSample& sample : batch) {
+                if (spare.size() >= maxSpareSamples)
+                    break;
+                spare.push_back(std::move(sample));
+            }
+            batch.clear();
+        }
+
+        if (last)
+            break;
+    }
+}
+
+// render a batch and write it, packing whole lines into as few datagrams as fit
+void PushExporter::flush(std::vector<QueuedSample>& batch) {
+    payload.clear();
+    for (const QueuedSample& sample : batch) {
+        lines.clear();
+        renderPushLines(options.format, sample.unixNs, sample.values, lines);
+        if (file) {
+            payload += lines;
+            continue;
+        }
+
+        std::size_t begin = 0;
+        while (begin < lines.size()) {
+            std::size_t end = lines.find('\n', begin) + 1;
+            if (!payload.empty() && payload.size() + (end - begin) > options.maxDatagramBytes) {
+                write(payload);
+                payload.clear();
+            }
+            payload.append(lines, begin, end - begin);
+            begin = end;
+        }
+    }
+
+    if (!payload.empty())
+        write(payload);
+    if (file)
+        std::fflush(file);
+}
+
+// one datagram or file write, counted in the stats
+void PushExporter::write(const std::string& data) {
+    bool written;
+    if (file)
+        written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    else
+        written = send(static_cast<SocketHandle>(socketHandle), data.data(), static_cast<int>(data.size()), 0) == static_cast<int>(data.size());
+
+    std::lock_guard<std::mutex> lock(queueMutex);
+    if (written) {
+        stats.writes++;
+        stats.bytes += data.size();
+    }
+    else
+        stats.sendErrors++;
+}
+
+#pragma endregion
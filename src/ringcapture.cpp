@@ -0,0 +1,277 @@
+#include "../include/ringcapture.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// file layout, all little endian:
+//   header at 0, column names (u16 length + bytes each) from 64, slots from dataOffset (page aligned)
+//   slot: u64 sequence (0 while being written), f64 time, u64 presence mask, f32 per column
+struct RingHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t columnCount;
+    uint32_t slotBytes;
+    uint32_t slotCount;
+    uint32_t dataOffset;
+    uint32_t reserved;
+    int64_t startUnixMs;
+    uint64_t commitCount; // number of slots ever committed, only accessed atomically
+};
+
+static const char ringMagic[8] = { 'E', 'M', 'R', 'I', 'N', 'G', 0, 0 };
+static const uint32_t ringVersion = 1;
+const std::size_t namesOffset = 64;
+const std::size_t pageBytes = 4096;
+const std::size_t slotHeaderBytes = 3 * sizeof(uint64_t);
+
+// ask the os to start writing dirty pages out this often, so an os hang loses less than a process crash would
+const uint64_t flushEverySamples = 10;
+
+static_assert(sizeof(RingHeader) <= namesOffset, "ring header overlaps the column names");
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t) && alignof(std::atomic<uint64_t>) <= alignof(uint64_t),
+    "sequence numbers are accessed in place as atomics");
+
+// the header's commit count and each slot's sequence live in shared memory and are published with release stores
+static std::atomic<uint64_t>* atomicAt(void* address) {
+    return reinterpret_cast<std::atomic<uint64_t>*>(address);
+}
+
+RingCapture::~RingCapture() {
+    close();
+}
+
+#pragma region Writer
+
+bool RingCapture::create(const std::string& path, const std::vector<std::string>& columns, std::size_t slots) {
+    close();
+    if (columns.size() > 64 || slots == 0)
+        return false;
+
+    columnCount = columns.size();
+    slotCount = slots;
+    slotBytes = (slotHeaderBytes + sizeof(float) * columnCount + 7) & ~std::size_t(7);
+
+    std::size_t namesBytes = 0;
+    for (const std::string& column : columns)
+        namesBytes += sizeof(uint16_t) + column.size();
+    dataOffset = (namesOffset + namesBytes + pageBytes - 1) / pageBytes * pageBytes;
+    mappedBytes = dataOffset + slotBytes * slotCount;
+
+#if defined(_WIN32)
+    // shared for reading so the recovery tool can look at a running capture
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cout << "Failure: could not create " << path << std::endl;
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, static_cast<DWORD>(static_cast<uint64_t>(mappedBytes) >> 32), static_cast<DWORD>(mappedBytes), nullptr);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, mappedBytes) : nullptr;
+    if (!view) {
+        std::cout << "Failure: could not map " << path << std::endl;
+        if (mapping)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+#else
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cout << "Failure: could not create " << path << std::endl;
+        return false;
+    }
+    void* view = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(mappedBytes)) == 0)
+        view = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) {
+        std::cout << "Failure: could not map " << path << std::endl;
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+#endif
+    base = static_cast<unsigned char*>(view);
+
+    // names first, then the header, the commit count starts at zero so readers see an empty ring until the first write
+    unsigned char* p = base + namesOffset;
+    for (const std::string& column : columns) {
+        uint16_t length = static_cast<uint16_t>(column.size());
+        std::memcpy(p, &length, sizeof(length));
+        std::memcpy(p + sizeof(length), column.data(), length);
+        p += sizeof(length) + length;
+    }
+
+    RingHeader header = {};
+    std::memcpy(header.magic, ringMagic, sizeof(ringMagic));
+    header.version = ringVersion;
+    header.columnCount = static_cast<uint32_t>(columnCount);
+    header.slotBytes = static_cast<uint32_t>(slotBytes);
+    header.slotCount = static_cast<uint32_t>(slotCount);
+    header.dataOffset = static_cast<uint32_t>(dataOffset);
+    header.startUnixMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    std::memcpy(base, &header, sizeof(header));
+
+    committed = 0;
+    return true;
+}
+
+void RingCapture::close() {
+    if (!base)
+        return;
+
+#if defined(_WIN32)
+    FlushViewOfFile(base, mappedBytes);
+    UnmapViewOfFile(base);
+    CloseHandle(static_cast<HANDLE>(mappingHandle));
+    CloseHandle(static_cast<HANDLE>(fileHandle));
+    mappingHandle = fileHandle = nullptr;
+#else
+    msync(base, mappedBytes, MS_SYNC);
+    munmap(base, mappedBytes);
+    ::close(fd);
+    fd = -1;
+#endif
+    base = nullptr;
+}
+
+unsigned char* RingCapture::slotAt(uint64_t sequence) const {
+    return base + dataOffset + ((sequence - 1) % slotCount) * slotBytes;
+}
+
+void RingCapture::write(double timeSeconds, const std::vector<std::optional<double>>& values) {
+    if (!base)
+        return;
+
+    uint64_t sequence = committed + 1;
+    unsigned char* slot = slotAt(sequence);
+
+    // invalidate the slot (the oldest one) before touching its data, a crash from here on leaves it skipped
+    atomicAt(slot)->store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint64_t mask = 0;
+    float* columns = reinterpret_cast<float*>(slot + slotHeaderBytes);
+    for (std::size_t i = 0; i < columnCount; i++) {
+        bool present = i < values.size() && values[i].has_value();
+        if (present)
+            mask |= uint64_t(1) << i;
+        columns[i] = present ? static_cast<float>(values[i].value()) : 0.f;
+    }
+    std::memcpy(slot + sizeof(uint64_t), &timeSeconds, sizeof(timeSeconds));
+    std::memcpy(slot + 2 * sizeof(uint64_t), &mask, sizeof(mask));
+
+    // stamp the slot, then publish it
+    atomicAt(slot)->store(sequence, std::memory_order_release);
+    atomicAt(base + offsetof(RingHeader, commitCount))->store(sequence, std::memory_order_release);
+    committed = sequence;
+
+    if (committed % flushEverySamples == 0) {
+#if defined(_WIN32)
+        FlushViewOfFile(base, mappedBytes);
+#else
+        msync(base, mappedBytes, MS_ASYNC);
+#endif
+    }
+}
+
+#pragma endregion
+
+#pragma region Recovery
+
+bool readRingFile(const std::string& path, RingContents& contents) {
+    contents = RingContents();
+
+    std::FILE* file = nullptr;
+#if defined(_WIN32)
+    if (fopen_s(&file, path.c_str(), "rb") != 0)
+        file = nullptr;
+#else
+    file = std::fopen(path.c_str(), "rb");
+#endif
+    if (!file) {
+        std::cout << "Failure: could not open " << path << std::endl;
+        return false;
+    }
+
+    std::vector<unsigned char> data;
+    unsigned char buffer[65536];
+    std::size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+        data.insert(data.end(), buffer, buffer + read);
+    std::fclose(file);
+
+    RingHeader header = {};
+    if (data.size() >= namesOffset)
+        std::memcpy(&header, data.data(), sizeof(header));
+    if (data.size() < namesOffset || std::memcmp(header.magic, ringMagic, sizeof(ringMagic)) != 0 || header.version != ringVersion) {
+        std::cout << "Failure: " << path << " is not a ring capture" << std::endl;
+        return false;
+    }
+    // every field used to index the slots comes from disk, a ring of no slots or one reaching past the end
+    // of the file is rejected here rather than divided by or read beyond below
+    if (header.columnCount > 64 || header.slotCount == 0 || header.dataOffset < namesOffset
+        || header.slotBytes < slotHeaderBytes + sizeof(float) * header.columnCount
+        || static_cast<uint64_t>(header.dataOffset) + static_cast<uint64_t>(header.slotBytes) * header.slotCount > data.size()) {
+        std::cout << "Failure: " << path << " is truncated or damaged" << std::endl;
+        return false;
+    }
+
+    // column names
+    std::size_t p = namesOffset;
+    for (uint32_t i = 0; i < header.columnCount; i++) {
+        uint16_t length = 0;
+        if (p + sizeof(length) > header.dataOffset)
+            return false;
+        std::memcpy(&length, data.data() + p, sizeof(length));
+        p += sizeof(length);
+        if (p + length > header.dataOffset)
+            return false;
+        contents.columns.emplace_back(reinterpret_cast<const char*>(data.data() + p), length);
+        p += length;
+    }
+    contents.startUnixMs = header.startUnixMs;
+
+    // the committed slots still in the ring, oldest first
+    uint64_t commit = header.commitCount;
+    uint64_t first = commit > header.slotCount ? commit - header.slotCount + 1 : 1;
+    for (uint64_t sequence = first; sequence <= commit; sequence++) {
+        const unsigned char* slot = data.data() + header.dataOffset + ((sequence - 1) % header.slotCount) * header.slotBytes;
+
+        uint64_t stamped = 0;
+        std::memcpy(&stamped, slot, sizeof(stamped));
+        if (stamped != sequence) {
+            contents.skippedSlots++;
+            continue;
+        }
+
+        RingRecord record;
+        record.sequence = sequence;
+        uint64_t mask = 0;
+        std::memcpy(&record.time, slot + sizeof(uint64_t), sizeof(record.time));
+        std::memcpy(&mask, slot + 2 * sizeof(uint64_t), sizeof(mask));
+        record.values.resize(header.columnCount);
+        for (uint32_t i = 0; i < header.columnCount; i++) {
+            if (mask & (uint64_t(1) << i)) {
+                float value;
+                std::memcpy(&value, slot + slotHeaderBytes + i * sizeof(float), sizeof(value));
+                record.values[i] = value;
+            }
+        }
+        contents.records.push_back(std::move(record));
+    }
+    return true;
+}
+
+#pragma endregion
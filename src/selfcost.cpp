@@ -0,0 +1,215 @@
+#include "../include/selfcost.h"
+#include "../include/latencyhistogram.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+// tick percentiles are over the last tickWindow ticks rather than the report period, which at 1 Hz holds one tick.
+// the sampler thread writes the ring, the report copies it into a histogram
+const uint64_t tickWindow = 60;
+static std::array<std::atomic<int64_t>, tickWindow> recentTicksUs = {};
+static std::atomic<uint64_t> ticksRecorded = 0;
+static LatencyHistogram tickHistogram;
+
+static std::atomic<uint64_t> tickCount = 0;
+static std::atomic<uint64_t> adlxCallCount = 0;
+static std::atomic<uint64_t> frameCount = 0;
+static std::atomic<uint64_t> frameTimeUs = 0;
+static std::atomic<uint64_t> mainWindowFrameCount = 0;
+static std::atomic<uint64_t> mainWindowFrameTimeUs = 0;
+static std::atomic<int64_t> overlayOpenUs = 0;
+static std::array<std::atomic<int64_t>, 4> adlxStartupUs = {}; // dll load, init, gpu enumeration, first sample
+
+// allocations are batched per thread and folded into the global count every allocationBatch
+const uint32_t allocationBatch = 64;
+static std::atomic<uint64_t> allocationCount = 0;
+static std::atomic<uint64_t> freeCount = 0;
+static thread_local uint32_t pendingAllocations = 0;
+static thread_local uint32_t pendingFrees = 0;
+
+// state of the previous report
+static uint64_t lastAllocationCount = 0;
+static std::chrono::steady_clock::time_point lastReportTime = std::chrono::steady_clock::now();
+
+#pragma region Allocation counting
+
+void* operator new(std::size_t size) {
+    if (++pendingAllocations == allocationBatch) {
+        allocationCount.fetch_add(allocationBatch, std::memory_order_relaxed);
+        pendingAllocations = 0;
+    }
+
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+static void countFree(void* ptr) {
+    if (ptr && ++pendingFrees == allocationBatch) {
+        freeCount.fetch_add(allocationBatch, std::memory_order_relaxed);
+        pendingFrees = 0;
+    }
+}
+
+void operator delete(void* ptr) noexcept {
+    countFree(ptr);
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    countFree(ptr);
+    std::free(ptr);
+}
+
+#pragma endregion
+
+#pragma region Recording
+
+void recordSamplingTick(int64_t durationUs) {
+    uint64_t tick = ticksRecorded.load(std::memory_order_relaxed);
+    recentTicksUs[tick % tickWindow].store(durationUs > 0 ? durationUs : 0, std::memory_order_relaxed);
+    ticksRecorded.store(tick + 1, std::memory_order_release);
+    tickCount.fetch_add(1, std::memory_order_relaxed);
+    adlxCallCount.fetch_add(adlxCallsThisTick, std::memory_order_relaxed);
+    adlxCallsThisTick = 0;
+}
+
+void recordRenderFrame(int64_t durationUs) {
+    frameCount.fetch_add(1, std::memory_order_relaxed);
+    frameTimeUs.fetch_add(static_cast<uint64_t>(durationUs > 0 ? durationUs : 0), std::memory_order_relaxed);
+}
+
+void recordMainWindowFrame(int64_t durationUs) {
+    mainWindowFrameCount.fetch_add(1, std::memory_order_relaxed);
+    mainWindowFrameTimeUs.fetch_add(static_cast<uint64_t>(durationUs > 0 ? durationUs : 0), std::memory_order_relaxed);
+}
+
+void recordOverlayOpen(int64_t durationUs) {
+    overlayOpenUs.store(durationUs, std::memory_order_relaxed);
+}
+
+void recordADLXStartup(int64_t dllLoadUs, int64_t initUs, int64_t gpuEnumerationUs, int64_t firstSampleUs) {
+    adlxStartupUs[0].store(dllLoadUs, std::memory_order_relaxed);
+    adlxStartupUs[1].store(initUs, std::memory_order_relaxed);
+    adlxStartupUs[2].store(gpuEnumerationUs, std::memory_order_relaxed);
+    adlxStartupUs[3].store(firstSampleUs, std::memory_order_relaxed);
+}
+
+#pragma endregion
+
+#pragma region Reporting
+
+uint64_t getAllocationCount() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+int64_t getLiveAllocationCount() {
+    return static_cast<int64_t>(allocationCount.load(std::memory_order_relaxed) - freeCount.load(std::memory_order_relaxed));
+}
+
+uint64_t getResidentBytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters = {};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.WorkingSetSize;
+    return 0;
+#else
+    long pages = 0;
+    if (std::FILE* statm = std::fopen("/proc/self/statm", "r")) {
+        long size = 0;
+        if (std::fscanf(statm, "%ld %ld", &size, &pages) != 2)
+            pages = 0;
+        std::fclose(statm);
+    }
+    return static_cast<uint64_t>(pages) * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+uint64_t getHandleCount() {
+#if defined(_WIN32)
+    DWORD handles = 0;
+    GetProcessHandleCount(GetCurrentProcess(), &handles);
+    return static_cast<uint64_t>(handles) + GetGuiResources(GetCurrentProcess(), GR_GDIOBJECTS) + GetGuiResources(GetCurrentProcess(), GR_USEROBJECTS);
+#else
+    // every entry but . and .. and the descriptor reading the directory
+    uint64_t entries = 0;
+    if (DIR* dir = opendir("/proc/self/fd")) {
+        while (readdir(dir))
+            entries++;
+        closedir(dir);
+    }
+    return entries > 3 ? entries - 3 : 0;
+#endif
+}
+
+// drain the counters accumulated since the last report
+SelfCostReport updateSelfCostReport() {
+    SelfCostReport report;
+
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - lastReportTime).count();
+    lastReportTime = now;
+    if (seconds <= 0.0)
+        seconds = 1.0;
+
+    // tick percentiles over the last tickWindow ticks
+    tickHistogram.reset();
+    uint64_t ticks = std::min(ticksRecorded.load(std::memory_order_acquire), tickWindow);
+    for (uint64_t i = 0; i < ticks; i++)
+        tickHistogram.record(recentTicksUs[i].load(std::memory_order_relaxed) * 1000);
+    report.tickP50Ms = tickHistogram.valueAtPercentile(50.0) / 1e6;
+    report.tickP99Ms = tickHistogram.valueAtPercentile(99.0) / 1e6;
+
+    uint64_t tickTotal = tickCount.exchange(0, std::memory_order_relaxed);
+    uint64_t calls = adlxCallCount.exchange(0, std::memory_order_relaxed);
+    report.adlxCallsPerTick = tickTotal > 0 ? static_cast<double>(calls) / tickTotal : 0.0;
+
+    uint64_t frames = frameCount.exchange(0, std::memory_order_relaxed);
+    uint64_t frameUs = frameTimeUs.exchange(0, std::memory_order_relaxed);
+    report.renderFrameMs = frames > 0 ? frameUs / 1000.0 / frames : 0.0;
+    report.framesPerSecond = frames / seconds;
+
+    uint64_t mainWindowFrames = mainWindowFrameCount.exchange(0, std::memory_order_relaxed);
+    uint64_t mainWindowUs = mainWindowFrameTimeUs.exchange(0, std::memory_order_relaxed);
+    report.mainWindowFrameMs = mainWindowFrames > 0 ? mainWindowUs / 1000.0 / mainWindowFrames : 0.0;
+    report.mainWindowFramesPerSecond = mainWindowFrames / seconds;
+
+    uint64_t allocations = getAllocationCount();
+    report.allocationsPerSecond = (allocations - lastAllocationCount) / seconds;
+    lastAllocationCount = allocations;
+
+    report.residentBytes = getResidentBytes();
+    report.overlayOpenMs = overlayOpenUs.load(std::memory_order_relaxed) / 1000.0;
+    report.adlxDllLoadMs = adlxStartupUs[0].load(std::memory_order_relaxed) / 1000.0;
+    report.adlxInitMs = adlxStartupUs[1].load(std::memory_order_relaxed) / 1000.0;
+    report.adlxGpuEnumerationMs = adlxStartupUs[2].load(std::memory_order_relaxed) / 1000.0;
+    report.adlxFirstSampleMs = adlxStartupUs[3].load(std::memory_order_relaxed) / 1000.0;
+    return report;
+}
+
+std::string formatSelfCostReport(const SelfCostReport& report) {
+    char buffer[320];
+    std::snprintf(buffer, sizeof(buffer),
+        "tick p50 %.2f ms  p99 %.2f ms  %.0f ADLX calls  open %.1f ms\n"
+        "frame %.2f ms  %.0f fps  main window %.2f ms  %.1f fps  %.0f allocs/s  RSS %.0f MB\n"
+        "ADLX start: dll %.1f ms  init %.1f ms  GPUs %.1f ms  sample %.1f ms",
+        report.tickP50Ms, report.tickP99Ms, report.adlxCallsPerTick, report.overlayOpenMs, report.renderFrameMs,
+        report.framesPerSecond, report.mainWindowFrameMs, report.mainWindowFramesPerSecond, report.allocationsPerSecond,
+        report.residentBytes / (1024.0 * 1024.0), report.adlxDllLoadMs, report.adlxInitMs, report.adlxGpuEnumerationMs,
+        report.adlxFirstSampleMs);
+    return buffer;
+}
+
+#pragma endregion
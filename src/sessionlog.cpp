@@ -0,0 +1,284 @@
+#include "../include/sessionlog.h"
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// binary files start with this, followed by a u32 version
+static const char binaryMagic[8] = { 'E', 'M', 'L', 'O', 'G', 0, 0, 0 };
+static const uint32_t binaryVersion = 1;
+
+// room for each csv field and its separator. fixed notation of huge values (or with a large precision)
+// does not fit, those are written in their shortest exact form, which always does
+const std::size_t csvFieldBytes = 40;
+
+static uint64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// function to force the file's data to disk
+static void syncFile(std::FILE* file) {
+    std::fflush(file);
+#if defined(_WIN32)
+    _commit(_fileno(file));
+#else
+    fsync(fileno(file));
+#endif
+}
+
+SessionLogger::~SessionLogger() {
+    close();
+}
+
+#pragma region Open and close
+
+bool SessionLogger::open(const std::string& path, const std::vector<std::string>& columns, const LogOptions& logOptions) {
+    close();
+    if (columns.size() > 64)
+        return false;
+
+#if defined(_WIN32)
+    if (fopen_s(&file, path.c_str(), "wb") != 0)
+        file = nullptr;
+#else
+    file = std::fopen(path.c_str(), "wb");
+#endif
+    if (!file) {
+        std::cout << "Failure: could not create " << path << std::endl;
+        return false;
+    }
+
+    options = logOptions;
+    columnCount = columns.size();
+
+    // header, written directly since nothing is queued yet
+    if (options.format == LogFormat::CSV) {
+        std::string header = "time_s";
+        for (const std::string& column : columns)
+            header += "," + column;
+        header += "\n";
+        std::fwrite(header.data(), 1, header.size(), file);
+        bytesWritten = header.size();
+    }
+    else if (options.format == LogFormat::Columnar)
+        bytesWritten = columnWriter.begin(file, columns, options.chunkRows);
+    else {
+        uint32_t count = static_cast<uint32_t>(columnCount);
+        std::fwrite(binaryMagic, 1, sizeof(binaryMagic), file);
+        std::fwrite(&binaryVersion, sizeof(binaryVersion), 1, file);
+        std::fwrite(&count, sizeof(count), 1, file);
+        bytesWritten = sizeof(binaryMagic) + sizeof(binaryVersion) + sizeof(count);
+        for (const std::string& column : columns) {
+            uint16_t length = static_cast<uint16_t>(column.size());
+            std::fwrite(&length, sizeof(length), 1, file);
+            std::fwrite(column.data(), 1, length, file);
+            bytesWritten += sizeof(length) + length;
+        }
+    }
+
+    // both blocks allocated up front, a block always has room for at least one row
+    std::size_t blockBytes = options.blockBytes > maxRowBytes() ? options.blockBytes : maxRowBytes();
+    front.assign(blockBytes, 0);
+    back.assign(blockBytes, 0);
+    frontUsed = backUsed = 0;
+    backFull = false;
+    stopping = false;
+    droppedRows = 0;
+    lastHandOffMs = nowMs();
+
+    writer = std::thread(&SessionLogger::writerLoop, this);
+    return true;
+}
+
+void SessionLogger::close() {
+    if (!file)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    writer.join();
+
+    // the writer has drained the back block, the front one goes out here
+    bytesWritten += writeBlock(front.data(), frontUsed);
+    frontUsed = 0;
+    if (options.format == LogFormat::Columnar)
+        bytesWritten += columnWriter.finish();
+
+    if (options.sync != SyncPolicy::Never)
+        syncFile(file);
+    std::fclose(file);
+    file = nullptr;
+}
+
+#pragma endregion
+
+#pragma region Producer
+
+std::size_t SessionLogger::maxRowBytes() const {
+    if (options.format == LogFormat::CSV)
+        return csvFieldBytes * (columnCount + 1) + 1;
+    return sizeof(double) + sizeof(uint64_t) + sizeof(float) * columnCount;
+}
+
+// write one csv number into its field, leaving the byte for the separator after it
+static char* writeCsvNumber(char* p, double value, int precision) {
+    char* fieldEnd = p + csvFieldBytes - 1;
+    std::to_chars_result result = std::to_chars(p, fieldEnd, value, std::chars_format::fixed, precision);
+    if (result.ec == std::errc())
+        return result.ptr;
+
+    // value_too_large, the shortest form that reads back exactly is at most 24 characters
+    result = std::to_chars(p, fieldEnd, value);
+    return result.ec == std::errc() ? result.ptr : p;
+}
+
+// binary rows store f32, a double beyond its range becomes an infinity rather than an undefined conversion
+static float toStoredFloat(double value) {
+    if (std::fabs(value) > std::numeric_limits<float>::max())
+        return value > 0 ? std::numeric_limits<float>::infinity() : -std::numeric_limits<float>::infinity();
+    return static_cast<float>(value);
+}
+
+// format one row into out, which has room for maxRowBytes()
+std::size_t SessionLogger::formatRow(char* out, double timeSeconds, const std::vector<std::optional<double>>& values) const {
+    char* p = out;
+    if (options.format == LogFormat::CSV) {
+        p = writeCsvNumber(p, timeSeconds, 3);
+        for (std::size_t i = 0; i < columnCount; i++) {
+            *p++ = ',';
+            if (i < values.size() && values[i].has_value())
+                p = writeCsvNumber(p, values[i].value(), options.precision);
+        }
+        *p++ = '\n';
+        return p - out;
+    }
+
+    uint64_t mask = 0;
+    for (std::size_t i = 0; i < columnCount && i < values.size(); i++)
+        if (values[i].has_value())
+            mask |= uint64_t(1) << i;
+
+    std::memcpy(p, &timeSeconds, sizeof(timeSeconds));
+    p += sizeof(timeSeconds);
+    std::memcpy(p, &mask, sizeof(mask));
+    p += sizeof(mask);
+    for (std::size_t i = 0; i < columnCount && i < values.size(); i++) {
+        if (values[i].has_value()) {
+            float value = toStoredFloat(values[i].value());
+            std::memcpy(p, &value, sizeof(value));
+            p += sizeof(value);
+        }
+    }
+    return p - out;
+}
+
+// swap the front block to the writer if it is free, called with the lock held
+void SessionLogger::handOff() {
+    if (backFull || frontUsed == 0)
+        return;
+
+    std::swap(front, back);
+    backUsed = frontUsed;
+    frontUsed = 0;
+    backFull = true;
+    lastHandOffMs = nowMs();
+    wake.notify_one();
+}
+
+void SessionLogger::append(double timeSeconds, const std::vector<std::optional<double>>& values) {
+    if (!file)
+        return;
+
+    bool full = front.size() - frontUsed < maxRowBytes();
+    bool due = options.flushIntervalMs > 0 && nowMs() - lastHandOffMs >= static_cast<uint64_t>(options.flushIntervalMs);
+    if (full || due) {
+        std::lock_guard<std::mutex> lock(mutex);
+        handOff();
+
+        // the writer still has the other block, drop the row rather than wait on the disk
+        if (front.size() - frontUsed < maxRowBytes()) {
+            droppedRows++;
+            return;
+        }
+    }
+
+    frontUsed += formatRow(front.data() + frontUsed, timeSeconds, values);
+}
+
+#pragma endregion
+
+#pragma region Writer
+
+void SessionLogger::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return backFull || stopping; });
+        if (!backFull)
+            break;
+
+        // write without the lock, the producer only needs it to hand over the next block
+        lock.unlock();
+        std::size_t written = writeBlock(back.data(), backUsed);
+        if (options.sync == SyncPolicy::EveryBlock)
+            syncFile(file);
+        else
+            std::fflush(file);
+        lock.lock();
+
+        bytesWritten += written;
+        backUsed = 0;
+        backFull = false;
+    }
+}
+
+// write a block of formatted rows, columnar rows are binary rows fed to the column writer
+std::size_t SessionLogger::writeBlock(const char* data, std::size_t bytes) {
+    if (options.format != LogFormat::Columnar) {
+        std::fwrite(data, 1, bytes, file);
+        return bytes;
+    }
+
+    std::size_t written = 0;
+    float values[64] = {};
+    const char* p = data;
+    const char* end = data + bytes;
+    while (p < end) {
+        double timeSeconds;
+        uint64_t mask;
+        std::memcpy(&timeSeconds, p, sizeof(timeSeconds));
+        p += sizeof(timeSeconds);
+        std::memcpy(&mask, p, sizeof(mask));
+        p += sizeof(mask);
+        for (std::size_t i = 0; i < columnCount; i++) {
+            if (mask & (uint64_t(1) << i)) {
+                std::memcpy(&values[i], p, sizeof(float));
+                p += sizeof(float);
+            }
+        }
+        written += columnWriter.append(timeSeconds, mask, values);
+    }
+    return written;
+}
+
+uint64_t SessionLogger::getDroppedRows() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return droppedRows;
+}
+
+uint64_t SessionLogger::getBytesWritten() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bytesWritten;
+}
+
+#pragma endregion
@@ -0,0 +1,327 @@
+#include "../include/sharedmetrics.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct SharedHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t columnCount;
+    uint32_t slotBytes;
+    uint32_t slotCount;
+    uint32_t dataOffset;
+    uint32_t writerRunning; // only accessed atomically
+    int64_t startUnixMs;
+    uint64_t published; // only accessed atomically
+};
+
+static const char sharedMagic[8] = { 'E', 'M', 'S', 'H', 'M', 0, 0, 0 };
+static const uint32_t sharedVersion = 1;
+const std::size_t namesOffset = 64;
+const std::size_t nameBytes = 64;
+const std::size_t slotHeaderBytes = 3 * sizeof(uint64_t);
+
+// a reader gives up on the newest sample after being lapped this many times in a row
+const int readAttempts = 8;
+
+static_assert(sizeof(SharedHeader) <= namesOffset, "shared header overlaps the column names");
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+    "shared memory atomics must be lock free to work across processes");
+
+static std::atomic<uint64_t>* atomic64At(const void* address) {
+    return reinterpret_cast<std::atomic<uint64_t>*>(const_cast<void*>(address));
+}
+
+static std::atomic<uint32_t>* atomic32At(const void* address) {
+    return reinterpret_cast<std::atomic<uint32_t>*>(const_cast<void*>(address));
+}
+
+// the os name of a segment
+static std::string segmentPath(const std::string& name) {
+#if defined(_WIN32)
+    return "Local\\" + name;
+#else
+    return "/" + name;
+#endif
+}
+
+#pragma region Writer
+
+SharedMetricsWriter::~SharedMetricsWriter() {
+    close();
+}
+
+bool SharedMetricsWriter::create(const std::string& name, const std::vector<std::string>& columns, std::size_t historySlots) {
+    close();
+    if (columns.size() > 64 || historySlots == 0)
+        return false;
+
+    columnCount = columns.size();
+    slotCount = historySlots;
+    slotBytes = (slotHeaderBytes + sizeof(float) * columnCount + 7) & ~std::size_t(7);
+    dataOffset = (namesOffset + nameBytes * columnCount + 63) & ~std::size_t(63);
+    mappedBytes = dataOffset + slotBytes * slotCount;
+    std::string path = segmentPath(name);
+
+#if defined(_WIN32)
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, static_cast<DWORD>(mappedBytes), path.c_str());
+    bool existed = mapping && GetLastError() == ERROR_ALREADY_EXISTS;
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0) : nullptr;
+    if (view && existed) {
+        // kept alive by readers of a previous run, taken over unless another instance is still publishing or it is too small
+        MEMORY_BASIC_INFORMATION info = {};
+        bool busy = std::memcmp(view, sharedMagic, sizeof(sharedMagic)) == 0 &&
+            atomic32At(static_cast<unsigned char*>(view) + offsetof(SharedHeader, writerRunning))->load(std::memory_order_acquire) != 0;
+        if (busy || !VirtualQuery(view, &info, sizeof(info)) || info.RegionSize < mappedBytes) {
+            UnmapViewOfFile(view);
+            view = nullptr;
+        }
+        else
+            std::memset(view, 0, sizeof(sharedMagic));
+    }
+    if (!view) {
+        std::cout << "Failure: could not create shared memory " << path << std::endl;
+        if (mapping)
+            CloseHandle(mapping);
+        return false;
+    }
+    mappingHandle = mapping;
+#else
+    // a segment left behind by a crashed writer is replaced, readers still mapping it see it as stale
+    shm_unlink(path.c_str());
+    int fd = shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    void* view = MAP_FAILED;
+    if (fd >= 0 && ftruncate(fd, static_cast<off_t>(mappedBytes)) == 0)
+        view = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (fd >= 0)
+        ::close(fd);
+    if (view == MAP_FAILED) {
+        std::cout << "Failure: could not create shared memory " << path << std::endl;
+        shm_unlink(path.c_str());
+        return false;
+    }
+#endif
+    base = static_cast<unsigned char*>(view);
+    segmentName = path;
+
+    for (std::size_t i = 0; i < columnCount; i++)
+        std::memcpy(base + namesOffset + nameBytes * i, columns[i].data(), columns[i].size() < nameBytes ? columns[i].size() : nameBytes - 1);
+
+    // everything but the magic, which goes in last so a reader never sees a half written header
+    SharedHeader header = {};
+    header.version = sharedVersion;
+    header.columnCount = static_cast<uint32_t>(columnCount);
+    header.slotBytes = static_cast<uint32_t>(slotBytes);
+    header.slotCount = static_cast<uint32_t>(slotCount);
+    header.dataOffset = static_cast<uint32_t>(dataOffset);
+    header.writerRunning = 1;
+    header.startUnixMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    std::memcpy(base, &header, sizeof(header));
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(base, sharedMagic, sizeof(sharedMagic));
+
+    published = 0;
+    return true;
+}
+
+void SharedMetricsWriter::close() {
+    if (!base)
+        return;
+
+    atomic32At(base + offsetof(SharedHeader, writerRunning))->store(0, std::memory_order_release);
+#if defined(_WIN32)
+    UnmapViewOfFile(base);
+    CloseHandle(static_cast<HANDLE>(mappingHandle));
+    mappingHandle = nullptr;
+#else
+    munmap(base, mappedBytes);
+    shm_unlink(segmentName.c_str());
+#endif
+    base = nullptr;
+}
+
+void SharedMetricsWriter::publish(double timeSeconds, const std::vector<std::optional<double>>& values) {
+    if (!base)
+        return;
+
+    uint64_t sequence = published + 1;
+    unsigned char* slot = base + dataOffset + ((sequence - 1) % slotCount) * slotBytes;
+    std::atomic<uint64_t>* seqlock = atomic64At(slot);
+
+    // odd while writing, readers that raced with it see the word change and retry
+    seqlock->store(2 * sequence - 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint64_t mask = 0;
+    float* columns = reinterpret_cast<float*>(slot + slotHeaderBytes);
+    for (std::size_t i = 0; i < columnCount; i++) {
+        bool present = i < values.size() && values[i].has_value();
+        if (present)
+            mask |= uint64_t(1) << i;
+        columns[i] = present ? static_cast<float>(values[i].value()) : 0.f;
+    }
+    std::memcpy(slot + sizeof(uint64_t), &timeSeconds, sizeof(timeSeconds));
+    std::memcpy(slot + 2 * sizeof(uint64_t), &mask, sizeof(mask));
+
+    seqlock->store(2 * sequence, std::memory_order_release);
+    atomic64At(base + offsetof(SharedHeader, published))->store(sequence, std::memory_order_release);
+    published = sequence;
+}
+
+#pragma endregion
+
+#pragma region Reader
+
+SharedMetricsReader::~SharedMetricsReader() {
+    close();
+}
+
+bool SharedMetricsReader::open(const std::string& name) {
+    close();
+    std::string path = segmentPath(name);
+
+#if defined(_WIN32)
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, path.c_str());
+    if (!mapping)
+        return false;
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    MEMORY_BASIC_INFORMATION info = {};
+    if (!view || !VirtualQuery(view, &info, sizeof(info))) {
+        if (view)
+            UnmapViewOfFile(view);
+        CloseHandle(mapping);
+        return false;
+    }
+    mappingHandle = mapping;
+    mappedBytes = info.RegionSize;
+#else
+    int fd = shm_open(path.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return false;
+    struct stat info = {};
+    void* view = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0)
+        view = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED)
+        return false;
+    mappedBytes = static_cast<std::size_t>(info.st_size);
+#endif
+    base = static_cast<const unsigned char*>(view);
+
+    // the magic goes in last, a header without it is still being written
+    SharedHeader header = {};
+    if (mappedBytes >= namesOffset)
+        std::memcpy(&header, base, sizeof(header));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (mappedBytes < namesOffset || std::memcmp(header.magic, sharedMagic, sizeof(sharedMagic)) != 0 || header.version != sharedVersion ||
+        header.columnCount > 64 || header.slotCount == 0 || header.slotBytes < slotHeaderBytes + sizeof(float) * header.columnCount ||
+        header.dataOffset < namesOffset + nameBytes * header.columnCount ||
+        header.dataOffset + uint64_t(header.slotBytes) * header.slotCount > mappedBytes) {
+        close();
+        return false;
+    }
+
+    columnCount = header.columnCount;
+    slotBytes = header.slotBytes;
+    slotCount = header.slotCount;
+    dataOffset = header.dataOffset;
+    for (std::size_t i = 0; i < columnCount; i++) {
+        const char* name = reinterpret_cast<const char*>(base + namesOffset + nameBytes * i);
+        columns.emplace_back(name, strnlen(name, nameBytes));
+    }
+    return true;
+}
+
+void SharedMetricsReader::close() {
+    if (base) {
+#if defined(_WIN32)
+        UnmapViewOfFile(base);
+        CloseHandle(static_cast<HANDLE>(mappingHandle));
+        mappingHandle = nullptr;
+#else
+        munmap(const_cast<unsigned char*>(base), mappedBytes);
+#endif
+    }
+    base = nullptr;
+    mappedBytes = 0;
+    columns.clear();
+}
+
+int64_t SharedMetricsReader::getStartUnixMs() const {
+    int64_t startUnixMs = 0;
+    if (base)
+        std::memcpy(&startUnixMs, base + offsetof(SharedHeader, startUnixMs), sizeof(startUnixMs));
+    return startUnixMs;
+}
+
+bool SharedMetricsReader::isWriterRunning() const {
+    return base && atomic32At(base + offsetof(SharedHeader, writerRunning))->load(std::memory_order_acquire) != 0;
+}
+
+uint64_t SharedMetricsReader::getSampleCount() const {
+    return base ? atomic64At(base + offsetof(SharedHeader, published))->load(std::memory_order_acquire) : 0;
+}
+
+// copy one sample out of its slot, false if the slot holds another sample or changed during the copy
+bool SharedMetricsReader::readSlot(uint64_t sequence, SharedSample& sample) const {
+    const unsigned char* slot = base + dataOffset + ((sequence - 1) % slotCount) * slotBytes;
+    std::atomic<uint64_t>* seqlock = atomic64At(slot);
+
+    uint64_t before = seqlock->load(std::memory_order_acquire);
+    if (before != 2 * sequence)
+        return false;
+
+    std::memcpy(&sample.time, slot + sizeof(uint64_t), sizeof(sample.time));
+    std::memcpy(&sample.mask, slot + 2 * sizeof(uint64_t), sizeof(sample.mask));
+    std::memcpy(sample.values.data(), slot + slotHeaderBytes, sizeof(float) * columnCount);
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    if (seqlock->load(std::memory_order_relaxed) != before)
+        return false;
+    sample.sequence = sequence;
+    return true;
+}
+
+bool SharedMetricsReader::readLatest(SharedSample& sample) const {
+    for (int attempt = 0; attempt < readAttempts; attempt++) {
+        uint64_t sequence = getSampleCount();
+        if (sequence == 0)
+            return false;
+        if (readSlot(sequence, sample))
+            return true;
+    }
+    return false;
+}
+
+uint64_t SharedMetricsReader::readSince(uint64_t afterSequence, std::vector<SharedSample>& samples) const {
+    uint64_t newest = getSampleCount();
+    if (newest <= afterSequence)
+        return 0;
+
+    // samples that already left the ring are missed
+    uint64_t oldest = newest > slotCount ? newest - slotCount + 1 : 1;
+    uint64_t first = afterSequence + 1 > oldest ? afterSequence + 1 : oldest;
+    uint64_t missed = first - (afterSequence + 1);
+
+    SharedSample sample;
+    for (uint64_t sequence = first; sequence <= newest; sequence++) {
+        if (readSlot(sequence, sample))
+            samples.push_back(sample);
+        else
+            missed++;
+    }
+    return missed;
+}
+
+#pragma endregion
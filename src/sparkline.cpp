@@ -0,0 +1,99 @@
+#include "../include/sparkline.h"
+#include <algorithm>
+
+Sparkline::Sparkline(std::size_t capacity, sf::Vector2f position, sf::Vector2f size, sf::Color color)
+    : capacity(std::max<std::size_t>(capacity, 2)),
+      samples(this->capacity, 0.f),
+      vertices(sf::PrimitiveType::LineStrip, sf::VertexBuffer::Usage::Stream),
+      useVertexBuffer(sf::VertexBuffer::isAvailable()),
+      position(position),
+      size(size),
+      color(color) {
+
+    // allocate the gpu buffer once, it is only patched from here on
+    if (useVertexBuffer)
+        useVertexBuffer = vertices.create(this->capacity * 2);
+
+    if (!useVertexBuffer)
+        fallbackVertices.resize(this->capacity * 2);
+}
+
+// add the newest sample to the ring and patch its two vertices
+void Sparkline::push(float value) {
+    samples[head] = value;
+    writeVertex(head, value);
+
+    head = (head + 1) % capacity;
+    if (count < capacity)
+        count++;
+
+    // recompute the vertical range over the ring (at most a couple hundred floats)
+    std::size_t oldest = (head + capacity - count) % capacity;
+    minValue = maxValue = samples[oldest];
+    for (std::size_t i = 1; i < count; i++) {
+        float v = samples[(oldest + i) % capacity];
+        minValue = std::min(minValue, v);
+        maxValue = std::max(maxValue, v);
+    }
+
+    // keep flat lines in the middle of the graph
+    if (maxValue - minValue < 1.f) {
+        minValue -= 0.5f;
+        maxValue += 0.5f;
+    }
+}
+
+void Sparkline::clear() {
+    head = 0;
+    count = 0;
+}
+
+void Sparkline::setPosition(sf::Vector2f pos) {
+    position = pos;
+}
+
+// colour is baked into the vertices, so recolour whatever is in the ring
+void Sparkline::setColor(sf::Color col) {
+    color = col;
+    std::size_t oldest = (head + capacity - count) % capacity;
+    for (std::size_t i = 0; i < count; i++) {
+        std::size_t slot = (oldest + i) % capacity;
+        writeVertex(slot, samples[slot]);
+    }
+}
+
+// write a sample at its slot and at its mirror slot + capacity
+void Sparkline::writeVertex(std::size_t slot, float value) {
+    // x is the slot index and y the raw value, scaling happens in draw()
+    sf::Vertex vertex{ sf::Vector2f(static_cast<float>(slot), value), color };
+    sf::Vertex mirror{ sf::Vector2f(static_cast<float>(slot + capacity), value), color };
+
+    if (useVertexBuffer) {
+        (void)vertices.update(&vertex, 1, static_cast<unsigned int>(slot));
+        (void)vertices.update(&mirror, 1, static_cast<unsigned int>(slot + capacity));
+    }
+    else {
+        fallbackVertices[slot] = vertex;
+        fallbackVertices[slot + capacity] = mirror;
+    }
+}
+
+void Sparkline::draw(sf::RenderTarget& target, sf::RenderStates states) const {
+    if (count < 2)
+        return;
+
+    // contiguous range holding the last count samples, oldest first
+    std::size_t first = (head + capacity - count) % capacity;
+    std::size_t newest = first + count - 1;
+
+    // map (slot, value) into the graph rect with the newest sample on the right edge
+    float dx = size.x / static_cast<float>(capacity - 1);
+    float dy = size.y / (maxValue - minValue);
+    states.transform.translate(sf::Vector2f(position.x + size.x - static_cast<float>(newest) * dx, position.y + size.y + minValue * dy));
+    states.transform.scale(sf::Vector2f(dx, -dy));
+
+    if (useVertexBuffer)
+        target.draw(vertices, first, count, states);
+    else
+        target.draw(&fallbackVertices[first], count, sf::PrimitiveType::LineStrip, states);
+}
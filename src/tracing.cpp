@@ -0,0 +1,173 @@
+#include "../include/tracing.h"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// spans kept per thread, the oldest are overwritten. 64k covers minutes of a 60 fps overlay
+const uint32_t traceRingSize = 1 << 16;
+
+std::atomic<bool> tracingEnabled = false;
+
+// one span in a ring. written by the owning thread only, every field atomic so a dump reading
+// a slot that is being overwritten sees old or new values rather than undefined behaviour
+struct TraceSlot {
+    std::atomic<const char*> name = nullptr;
+    std::atomic<int64_t> startNs = 0;
+    std::atomic<int64_t> durationNs = 0;
+};
+
+// single writer ring of one thread. kept after the thread exits so its spans can still be dumped,
+// until a new thread takes it over
+struct TraceRing {
+    std::unique_ptr<TraceSlot[]> slots = std::make_unique<TraceSlot[]>(traceRingSize);
+    std::atomic<uint64_t> written = 0; // spans ever appended, the next slot is written % traceRingSize
+    std::atomic<const char*> threadName = nullptr;
+    uint32_t threadId = 0;
+};
+
+// every ring ever created and the ones whose thread exited, only locked when a thread records its first span,
+// when it exits and while dumping. a ring is about 1.5 MB, so without reuse every overlay session would add one
+static std::mutex ringsMutex;
+static std::vector<std::unique_ptr<TraceRing>> rings;
+static std::vector<TraceRing*> freeRings;
+static uint32_t nextThreadId = 1;
+
+// hands the ring back when its thread exits
+struct ThreadRingOwner {
+    TraceRing* ring = nullptr;
+    ~ThreadRingOwner() {
+        if (!ring)
+            return;
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        freeRings.push_back(ring);
+    }
+};
+
+static thread_local ThreadRingOwner threadRing;
+static thread_local const char* pendingThreadName = nullptr;
+
+static TraceRing* getThreadRing() {
+    if (threadRing.ring)
+        return threadRing.ring;
+
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    TraceRing* ring;
+    if (!freeRings.empty()) {
+        // the exited thread's spans are dropped, dumps only read a ring under the lock so none is reading it now
+        ring = freeRings.back();
+        freeRings.pop_back();
+        ring->written.store(0, std::memory_order_relaxed);
+    }
+    else {
+        rings.push_back(std::make_unique<TraceRing>());
+        ring = rings.back().get();
+    }
+    ring->threadId = nextThreadId++;
+    ring->threadName.store(pendingThreadName, std::memory_order_relaxed);
+    threadRing.ring = ring;
+    return ring;
+}
+
+void recordTraceSpan(const char* name, int64_t startNs, int64_t endNs) {
+    TraceRing* ring = getThreadRing();
+    uint64_t index = ring->written.load(std::memory_order_relaxed);
+    TraceSlot& slot = ring->slots[index % traceRingSize];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.startNs.store(startNs, std::memory_order_relaxed);
+    slot.durationNs.store(endNs - startNs, std::memory_order_relaxed);
+    ring->written.store(index + 1, std::memory_order_release);
+}
+
+void setTraceThreadName(const char* name) {
+    // the ring is only created once the thread records, so threads that never trace cost nothing
+    pendingThreadName = name;
+    if (threadRing.ring)
+        threadRing.ring->threadName.store(name, std::memory_order_relaxed);
+}
+
+void setTracingEnabled(bool enabled) {
+    tracingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+// span names are literals or metric keys, escape anyway so the json always parses
+static void appendJsonString(std::string& out, const char* text) {
+    out += '"';
+    for (const char* c = text; *c; c++) {
+        if (*c == '"' || *c == '\\')
+            out += '\\';
+        if (static_cast<unsigned char>(*c) >= 0x20)
+            out += *c;
+    }
+    out += '"';
+}
+
+bool writeTraceFile(const std::string& path) {
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    char number[160];
+    bool first = true;
+    int64_t origin = INT64_MAX;
+
+    struct Span {
+        const char* name;
+        int64_t startNs;
+        int64_t durationNs;
+        uint32_t threadId;
+    };
+    std::vector<Span> spans;
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        for (const std::unique_ptr<TraceRing>& ring : rings) {
+            uint64_t end = ring->written.load(std::memory_order_acquire);
+            uint64_t begin = end > traceRingSize ? end - traceRingSize : 0;
+            for (uint64_t i = begin; i < end; i++) {
+                const TraceSlot& slot = ring->slots[i % traceRingSize];
+                spans.push_back({ slot.name.load(std::memory_order_relaxed), slot.startNs.load(std::memory_order_relaxed),
+                    slot.durationNs.load(std::memory_order_relaxed), ring->threadId });
+            }
+
+            // the owner kept appending while we copied, drop the slots it may have overwritten meanwhile,
+            // including the one it may be writing right now
+            uint64_t after = ring->written.load(std::memory_order_acquire) + 1;
+            uint64_t overwritten = after > traceRingSize ? std::min(end, after - traceRingSize) : 0;
+            if (overwritten > begin)
+                spans.erase(spans.end() - (end - begin), spans.end() - (end - overwritten));
+
+            const char* threadName = ring->threadName.load(std::memory_order_relaxed);
+            std::snprintf(number, sizeof(number), "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+                first ? "" : ",\n", ring->threadId);
+            json += number;
+            appendJsonString(json, threadName ? threadName : "thread");
+            json += "}}";
+            first = false;
+        }
+    }
+
+    for (const Span& span : spans)
+        origin = std::min(origin, span.startNs);
+    for (const Span& span : spans) {
+        if (!span.name)
+            continue;
+        json += first ? "" : ",\n";
+        first = false;
+        json += "{\"ph\":\"X\",\"pid\":1,\"name\":";
+        appendJsonString(json, span.name);
+        std::snprintf(number, sizeof(number), ",\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", span.threadId,
+            (span.startNs - origin) / 1000.0, span.durationNs / 1000.0);
+        json += number;
+    }
+    json += "\n]}\n";
+
+    std::FILE* file = nullptr;
+#if defined(_WIN32)
+    if (fopen_s(&file, path.c_str(), "wb") != 0)
+        file = nullptr;
+#else
+    file = std::fopen(path.c_str(), "wb");
+#endif
+    if (!file)
+        return false;
+    bool written = std::fwrite(json.data(), 1, json.size(), file) == json.size();
+    return std::fclose(file) == 0 && written;
+}
@@ -0,0 +1,149 @@
+// overlay controller stress test, meant to run under ThreadSanitizer (cmake -DEASYMETRICS_TSAN=ON).
+// the main thread publishes configs as fast as it can while a fake overlay thread loads one per frame, across many
+// start/stop cycles: stopped with stop(), with requestStop() and a wait, or closing on its own and reclaimed by start().
+// every field of a snapshot is derived from its version, so a torn or mixed up snapshot is caught
+#include "../include/overlaycontroller.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// what gets published for a version
+static OverlayConfig configFor(uint64_t version) {
+    OverlayConfig config;
+    config.selectedMetrics = static_cast<unsigned int>(version * 2654435761u);
+    config.overlayColor = { static_cast<float>(version % 256), 0.5f, 0.25f };
+    config.transparency = static_cast<float>(version % 100) / 100.0f;
+    config.textSize = 12 + static_cast<int>(version % 37);
+    config.showSparklines = version % 2 == 0;
+    config.sparklineSeconds = 30 + static_cast<int>(version % 91);
+    config.columns = 1 + static_cast<int>(version % 4);
+    return config;
+}
+
+static bool checkConfig(const OverlayConfig& config) {
+    // version 0 is the controller's default snapshot
+    return config.version == 0 ? config == OverlayConfig() : config == configFor(config.version);
+}
+
+struct OverlayStats {
+    uint64_t frames = 0;
+    uint64_t versionsSeen = 0;
+    uint64_t errors = 0;
+};
+
+// stands in for createOverlayWindow(): one snapshot per frame, keeping a few old ones alive the way a frame in flight does
+static void runFakeOverlay(OverlayController& controller, uint64_t closeAfterFrames, OverlayStats& stats) {
+    std::vector<std::shared_ptr<const OverlayConfig>> inFlight;
+    uint64_t drawnVersion = 0;
+    while (!controller.stopRequested() && (closeAfterFrames == 0 || stats.frames < closeAfterFrames)) {
+        std::shared_ptr<const OverlayConfig> config = controller.loadConfig();
+        if (!config || !checkConfig(*config) || config->version < drawnVersion)
+            stats.errors++;
+        else if (config->version != drawnVersion) {
+            drawnVersion = config->version;
+            stats.versionsSeen++;
+        }
+
+        inFlight.push_back(config);
+        if (inFlight.size() > 3)
+            inFlight.erase(inFlight.begin());
+        stats.frames++;
+        if (stats.frames % 64 == 0)
+            std::this_thread::yield();
+    }
+
+    // the snapshots kept must still be intact after newer ones were published
+    for (const std::shared_ptr<const OverlayConfig>& config : inFlight) {
+        if (!checkConfig(*config))
+            stats.errors++;
+    }
+}
+
+static void printUsage() {
+    std::cout << "usage: controllertorture [--cycles N] [--publishes N]\n"
+        << "  --cycles N      overlay start/stop cycles (default 50)\n"
+        << "  --publishes N   configs published per cycle (default 2000)\n";
+}
+
+int main(int argc, char** argv) {
+    int cycles = 50;
+    uint64_t publishes = 2000;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--cycles") && i + 1 < argc)
+            cycles = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--publishes") && i + 1 < argc)
+            publishes = std::max<uint64_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        else {
+            printUsage();
+            return 2;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    OverlayController controller;
+    uint64_t version = 0, errors = 0, frames = 0, versionsSeen = 0, selfClosed = 0;
+    for (int cycle = 0; cycle < cycles; cycle++) {
+        // every third overlay closes itself partway through the publishes
+        bool closesItself = cycle % 3 == 2;
+        OverlayStats stats;
+        if (!controller.start([&stats, closesItself](OverlayController& c) { runFakeOverlay(c, closesItself ? 500 : 0, stats); })) {
+            std::printf("cycle %d: start() refused after the previous overlay stopped\n", cycle);
+            errors++;
+            continue;
+        }
+
+        for (uint64_t i = 0; i < publishes; i++) {
+            controller.publishConfig(configFor(version + 1));
+            version++;
+            // let the overlay in between publishes on machines with few cores
+            if (i % 16 == 0)
+                std::this_thread::yield();
+
+            // a second overlay must never start while one is running
+            if (i == publishes / 2 && controller.isRunning() && controller.start([](OverlayController&) {})) {
+                std::printf("cycle %d: start() succeeded with an overlay running\n", cycle);
+                errors++;
+            }
+        }
+
+        // the newest snapshot carries the newest version
+        std::shared_ptr<const OverlayConfig> newest = controller.loadConfig();
+        if (newest->version != version || !checkConfig(*newest))
+            errors++;
+
+        if (closesItself) {
+            while (controller.isRunning())
+                std::this_thread::yield();
+            selfClosed++;
+        }
+        else if (cycle % 3 == 1) {
+            controller.requestStop();
+            while (controller.isRunning())
+                std::this_thread::yield();
+        }
+        else
+            controller.stop();
+
+        if (controller.isRunning())
+            errors++;
+        errors += stats.errors;
+        frames += stats.frames;
+        versionsSeen += stats.versionsSeen;
+    }
+    controller.stop();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%d cycles (%llu closed themselves), %llu publishes, %llu overlay frames, %llu versions seen, %llu errors in %.2f s\n",
+        cycles, static_cast<unsigned long long>(selfClosed), static_cast<unsigned long long>(version),
+        static_cast<unsigned long long>(frames), static_cast<unsigned long long>(versionsSeen),
+        static_cast<unsigned long long>(errors), seconds);
+    std::printf(errors == 0 ? "passed\n" : "FAILED\n");
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+// generates src/inter.cpp from the subset font made by tools/subsetfont.py:
+// the lz compressed otf, plus a pre-rasterized glyph atlas of the ui characters at the
+// common overlay sizes so opening the overlay needs no font parsing or rasterization
+#include "../include/glyphatlas.h"
+#include "../include/lz.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// text size 24 at 1080p, 1440p and 2160p, and the half size self-cost panel
+const int bakedSizes[] = { 12, 16, 24, 32, 48 };
+
+static void writeBytes(std::ostream& out, const std::vector<unsigned char>& bytes) {
+    char hex[8];
+    for (size_t i = 0; i < bytes.size(); i++) {
+        if (i % 12 == 0)
+            out << (i ? "\n  " : "  ");
+        std::snprintf(hex, sizeof(hex), "0x%02x", bytes[i]);
+        out << hex << (i + 1 < bytes.size() ? ", " : "");
+    }
+    out << "\n";
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "usage: fontbake <subset.otf> <inter.cpp>" << std::endl;
+        return 2;
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+    std::vector<unsigned char> otf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    std::string glyphTable;
+    std::string sizeTable;
+    std::vector<unsigned char> pixelsLz;
+    size_t glyphCount = 0;
+
+    for (int size : bakedSizes) {
+        GlyphAtlas atlas;
+        if (!rasterizeGlyphAtlas(otf.data(), otf.size(), size, atlas)) {
+            std::cerr << "Failed to load " << argv[1] << std::endl;
+            return 1;
+        }
+
+        size_t firstGlyph = glyphCount;
+        for (int cp : atlasCodePoints()) {
+            const AtlasGlyph& g = atlas.glyphs[cp];
+            glyphTable += "    { " + std::to_string(cp) + ", " + std::to_string(static_cast<int>(g.advance)) + ", "
+                + std::to_string(g.left) + ", " + std::to_string(g.top) + ", " + std::to_string(g.width) + ", "
+                + std::to_string(g.height) + ", " + std::to_string(g.x) + ", " + std::to_string(g.y) + " },\n";
+            glyphCount++;
+        }
+
+        std::vector<unsigned char> compressed = lzCompress(atlas.pixels.data(), atlas.pixels.size());
+        sizeTable += "    { " + std::to_string(size) + ", " + std::to_string(atlas.width) + ", " + std::to_string(atlas.height) + ", "
+            + std::to_string(firstGlyph) + ", " + std::to_string(glyphCount - firstGlyph) + ", "
+            + std::to_string(pixelsLz.size()) + ", " + std::to_string(compressed.size()) + " },\n";
+        pixelsLz.insert(pixelsLz.end(), compressed.begin(), compressed.end());
+
+        std::cout << "size " << size << ": " << atlas.width << "x" << atlas.height << " atlas, "
+            << atlas.pixels.size() << " -> " << compressed.size() << " bytes" << std::endl;
+    }
+
+    std::vector<unsigned char> otfLz = lzCompress(otf.data(), otf.size());
+    std::cout << "font: " << otf.size() << " -> " << otfLz.size() << " bytes" << std::endl;
+
+    std::ofstream out(argv[2], std::ios::binary);
+    out << "// generated by tools/fontbake, do not edit\n";
+    out << "#include \"../include/inter.h\"\n\n";
+    out << "const unsigned char Inter_UI_Regular_otf_lz[] = {\n";
+    writeBytes(out, otfLz);
+    out << "};\n";
+    out << "const unsigned int Inter_UI_Regular_otf_lz_len = " << otfLz.size() << ";\n";
+    out << "const unsigned int Inter_UI_Regular_otf_len = " << otf.size() << ";\n\n";
+
+    out << "const BakedFontSize bakedInterSizes[] = {\n" << sizeTable << "};\n";
+    out << "const int bakedInterSizeCount = " << std::size(bakedSizes) << ";\n\n";
+
+    out << "const BakedGlyph bakedInterGlyphs[] = {\n" << glyphTable << "};\n\n";
+
+    out << "const unsigned char bakedInterPixels_lz[] = {\n";
+    writeBytes(out, pixelsLz);
+    out << "};\n";
+
+    if (!out) {
+        std::cerr << "Failed to write " << argv[2] << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,149 @@
+// session logger against values at the edges of a double: 1e300, 1e16, nan, infinities, denormals and a csv
+// precision too large for fixed notation. each file is read back and checked field by field, exits non-zero
+// when a row is malformed or a value does not come back
+#include "../include/columnfile.h"
+#include "../include/sessionlog.h"
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+const double infinity = std::numeric_limits<double>::infinity();
+
+// every row has all of these, rotated by the row index so each lands in every column
+static const std::vector<std::optional<double>> extremes = {
+    1e300, -1e300, 1e16, -9.99e15, 1e38, std::numeric_limits<double>::max(), std::nan(""), infinity, -infinity,
+    std::numeric_limits<double>::denorm_min(), 123.456, std::nullopt
+};
+
+static std::vector<std::optional<double>> rowValues(std::size_t row) {
+    std::vector<std::optional<double>> values(extremes.size());
+    for (std::size_t c = 0; c < values.size(); c++)
+        values[c] = extremes[(c + row) % extremes.size()];
+    return values;
+}
+
+// a csv field read back: empty, nan, an infinity of the same sign, or within the written precision
+static bool csvFieldMatches(const std::optional<double>& expected, const char* field, const char* fieldEnd, int precision) {
+    if (!expected.has_value())
+        return field == fieldEnd;
+
+    double actual = 0.0;
+    std::from_chars_result result = std::from_chars(field, fieldEnd, actual);
+    if (result.ec != std::errc() || result.ptr != fieldEnd)
+        return false;
+    double value = expected.value();
+    if (std::isnan(value) || std::isinf(value))
+        return std::isnan(value) ? std::isnan(actual) : actual == value;
+    double tolerance = std::max(0.5 * std::pow(10.0, -precision), std::fabs(value) * 1e-14);
+    return std::fabs(actual - value) <= tolerance;
+}
+
+static bool checkCsv(const std::string& path, std::size_t rows, int precision) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+    std::vector<char> line(4096);
+    bool ok = std::fgets(line.data(), static_cast<int>(line.size()), file) != nullptr; // column names
+    std::size_t row = 0;
+    while (ok && std::fgets(line.data(), static_cast<int>(line.size()), file)) {
+        const char* p = line.data();
+        const char* lineEnd = p + std::strcspn(p, "\n");
+        const char* fieldEnd = static_cast<const char*>(std::memchr(p, ',', lineEnd - p));
+        double time = 0.0;
+        ok = fieldEnd && std::from_chars(p, fieldEnd, time).ptr == fieldEnd && std::fabs(time - static_cast<double>(row)) < 1e-3;
+
+        std::vector<std::optional<double>> expected = rowValues(row);
+        for (std::size_t c = 0; ok && c < expected.size(); c++) {
+            p = fieldEnd + 1;
+            fieldEnd = c + 1 < expected.size() ? static_cast<const char*>(std::memchr(p, ',', lineEnd - p)) : lineEnd;
+            ok = fieldEnd && csvFieldMatches(expected[c], p, fieldEnd, precision);
+        }
+        if (!ok)
+            std::printf("  row %zu: %.*s\n", row, static_cast<int>(lineEnd - line.data()), line.data());
+        row++;
+    }
+    std::fclose(file);
+    return ok && row == rows;
+}
+
+// columnar files hold f32: out of range values come back as infinities, nan as a gap
+static bool checkColumnar(const std::string& path, std::size_t rows) {
+    ColumnFileReader reader;
+    ColumnSlice slice;
+    std::vector<int> columnIds;
+    for (std::size_t c = 0; c < extremes.size(); c++)
+        columnIds.push_back(static_cast<int>(c));
+    if (!reader.open(path) || !reader.read(0.0, static_cast<double>(rows), columnIds, slice) || slice.times.size() != rows)
+        return false;
+
+    for (std::size_t row = 0; row < rows; row++) {
+        std::vector<std::optional<double>> expected = rowValues(row);
+        for (std::size_t c = 0; c < expected.size(); c++) {
+            float actual = slice.values[c][row];
+            double value = expected[c].value_or(std::nan(""));
+            bool ok = std::isnan(value) ? std::isnan(actual)
+                : std::fabs(value) > std::numeric_limits<float>::max() ? actual == (value > 0 ? infinity : -infinity)
+                : actual == static_cast<float>(value);
+            if (!ok) {
+                std::printf("  row %zu column %zu: wrote %g, read %g\n", row, c, value, actual);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main() {
+    const std::size_t rows = 5000;
+    std::vector<std::string> columns;
+    for (std::size_t c = 0; c < extremes.size(); c++)
+        columns.push_back("metric" + std::to_string(c));
+
+    struct Case {
+        const char* name;
+        const char* path;
+        LogFormat format;
+        int precision;
+    };
+    const Case cases[] = {
+        { "csv, 2 decimals", "logextremes.csv", LogFormat::CSV, 2 },
+        { "csv, 60 decimals", "logextremes-wide.csv", LogFormat::CSV, 60 },
+        { "binary", "logextremes.bin", LogFormat::Binary, 2 },
+        { "columnar", "logextremes.emc", LogFormat::Columnar, 2 },
+    };
+
+    int failures = 0;
+    for (const Case& c : cases) {
+        LogOptions options;
+        options.format = c.format;
+        options.precision = c.precision;
+        options.sync = SyncPolicy::Never;
+        options.flushIntervalMs = 0;
+        options.blockBytes = 4 * 1024 * 1024; // the whole session fits one block, nothing is dropped
+
+        SessionLogger logger;
+        bool ok = logger.open(c.path, columns, options);
+        for (std::size_t row = 0; ok && row < rows; row++)
+            logger.append(static_cast<double>(row), rowValues(row));
+        logger.close();
+
+        ok = ok && logger.getDroppedRows() == 0;
+        if (ok && c.format == LogFormat::CSV)
+            ok = checkCsv(c.path, rows, c.precision);
+        else if (ok && c.format == LogFormat::Columnar)
+            ok = checkColumnar(c.path, rows);
+        std::printf("%-20s %8zu rows %10llu bytes  %s\n", c.name, rows, static_cast<unsigned long long>(logger.getBytesWritten()),
+            ok ? "ok" : "FAILED");
+        if (!ok)
+            failures++;
+        std::remove(c.path);
+    }
+
+    std::printf(failures == 0 ? "all formats passed\n" : "%d formats FAILED\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,54 @@
+// reads a crash capture ring (easymetrics.ring, or easymetrics.prev.ring after a restart) back into csv,
+// oldest sample first. slots torn by a crash mid-write are skipped and counted
+#include "../include/ringcapture.h"
+#include <charconv>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv) {
+    if (argc != 2 && argc != 3) {
+        std::cerr << "usage: ringrecover <capture.ring> [out.csv]" << std::endl;
+        return 2;
+    }
+
+    RingContents contents;
+    if (!readRingFile(argv[1], contents))
+        return 1;
+
+    std::ofstream file;
+    if (argc == 3) {
+        file.open(argv[2], std::ios::binary);
+        if (!file) {
+            std::cerr << "could not create " << argv[2] << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = argc == 3 ? static_cast<std::ostream&>(file) : std::cout;
+
+    // same columns as a recorded session
+    out << "time_s";
+    for (const std::string& column : contents.columns)
+        out << "," << column;
+    out << "\n";
+
+    char buffer[64];
+    for (const RingRecord& record : contents.records) {
+        out.write(buffer, std::to_chars(buffer, buffer + sizeof(buffer), record.time, std::chars_format::fixed, 3).ptr - buffer);
+        for (const std::optional<double>& value : record.values) {
+            out << ",";
+            if (value.has_value())
+                out.write(buffer, std::to_chars(buffer, buffer + sizeof(buffer), value.value(), std::chars_format::fixed, 2).ptr - buffer);
+        }
+        out << "\n";
+    }
+
+    std::time_t start = static_cast<std::time_t>(contents.startUnixMs / 1000);
+    char started[32];
+    std::strftime(started, sizeof(started), "%Y-%m-%d %H:%M:%S", std::gmtime(&start));
+    std::cerr << "recovered " << contents.records.size() << " samples, skipped " << contents.skippedSlots
+        << " torn, capture started " << started << " UTC" << std::endl;
+    return 0;
+}
@@ -0,0 +1,56 @@
+// writes fake samples into a crash capture ring until it is killed, for testing recovery:
+//   ringwriter test.ring & sleep 2; kill -9 $!; ringrecover test.ring test.csv
+// every value is derived from the sample's sequence number, so the recovered csv can be checked line by line
+#include "../include/ringcapture.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: ringwriter <capture.ring> [--slots N] [--columns N] [--rate HZ]\n"
+            << "  --rate 0 (default) writes as fast as possible" << std::endl;
+        return 2;
+    }
+
+    std::size_t slots = 1800;
+    std::size_t columnCount = 16;
+    int rateHz = 0;
+    for (int i = 2; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--slots") && i + 1 < argc)
+            slots = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--columns") && i + 1 < argc)
+            columnCount = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--rate") && i + 1 < argc)
+            rateHz = std::atoi(argv[++i]);
+    }
+
+    std::vector<std::string> columns;
+    for (std::size_t i = 0; i < columnCount; i++)
+        columns.push_back("metric" + std::to_string(i));
+
+    RingCapture ring;
+    if (!ring.create(argv[1], columns, slots))
+        return 1;
+
+    std::vector<std::optional<double>> values(columnCount);
+    auto next = std::chrono::steady_clock::now();
+    for (uint64_t sequence = 1;; sequence++) {
+        // column i holds (sequence * 16 + i) mod 65536, every 5th column is missing on odd samples
+        for (std::size_t i = 0; i < columnCount; i++) {
+            if (i % 5 == 4 && sequence % 2)
+                values[i] = std::nullopt;
+            else
+                values[i] = static_cast<double>((sequence * 16 + i) % 65536);
+        }
+        ring.write(sequence * 0.001, values);
+
+        if (rateHz > 0) {
+            next += std::chrono::microseconds(1000000 / rateHz);
+            std::this_thread::sleep_until(next);
+        }
+    }
+}
@@ -0,0 +1,194 @@
+// shared memory publication torture test: one writer publishing as fast as it can while several readers in
+// other processes (threads on windows) hammer the newest sample and the history ring.
+// every value is derived from the sample's sequence number, so any torn or mixed up read is caught
+#include "../include/sharedmetrics.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// what the writer publishes for a sequence number
+static bool expectedPresent(uint64_t sequence, std::size_t column) {
+    return (sequence + column) % 7 != 0;
+}
+
+static float expectedValue(uint64_t sequence, std::size_t column) {
+    return static_cast<float>((sequence * 64 + column) % (1u << 24));
+}
+
+static bool checkSample(const SharedSample& sample, std::size_t columns) {
+    if (sample.time != sample.sequence * 0.001)
+        return false;
+    for (std::size_t i = 0; i < columns; i++) {
+        if (sample.has(i) != expectedPresent(sample.sequence, i))
+            return false;
+        if (sample.has(i) && sample.values[i] != expectedValue(sample.sequence, i))
+            return false;
+    }
+    return true;
+}
+
+// one reader, returns the number of errors seen
+static uint64_t runReader(int id, const std::string& name, std::size_t columns) {
+    SharedMetricsReader reader;
+    if (!reader.open(name) || reader.getColumns().size() != columns) {
+        std::printf("reader %d: could not open %s\n", id, name.c_str());
+        return 1;
+    }
+
+    uint64_t latestReads = 0, latestFailures = 0, historyReads = 0, missed = 0, errors = 0;
+    uint64_t lastLatest = 0, lastSeen = 0;
+    SharedSample sample;
+    std::vector<SharedSample> samples;
+    while (reader.isWriterRunning()) {
+        // the newest sample never goes backwards
+        if (reader.readLatest(sample)) {
+            latestReads++;
+            if (!checkSample(sample, columns) || sample.sequence < lastLatest)
+                errors++;
+            lastLatest = sample.sequence;
+        }
+        else if (reader.getSampleCount() > 0)
+            latestFailures++;
+
+        // everything since the last poll, in order
+        samples.clear();
+        missed += reader.readSince(lastSeen, samples);
+        for (const SharedSample& s : samples) {
+            if (!checkSample(s, columns) || s.sequence <= lastSeen)
+                errors++;
+            lastSeen = s.sequence;
+            historyReads++;
+        }
+    }
+
+    std::printf("reader %d: %llu latest reads, %llu lapped, %llu history reads, %llu missed, %llu errors\n", id,
+        static_cast<unsigned long long>(latestReads), static_cast<unsigned long long>(latestFailures),
+        static_cast<unsigned long long>(historyReads), static_cast<unsigned long long>(missed), static_cast<unsigned long long>(errors));
+    std::fflush(stdout);
+    return errors;
+}
+
+static void printUsage() {
+    std::cout << "usage: shmtorture [--readers N] [--seconds S] [--slots N] [--columns N] [--rate HZ]\n"
+        << "  --readers N   reader processes (default 4)\n"
+        << "  --seconds S   how long the writer publishes (default 5)\n"
+        << "  --slots N     history ring size (default 16, small so readers get lapped)\n"
+        << "  --columns N   metrics per sample (default 16)\n"
+        << "  --rate HZ     publish rate, 0 (default) as fast as possible\n";
+}
+
+int main(int argc, char** argv) {
+    int readers = 4;
+    double seconds = 5.0;
+    std::size_t slots = 16;
+    std::size_t columnCount = 16;
+    int rateHz = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--readers") && i + 1 < argc)
+            readers = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--seconds") && i + 1 < argc)
+            seconds = std::max(0.1, std::atof(argv[++i]));
+        else if (!std::strcmp(argv[i], "--slots") && i + 1 < argc)
+            slots = std::max<std::size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        else if (!std::strcmp(argv[i], "--columns") && i + 1 < argc)
+            columnCount = std::clamp<std::size_t>(std::strtoull(argv[++i], nullptr, 10), 1, 64);
+        else if (!std::strcmp(argv[i], "--rate") && i + 1 < argc)
+            rateHz = std::max(0, std::atoi(argv[++i]));
+        else {
+            printUsage();
+            return 2;
+        }
+    }
+
+    std::vector<std::string> columns;
+    for (std::size_t i = 0; i < columnCount; i++)
+        columns.push_back("metric" + std::to_string(i));
+
+#if defined(_WIN32)
+    std::string name = "easymetrics-torture-" + std::to_string(_getpid());
+#else
+    std::string name = "easymetrics-torture-" + std::to_string(getpid());
+#endif
+    SharedMetricsWriter writer;
+    if (!writer.create(name, columns, slots))
+        return 1;
+
+    // readers attach before the first sample
+#if defined(_WIN32)
+    std::atomic<uint64_t> readerErrors = 0;
+    std::vector<std::thread> threads;
+    for (int r = 0; r < readers; r++)
+        threads.emplace_back([&, r] { readerErrors += runReader(r, name, columnCount); });
+#else
+    std::fflush(stdout);
+    std::vector<pid_t> children;
+    for (int r = 0; r < readers; r++) {
+        pid_t pid = fork();
+        if (pid == 0)
+            _exit(runReader(r, name, columnCount) ? 1 : 0); // skip the writer's destructor in the child
+        children.push_back(pid);
+    }
+#endif
+
+    // publish, timing every call: the writer must never wait on a reader
+    std::vector<std::optional<double>> values(columnCount);
+    std::vector<double> publishNs;
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+    auto next = start;
+    uint64_t sequence = 0;
+    while (std::chrono::steady_clock::now() < end) {
+        sequence++;
+        for (std::size_t i = 0; i < columnCount; i++) {
+            if (expectedPresent(sequence, i))
+                values[i] = expectedValue(sequence, i);
+            else
+                values[i] = std::nullopt;
+        }
+
+        auto publishStart = std::chrono::steady_clock::now();
+        writer.publish(sequence * 0.001, values);
+        publishNs.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - publishStart).count());
+
+        if (rateHz > 0) {
+            next += std::chrono::microseconds(1000000 / rateHz);
+            std::this_thread::sleep_until(next);
+        }
+    }
+    writer.close();
+
+    bool failed = false;
+#if defined(_WIN32)
+    for (std::thread& thread : threads)
+        thread.join();
+    failed = readerErrors > 0;
+#else
+    for (pid_t child : children) {
+        int status = 0;
+        waitpid(child, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            failed = true;
+    }
+#endif
+
+    std::sort(publishNs.begin(), publishNs.end());
+    std::printf("writer: %llu samples, %.0f per second, publish p50 %.0f ns  p99 %.0f ns  max %.0f ns\n",
+        static_cast<unsigned long long>(sequence), sequence / seconds, publishNs[publishNs.size() / 2],
+        publishNs[std::min(publishNs.size() - 1, publishNs.size() * 99 / 100)], publishNs.back());
+    std::printf("%s\n", failed ? "FAILED" : "ok");
+    return failed ? 1 : 0;
+}
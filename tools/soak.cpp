@@ -0,0 +1,409 @@
+// long-duration soak test: the sampler reads the fake source at an accelerated rate, each sample standing in
+// for one second of a real session, and the overlay scene from createOverlayWindow() redraws every sample
+// offscreen and is rebuilt with a new config every simulated hour. resident memory, live allocations,
+// allocations per sample, handles and tick latency are recorded per window, and the run fails if any of them
+// keeps growing once warmed up. runs headless on linux (xvfb-run for the overlay part). without SFML the
+// overlay's config changes and font atlases are still soaked, only the drawing is left out
+#include "../include/fontcache.h"
+#include "../include/metricformat.h"
+#include "../include/metricsampler.h"
+#include "../include/metricsource.h"
+#include "../include/overlaycontroller.h"
+#include "../include/selfcost.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(EASYMETRICS_SOAK_OVERLAY)
+#include "../include/overlayscene.h"
+#endif
+
+// one simulated second per sample, as the app samples every sampleIntervalMs
+const double simulatedSecondsPerSample = sampleIntervalMs / 1000.0;
+
+struct SoakOptions {
+    double days = 7.0;
+    int intervalMs = 1;
+    uint64_t windowSamples = 3600; // one simulated hour
+    double warmupPercent = 10.0;
+    uint64_t configEverySamples = 3600;
+    bool overlay = true;
+    bool history = SamplerOptions().keepHistory; // the app keeps the graph history
+    bool publish = false;
+    int servePort = 0;
+    std::string record;
+    std::string output;
+    bool quiet = false;
+};
+
+// everything measured over one window
+struct SoakWindow {
+    double simulatedHours = 0.0;
+    double residentMB = 0.0;
+    double liveAllocations = 0.0;
+    double allocationsPerSample = 0.0;
+    double handles = 0.0;
+    double tickP99Us = 0.0; // sampler tick, from the self-cost counters
+    double frameP50Us = 0.0; // overlay update and render of one sample, or copying it without the overlay
+    double frameP99Us = 0.0;
+};
+
+// a series that must not grow: the median of the last quarter of the windows against the first quarter,
+// and the least squares slope over all of them, both past absolute + relative * start
+struct TrendCheck {
+    const char* name;
+    double SoakWindow::* field;
+    double absoluteTolerance;
+    double relativeTolerance;
+};
+
+static const TrendCheck trendChecks[] = {
+    { "resident MB", &SoakWindow::residentMB, 1.0, 0.02 },
+    { "live allocations", &SoakWindow::liveAllocations, 1000.0, 0.05 },
+    { "allocations/sample", &SoakWindow::allocationsPerSample, 0.5, 0.10 },
+    { "handles", &SoakWindow::handles, 2.0, 0.0 },
+    { "tick p99 us", &SoakWindow::tickP99Us, 50.0, 0.50 },
+    { "frame p50 us", &SoakWindow::frameP50Us, 50.0, 0.25 },
+    { "frame p99 us", &SoakWindow::frameP99Us, 100.0, 0.50 }
+};
+
+static std::atomic<bool> interrupted = false;
+
+static void onInterrupt(int) {
+    interrupted = true;
+}
+
+static double percentile(std::vector<double>& values, double fraction) {
+    if (values.empty())
+        return 0.0;
+    std::size_t index = std::min(values.size() - 1, static_cast<std::size_t>(values.size() * fraction));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+static double median(std::vector<double> values) {
+    return percentile(values, 0.5);
+}
+
+struct TrendResult {
+    double start = 0.0;
+    double end = 0.0;
+    double fittedGrowth = 0.0;
+    bool growing = false;
+};
+
+static TrendResult checkTrend(const std::vector<SoakWindow>& windows, const TrendCheck& check) {
+    TrendResult result;
+    std::size_t n = windows.size();
+    std::size_t quarter = std::max<std::size_t>(1, n / 4);
+
+    std::vector<double> first, last;
+    for (std::size_t i = 0; i < quarter; i++) {
+        first.push_back(windows[i].*check.field);
+        last.push_back(windows[n - quarter + i].*check.field);
+    }
+    result.start = median(first);
+    result.end = median(last);
+
+    double meanX = (n - 1) / 2.0;
+    double meanY = 0.0;
+    for (const SoakWindow& window : windows)
+        meanY += window.*check.field;
+    meanY /= n;
+    double covariance = 0.0, variance = 0.0;
+    for (std::size_t i = 0; i < n; i++) {
+        covariance += (i - meanX) * (windows[i].*check.field - meanY);
+        variance += (i - meanX) * (i - meanX);
+    }
+    result.fittedGrowth = variance > 0.0 ? covariance / variance * (n - 1) : 0.0;
+
+    double tolerance = check.absoluteTolerance + check.relativeTolerance * std::abs(result.start);
+    result.growing = result.end - result.start > tolerance && result.fittedGrowth > tolerance;
+    return result;
+}
+
+// the configs the soak cycles through, each a change the main window can publish: colour only (graphs kept),
+// a grid, a bigger font (everything rebuilt) and fewer metrics
+static OverlayConfig soakConfig(uint64_t index) {
+    OverlayConfig config;
+    config.version = index + 1;
+    config.selectedMetrics = 0xFFFF;
+    config.showSparklines = true;
+    switch (index % 5) {
+    case 1:
+        config.valueColor = { 0.2f, 0.8f, 1.0f };
+        break;
+    case 2:
+        config.columns = 2;
+        config.layoutMode = LayoutMode::Grid;
+        break;
+    case 3:
+        config.textSize = 28;
+        break;
+    case 4:
+        config.selectedMetrics = 0x0FFF;
+        config.showSparklines = false;
+        break;
+    }
+    return config;
+}
+
+static void printUsage() {
+    std::cout << "usage: soak [options]\n"
+        << "  --days D            simulated length, one sample per simulated second (default 7)\n"
+        << "  --interval MS       real time between samples (default 1, a week in about ten minutes)\n"
+        << "  --window N          samples per measurement window (default 3600, one simulated hour)\n"
+        << "  --warmup PCT        share of the windows ignored at the start (default 10)\n"
+        << "  --config-every N    samples between overlay config changes (default 3600)\n"
+        << "  --no-overlay        sampler and outputs only, without drawing the overlay\n"
+        << "  --no-history        drop the main window graph history, as headless runs do\n"
+        << "  --publish           also publish to shared memory\n"
+        << "  --serve PORT        also serve /metrics on 127.0.0.1:PORT\n"
+        << "  --record PATH       also record to PATH (.csv, .bin or .emc)\n"
+        << "  --output PATH       write every window as csv\n"
+        << "  --quiet             only print the verdict\n";
+}
+
+static bool parseArguments(int argc, char** argv, SoakOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--days") && i + 1 < argc)
+            options.days = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--interval") && i + 1 < argc)
+            options.intervalMs = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--window") && i + 1 < argc)
+            options.windowSamples = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--warmup") && i + 1 < argc)
+            options.warmupPercent = std::min(90.0, std::max(0.0, std::atof(argv[++i])));
+        else if (!std::strcmp(argv[i], "--config-every") && i + 1 < argc)
+            options.configEverySamples = std::max(0, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--no-overlay"))
+            options.overlay = false;
+        else if (!std::strcmp(argv[i], "--no-history"))
+            options.history = false;
+        else if (!std::strcmp(argv[i], "--publish"))
+            options.publish = true;
+        else if (!std::strcmp(argv[i], "--serve") && i + 1 < argc)
+            options.servePort = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--record") && i + 1 < argc)
+            options.record = argv[++i];
+        else if (!std::strcmp(argv[i], "--output") && i + 1 < argc)
+            options.output = argv[++i];
+        else if (!std::strcmp(argv[i], "--quiet"))
+            options.quiet = true;
+        else
+            return false;
+    }
+    return options.days > 0.0;
+}
+
+static LogFormat formatForPath(const std::string& path) {
+    std::size_t dot = path.rfind('.');
+    std::string extension = dot == std::string::npos ? "" : path.substr(dot);
+    if (extension == ".bin")
+        return LogFormat::Binary;
+    if (extension == ".emc")
+        return LogFormat::Columnar;
+    return LogFormat::CSV;
+}
+
+static bool writeWindows(const std::string& path, const std::vector<SoakWindow>& windows) {
+    std::FILE* file = nullptr;
+#if defined(_WIN32)
+    if (fopen_s(&file, path.c_str(), "wb") != 0)
+        file = nullptr;
+#else
+    file = std::fopen(path.c_str(), "wb");
+#endif
+    if (!file)
+        return false;
+    std::fprintf(file, "simulated_hours,resident_mb,live_allocations,allocations_per_sample,handles,tick_p99_us,frame_p50_us,frame_p99_us\n");
+    for (const SoakWindow& w : windows) {
+        std::fprintf(file, "%.2f,%.3f,%.0f,%.3f,%.0f,%.1f,%.1f,%.1f\n", w.simulatedHours, w.residentMB, w.liveAllocations,
+            w.allocationsPerSample, w.handles, w.tickP99Us, w.frameP50Us, w.frameP99Us);
+    }
+    return std::fclose(file) == 0;
+}
+
+int main(int argc, char** argv) {
+    SoakOptions options;
+    if (!parseArguments(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+#if !defined(EASYMETRICS_SOAK_OVERLAY)
+    if (options.overlay && !options.quiet)
+        std::cout << "built without SFML, soaking the overlay's config changes and font atlases without drawing" << std::endl;
+#endif
+
+    std::vector<std::string> columns = metricColumnNames();
+    if (!options.record.empty()) {
+        LogOptions logOptions;
+        logOptions.format = formatForPath(options.record);
+        if (!startRecording(options.record, columns, logOptions)) {
+            std::cout << "Failure: could not record to " << options.record << std::endl;
+            return 1;
+        }
+    }
+    if (options.servePort > 0 && !startMetricsEndpoint(static_cast<uint16_t>(options.servePort)))
+        return 1;
+    if (options.publish)
+        startMetricPublishing("easymetrics_soak", columns, 120);
+
+    std::signal(SIGINT, onInterrupt);
+    std::signal(SIGTERM, onInterrupt);
+
+    SamplerOptions samplerOptions;
+    samplerOptions.intervalMs = options.intervalMs;
+    samplerOptions.keepHistory = options.history;
+    startMetricSampling(fakeMetricSource(1), samplerOptions);
+
+    std::vector<std::optional<double>> values;
+    uint64_t drawnSample = 0;
+
+    // configs reach the overlay through the controller, as from the main window
+    OverlayController controller;
+    uint64_t configIndex = 0;
+    controller.publishConfig(soakConfig(configIndex));
+    std::shared_ptr<const OverlayConfig> config = controller.loadConfig();
+
+#if defined(EASYMETRICS_SOAK_OVERLAY)
+    // the overlay thread's loop from createOverlayWindow(), drawn into a texture instead of a window
+    std::string debugString;
+    std::unique_ptr<OverlayScene> scene;
+    sf::RenderTexture target;
+    if (options.overlay) {
+        scene = buildOverlayScene(*config, 1.0f, values, debugString);
+        if (!target.resize(sf::Vector2u(scene->layout.width, scene->layout.height))) {
+            std::cout << "Failure: could not create the offscreen target" << std::endl;
+            return 1;
+        }
+    }
+#else
+    // the font a rebuilt scene would load, the rest of the scene needs SFML
+    std::shared_ptr<const GlyphAtlas> atlas;
+    if (options.overlay)
+        atlas = acquireGlyphAtlas(config->textSize);
+#endif
+
+    uint64_t totalSamples = static_cast<uint64_t>(options.days * 86400.0 / simulatedSecondsPerSample);
+    std::vector<SoakWindow> windows;
+    std::vector<double> frameUs;
+    frameUs.reserve(options.windowSamples);
+    uint64_t windowStart = 0;
+    uint64_t windowAllocations = getAllocationCount();
+    updateSelfCostReport();
+    auto runStart = std::chrono::steady_clock::now();
+
+    if (!options.quiet)
+        std::printf("%9s %11s %10s %12s %8s %10s %10s %10s\n", "sim_hours", "resident_MB", "live_alloc", "allocs/smpl", "handles", "tick_p99", "frame_p50", "frame_p99");
+
+    while (!interrupted && drawnSample < totalSamples) {
+        uint64_t count = waitForSample(drawnSample, 1000);
+        if (count == drawnSample) {
+            if (isMetricSamplingStopped())
+                break;
+            continue;
+        }
+
+        auto frameStart = std::chrono::steady_clock::now();
+        drawnSample = copyLatestSample(values);
+        if (options.overlay && options.configEverySamples > 0 && drawnSample / options.configEverySamples != configIndex) {
+            configIndex = drawnSample / options.configEverySamples;
+            controller.publishConfig(soakConfig(configIndex));
+        }
+#if defined(EASYMETRICS_SOAK_OVERLAY)
+        if (options.overlay) {
+            // the newest config, applied the same way the overlay does
+            std::shared_ptr<const OverlayConfig> latest = controller.loadConfig();
+            if (latest->version != config->version) {
+                if (reconfigureOverlayScene(scene, *config, *latest, 1.0f, values, debugString)
+                    && target.getSize() != sf::Vector2u(scene->layout.width, scene->layout.height)) {
+                    if (!target.resize(sf::Vector2u(scene->layout.width, scene->layout.height)))
+                        std::cout << "Failure: could not resize the offscreen target" << std::endl;
+                }
+                config = latest;
+            }
+
+            updateOverlayScene(*scene, *config, values, debugString);
+            renderOverlayFrame(target, scene->labels, scene->values, scene->sparklines, nullptr);
+            target.display();
+        }
+#else
+        if (options.overlay) {
+            std::shared_ptr<const OverlayConfig> latest = controller.loadConfig();
+            if (latest->version != config->version) {
+                if (!sameOverlayLayout(*config, *latest))
+                    atlas = acquireGlyphAtlas(latest->textSize);
+                config = latest;
+            }
+        }
+#endif
+        frameUs.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - frameStart).count());
+
+        // close the window once it has seen enough samples, skipped ones included
+        if (drawnSample - windowStart < options.windowSamples)
+            continue;
+
+        SelfCostReport report = updateSelfCostReport();
+        uint64_t allocations = getAllocationCount();
+        SoakWindow window;
+        window.simulatedHours = drawnSample * simulatedSecondsPerSample / 3600.0;
+        window.residentMB = getResidentBytes() / (1024.0 * 1024.0);
+        window.liveAllocations = static_cast<double>(getLiveAllocationCount());
+        window.allocationsPerSample = static_cast<double>(allocations - windowAllocations) / (drawnSample - windowStart);
+        window.handles = static_cast<double>(getHandleCount());
+        window.tickP99Us = report.tickP99Ms * 1000.0;
+        window.frameP50Us = percentile(frameUs, 0.5);
+        window.frameP99Us = percentile(frameUs, 0.99);
+        windows.push_back(window);
+
+        if (!options.quiet) {
+            std::printf("%9.1f %11.2f %10.0f %12.2f %8.0f %10.1f %10.1f %10.1f\n", window.simulatedHours, window.residentMB, window.liveAllocations,
+                window.allocationsPerSample, window.handles, window.tickP99Us, window.frameP50Us, window.frameP99Us);
+            std::fflush(stdout);
+        }
+
+        frameUs.clear();
+        windowStart = drawnSample;
+        windowAllocations = getAllocationCount();
+    }
+
+    double realSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+#if defined(EASYMETRICS_SOAK_OVERLAY)
+    scene.reset();
+#else
+    atlas.reset();
+#endif
+    stopMetricSampling();
+
+    if (!options.output.empty() && !writeWindows(options.output, windows))
+        std::cout << "Failure: could not write " << options.output << std::endl;
+
+    // the first windows include font loading, allocator pools filling up and the like
+    std::size_t warmup = static_cast<std::size_t>(windows.size() * options.warmupPercent / 100.0);
+    std::vector<SoakWindow> steady(windows.begin() + std::min(warmup, windows.size()), windows.end());
+    std::printf("%llu samples (%.1f simulated days) in %.0f s, %zu windows, %zu after warmup\n", static_cast<unsigned long long>(drawnSample),
+        drawnSample * simulatedSecondsPerSample / 86400.0, realSeconds, windows.size(), steady.size());
+    if (steady.size() < 4) {
+        std::cout << "Failure: at least 4 windows after warmup are needed to see a trend" << std::endl;
+        return 1;
+    }
+
+    bool failed = false;
+    for (const TrendCheck& check : trendChecks) {
+        TrendResult trend = checkTrend(steady, check);
+        failed |= trend.growing;
+        std::printf("%-20s %12.2f -> %12.2f  fitted %+10.2f  %s\n", check.name, trend.start, trend.end, trend.fittedGrowth, trend.growing ? "GROWING" : "ok");
+    }
+    std::printf("%s\n", failed ? "FAILED" : "ok");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,136 @@
+// synthetic stutter traces through FrameTimeStats: steady frames, periodic spikes, bursts and the exact 1% / 0.1%
+// boundaries. each trace's lows are checked against the mean of the slowest frames computed by sorting the window,
+// exits non-zero when any of them is off by more than a bin
+#include "../include/framestats.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <numeric>
+#include <string>
+#include <vector>
+
+// one frame time, or one adlx history sample weighted by the frames it covers
+struct TraceFrame {
+    double frameTimeMs;
+    uint32_t frames;
+};
+
+struct Trace {
+    std::string name;
+    std::vector<TraceFrame> frames;
+};
+
+static void append(Trace& trace, int count, double frameTimeMs, uint32_t frames = 1) {
+    for (int i = 0; i < count; i++)
+        trace.frames.push_back({ frameTimeMs, frames });
+}
+
+// every period-th frame takes spikeMs instead of frameTimeMs
+static Trace periodicSpikes(const std::string& name, int count, double frameTimeMs, int period, double spikeMs) {
+    Trace trace{ name, {} };
+    for (int i = 1; i <= count; i++)
+        trace.frames.push_back({ i % period == 0 ? spikeMs : frameTimeMs, 1 });
+    return trace;
+}
+
+static std::vector<Trace> buildTraces() {
+    std::vector<Trace> traces;
+
+    Trace steady{ "steady 4 ms", {} };
+    append(steady, 2000, 4.0);
+    traces.push_back(steady);
+
+    // exactly 1% of the frames stutter, a 99th percentile lands on the last fast frame and misses all of them
+    traces.push_back(periodicSpikes("1% spikes, every 100th", 1000, 4.0, 100, 50.0));
+    traces.push_back(periodicSpikes("0.5% spikes, every 200th", 2000, 4.0, 200, 50.0));
+    traces.push_back(periodicSpikes("2% spikes, every 50th", 2000, 4.0, 50, 33.3));
+
+    Trace burst{ "1% in one burst", {} };
+    append(burst, 1000, 4.0);
+    append(burst, 20, 33.3);
+    append(burst, 980, 4.0);
+    traces.push_back(burst);
+
+    // a single hitch in 1000 frames is the whole 0.1% low and a tenth of the 1% low
+    Trace hitch{ "one 100 ms hitch in 1000", {} };
+    append(hitch, 500, 4.0);
+    append(hitch, 1, 100.0);
+    append(hitch, 499, 4.0);
+    traces.push_back(hitch);
+
+    Trace mixed{ "mixed 6-9 ms with hitches", {} };
+    for (int i = 0; i < 3000; i++)
+        mixed.frames.push_back({ 6.0 + (i * 7919 % 300) / 100.0 + (i % 997 == 0 ? 80.0 : 0.0), 1 });
+    traces.push_back(mixed);
+
+    // what updateFPSHistory feeds: one sample per second weighted by the frames it covers
+    Trace history{ "adlx history, one 20 fps second", {} };
+    append(history, 5, 1000.0 / 240.0, 240);
+    append(history, 1, 50.0, 20);
+    append(history, 4, 1000.0 / 240.0, 240);
+    traces.push_back(history);
+
+    // stutter older than the window has to leave the lows
+    Trace evicted{ "spikes evicted by the window", {} };
+    append(evicted, 100, 50.0);
+    append(evicted, 3000, 4.0);
+    traces.push_back(evicted);
+
+    return traces;
+}
+
+// mean of the slowest fraction of the frames still in the window, by expanding and sorting them
+static double referenceSlowestMeanMs(const std::vector<TraceFrame>& frames, const std::vector<int64_t>& timestamps,
+    double windowMs, double fraction) {
+    std::vector<double> window;
+    int64_t oldest = timestamps.back() - static_cast<int64_t>(windowMs);
+    for (size_t i = 0; i < frames.size(); i++) {
+        if (timestamps[i] >= oldest)
+            window.insert(window.end(), frames[i].frames, frames[i].frameTimeMs);
+    }
+    std::sort(window.begin(), window.end(), std::greater<double>());
+
+    size_t count = static_cast<size_t>(std::ceil(fraction * window.size() - 1e-9));
+    count = std::clamp<size_t>(count, 1, window.size());
+    return std::accumulate(window.begin(), window.begin() + count, 0.0) / count;
+}
+
+int main() {
+    const double windowMs = 10000.0;
+    const double binResolutionMs = 0.01;
+    // binned frame times are the middle of their bin, so the mean can be off by half a bin
+    const double toleranceMs = binResolutionMs;
+
+    int failures = 0;
+    std::printf("%-34s %8s %10s %10s %10s %10s %10s\n", "trace", "frames", "p99 fps", "1% low", "expected", "0.1% low", "expected");
+    for (const Trace& trace : buildTraces()) {
+        FrameTimeStats stats(windowMs, binResolutionMs);
+        std::vector<int64_t> timestamps;
+        double nowMs = 0.0;
+        for (const TraceFrame& frame : trace.frames) {
+            nowMs += frame.frameTimeMs * frame.frames;
+            timestamps.push_back(static_cast<int64_t>(nowMs));
+            stats.addSample(timestamps.back(), frame.frameTimeMs, frame.frames);
+        }
+
+        double onePercent = stats.getSlowestFramesMeanTime(0.01);
+        double pointOnePercent = stats.getSlowestFramesMeanTime(0.001);
+        double expectedOnePercent = referenceSlowestMeanMs(trace.frames, timestamps, windowMs, 0.01);
+        double expectedPointOnePercent = referenceSlowestMeanMs(trace.frames, timestamps, windowMs, 0.001);
+        bool ok = std::abs(onePercent - expectedOnePercent) <= toleranceMs
+            && std::abs(pointOnePercent - expectedPointOnePercent) <= toleranceMs
+            && std::abs(stats.getOnePercentLowFPS() - 1000.0 / onePercent) < 1e-9;
+        if (!ok)
+            failures++;
+
+        std::printf("%-34s %8llu %10.1f %10.1f %10.1f %10.1f %10.1f%s\n", trace.name.c_str(),
+            static_cast<unsigned long long>(stats.getFrameCount()), 1000.0 / stats.getPercentileFrameTime(0.99),
+            1000.0 / onePercent, 1000.0 / expectedOnePercent, 1000.0 / pointOnePercent, 1000.0 / expectedPointOnePercent,
+            ok ? "" : "  FAILED");
+    }
+
+    std::printf(failures == 0 ? "all traces passed\n" : "%d traces FAILED\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,28 @@
+# subset Inter to the characters easy metrics can show (basic latin + latin-1) and strip everything
+# freetype and imgui never read: hinting, opentype layout tables and most of the name table.
+# the result is fed to fontbake, which compresses it and bakes the overlay glyph atlas:
+#
+#   python tools/subsetfont.py res/Inter-UI-Regular.otf build/Inter-UI-Subset.otf
+#   fontbake build/Inter-UI-Subset.otf src/inter.cpp
+#
+# needs fontTools (pip install -r tools/requirements.txt)
+import sys
+from fontTools import subset
+from fontTools.ttLib import TTFont
+
+if len(sys.argv) != 3:
+    print("usage: subsetfont.py <input.otf> <output.otf>")
+    sys.exit(2)
+
+options = subset.Options()
+options.layout_features = []
+options.hinting = False
+options.desubroutinize = True  # larger otf but compresses better
+options.name_IDs = [1, 2]
+options.drop_tables += ["GDEF", "GPOS", "GSUB"]
+
+font = TTFont(sys.argv[1], recalcTimestamp=False)  # keep the output reproducible
+subsetter = subset.Subsetter(options)
+subsetter.populate(unicodes=list(range(0x20, 0x7F)) + list(range(0xA0, 0x100)))
+subsetter.subset(font)
+font.save(sys.argv[2])